@@ -128,11 +128,29 @@
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+/* Run time and task stats gathering related definitions. The run time stats
+ * are counted with a free running 32-bit TCPWM counter, see task_monitor.c.
+ */
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+#if (configGENERATE_RUN_TIME_STATS == 1)
+extern void task_monitor_runtime_counter_init( void );
+extern uint32_t task_monitor_runtime_counter_get( void );
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    task_monitor_runtime_counter_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()            task_monitor_runtime_counter_get()
+#endif
+
+/* Count pvPortMalloc()/vPortFree() calls and the bytes they hold for the
+ * heap telemetry in heap_usage.c. traceFREE() runs after the block is freed,
+ * so the freed bytes are taken off in a linker wrap of vPortFree() instead.
+ */
+extern void heap_usage_on_malloc( void *ptr );
+extern void heap_usage_on_free( void *ptr );
+#define traceMALLOC( pvAddress, uiSize )            heap_usage_on_malloc( pvAddress )
+#define traceFREE( pvAddress, uiSize )              heap_usage_on_free( pvAddress )
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         2
@@ -199,7 +217,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
@@ -79,4 +79,30 @@
  */
 #define MQTT_PINGRESP_TIMEOUT_MS                ( 5000U )
 
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+#include <stdint.h>
+
+/**
+ * @brief Longest time in milliseconds without sending a packet before coreMQTT
+ * sends a PINGREQ.
+ *
+ * coreMQTT pings after the keep-alive interval or this time, whichever is
+ * shorter, from MQTT_ProcessLoop. The adaptive keep-alive returns its learned
+ * interval here once the path has been idle in both directions, so the ping
+ * goes through coreMQTT under the lock of the MQTT library. See keep_alive.c.
+ */
+extern uint32_t keep_alive_get_ping_timeout_ms( void );
+#define PACKET_TX_TIMEOUT_MS                    ( keep_alive_get_ping_timeout_ms() )
+
+/**
+ * @brief Longest time in milliseconds without receiving a packet before
+ * coreMQTT sends a PINGREQ.
+ *
+ * Any packet sent already shows the path is open, so silence from the broker
+ * alone, normal for a client that only publishes at QoS 0, does not cause
+ * pings of its own.
+ */
+#define PACKET_RX_TIMEOUT_MS                    ( 65535U * 1000U )
+#endif /* ENABLE_ADAPTIVE_KEEP_ALIVE */
+
 #endif /* ifndef CORE_MQTT_CONFIG_H_ */
@@ -145,6 +145,28 @@
  * Uncomment to use your own hardware entropy collector.
  */
 #define MBEDTLS_ENTROPY_HARDWARE_ALT
+
+/**
+ * \def MBEDTLS_PLATFORM_MEMORY
+ *
+ * Route mbedtls_calloc()/mbedtls_free() through tls_memory.c. What mbedTLS
+ * allocates while a connection is set up (SSL record buffers, certificates,
+ * handshake state) comes from a fixed region that is reset when that
+ * connection is torn down, so reconnects cannot fragment the system heap.
+ * Other allocations stay on the heap. Size the arena with
+ * TLS_MEMORY_ARENA_SIZE.
+ *
+ * Comment these macros to allocate from the C library heap again.
+ */
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_PLATFORM_CALLOC_MACRO   tls_memory_calloc
+#define MBEDTLS_PLATFORM_FREE_MACRO     tls_memory_free
+
+#if defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+#include <stddef.h>
+void *tls_memory_calloc(size_t nmemb, size_t size);
+void tls_memory_free(void *ptr);
+#endif
 /**
  * \def MBEDTLS_ECP_DP_SECP192R1_ENABLED
  *
@@ -156,8 +178,10 @@
 #undef MBEDTLS_ECP_DP_SECP192R1_ENABLED
 #undef MBEDTLS_ECP_DP_SECP224R1_ENABLED
 //#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
-#undef MBEDTLS_ECP_DP_SECP384R1_ENABLED
-#undef MBEDTLS_ECP_DP_SECP521R1_ENABLED
+/* P-384 and P-521 stay enabled so that device keys on these curves, which
+ * the OPTIGA(TM) Trust M can sign with, can be used for TLS. */
+//#define MBEDTLS_ECP_DP_SECP384R1_ENABLED
+//#define MBEDTLS_ECP_DP_SECP521R1_ENABLED
 #undef MBEDTLS_ECP_DP_SECP192K1_ENABLED
 #undef MBEDTLS_ECP_DP_SECP224K1_ENABLED
 #undef MBEDTLS_ECP_DP_SECP256K1_ENABLED
@@ -945,4 +969,35 @@
  */
 #define MBEDTLS_DEPRECATED_REMOVED
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Resize the SSL record buffers to the negotiated maximum fragment length
+ * once the handshake is done, and back to full size when a new handshake
+ * starts. Together with the fragment length the MQTT connection requests
+ * (MQTT_TLS_MAX_FRAG_LEN_CODE) this releases most of the input buffer for the
+ * lifetime of that connection, since MQTT traffic rarely exceeds a few hundred
+ * bytes per record. Connections that request no fragment length keep full
+ * size buffers.
+ *
+ * Requires: MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+ */
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
+/**
+ * \def MBEDTLS_SSL_IN_CONTENT_LEN / MBEDTLS_SSL_OUT_CONTENT_LEN
+ *
+ * Size the incoming and outgoing record buffers separately. The input buffer
+ * stays at the 16KB the protocol allows unless the server accepts a maximum
+ * fragment length. The output buffer only has to hold the largest record this
+ * client sends (its certificate during the handshake); mbedtls_ssl_write()
+ * splits larger MQTT packets into several records.
+ */
+#ifndef MBEDTLS_SSL_IN_CONTENT_LEN
+#define MBEDTLS_SSL_IN_CONTENT_LEN      16384
+#endif
+#ifndef MBEDTLS_SSL_OUT_CONTENT_LEN
+#define MBEDTLS_SSL_OUT_CONTENT_LEN     4096
+#endif
+
 #endif /* MBEDTLS_USER_CONFIG_HEADER */
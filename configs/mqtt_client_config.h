@@ -89,12 +89,84 @@
     #define MQTT_WILL_MESSAGE             ("MQTT client unexpectedly disconnected!")
 #endif
 
+/* Set this macro to 1 to publish the per-task CPU share and stack usage
+ * measured by the task monitor as a compact binary summary (see
+ * task_monitor_encode_summary()) after every monitor interval, else 0.
+ */
+#define ENABLE_DIAGNOSTICS_PUBLISH        ( 0 )
+#if ENABLE_DIAGNOSTICS_PUBLISH
+    #define MQTT_DIAG_TOPIC               MQTT_PUB_TOPIC "/diag"
+#endif
+
+/* Set this macro to 1 to compress published telemetry (see lz_compress.h)
+ * when that makes it smaller, else 0. A compressed message is published on
+ * its topic with MQTT_COMPRESSED_TOPIC_SUFFIX appended, so subscribers can
+ * tell it apart. Payloads below MQTT_COMPRESS_MIN_SIZE bytes, such as the
+ * device control messages, are always sent as they are.
+ */
+#define ENABLE_PAYLOAD_COMPRESSION        ( 0 )
+#if ENABLE_PAYLOAD_COMPRESSION
+    #define MQTT_COMPRESSED_TOPIC_SUFFIX  "/lz"
+    #define MQTT_COMPRESS_MIN_SIZE        ( 32 )
+#endif
+
 /* MQTT messages which are published on the MQTT_PUB_TOPIC that controls the
  * device (user LED in this example) state in this code example.
  */
 #define MQTT_DEVICE_ON_MESSAGE            "TURN ON"
 #define MQTT_DEVICE_OFF_MESSAGE           "TURN OFF"
 
+/* Set this macro to 1 to publish the device state as a CBOR record (see
+ * device_state_record_t in subscriber_task.h) instead of the messages above,
+ * else 0. The subscriber then expects records as well.
+ */
+#define ENABLE_CBOR_PAYLOAD               ( 0 )
+
+/* Set this macro to 1 to measure the time from a button press to the
+ * completion of its publish, split into stages (see latency_histogram.h),
+ * else 0. With ENABLE_DIAGNOSTICS_PUBLISH the histograms are published on
+ * MQTT_LATENCY_TOPIC after every monitor interval. Define
+ * PRINT_LATENCY_HISTOGRAM to print them after every press.
+ */
+#define ENABLE_LATENCY_HISTOGRAM          ( 0 )
+#if ENABLE_LATENCY_HISTOGRAM && ENABLE_DIAGNOSTICS_PUBLISH
+    #define MQTT_LATENCY_TOPIC            MQTT_PUB_TOPIC "/latency"
+#endif
+
+/* Set this macro to 1 to run the publish benchmark once connected (see
+ * publish_benchmark.h), else 0. It publishes on MQTT_BENCHMARK_TOPIC at the
+ * rates, QoS levels, payload and batch sizes in PUBLISH_BENCHMARK_RUNS and
+ * prints one JSON line per run. Needs ENABLE_LATENCY_HISTOGRAM. Runs on the
+ * target only.
+ */
+#define ENABLE_PUBLISH_BENCHMARK          ( 0 )
+#if ENABLE_PUBLISH_BENCHMARK
+    #define MQTT_BENCHMARK_TOPIC          MQTT_PUB_TOPIC "/benchmark"
+#endif
+
+/* Set this macro to 1 to measure the cost of reconnecting once connected
+ * (see handshake_benchmark.h), else 0. The client disconnects and
+ * reconnects HANDSHAKE_BENCHMARK_ITERATIONS times and prints the connection
+ * and TLS handshake times, the handshake bytes and the I2C traffic to the
+ * OPTIGA(TM) Trust M of each attempt as JSON lines.
+ */
+#define ENABLE_HANDSHAKE_BENCHMARK        ( 0 )
+
+/* Set this macro to 1 to check and time the PKCS#11 module at startup,
+ * before TLS uses it (see pkcs11_benchmark.h), else 0. The results, calls
+ * per second and I2C transfers per call of each entry point, are printed as
+ * JSON lines.
+ */
+#define ENABLE_PKCS11_BENCHMARK           ( 0 )
+
+/* Set this macro to 1 to serve the MQTT client, subscriber and publisher
+ * queues from the MQTT client task through one FreeRTOS queue set instead of
+ * running three tasks, else 0. The publisher and subscriber handlers then run
+ * on the MQTT client task stack. Needs configUSE_QUEUE_SETS set to 1 in
+ * FreeRTOSConfig.h.
+ */
+#define ENABLE_SINGLE_TASK_REACTOR        ( 0 )
+
 
 /******************* OTHER MQTT CLIENT CONFIGURATION MACROS *******************/
 /* A unique client identifier to be used for every MQTT connection. */
@@ -106,11 +178,22 @@
 /* The keep-alive interval in seconds used for MQTT ping request. */
 #define MQTT_KEEP_ALIVE_SECONDS           ( 60 )
 
+/* Set ENABLE_ADAPTIVE_KEEP_ALIVE to 1 in the Makefile to learn how long the
+ * network path to the broker stays open without traffic and ping just inside
+ * that (see keep_alive.h), instead of every MQTT_KEEP_ALIVE_SECONDS. Traffic
+ * in either direction counts as liveness. It is set for the whole build as
+ * the MQTT library's core_mqtt_config.h depends on it too.
+ */
+#ifndef ENABLE_ADAPTIVE_KEEP_ALIVE
+#define ENABLE_ADAPTIVE_KEEP_ALIVE        ( 0 )
+#endif
+
 /* Every active MQTT connection must have a unique client identifier. If you 
  * are using the above 'MQTT_CLIENT_IDENTIFIER' as client ID for multiple MQTT 
  * connections simultaneously, set this macro to 1. The device will then
- * generate a unique client identifier by appending a timestamp to the 
- * 'MQTT_CLIENT_IDENTIFIER' string. Example: 'psoc6-mqtt-client5927'
+ * generate a unique client identifier by appending a random number drawn from
+ * the entropy pool to the 'MQTT_CLIENT_IDENTIFIER' string.
+ * Example: 'psoc6-mqtt-client5927'
  */
 #define GENERATE_UNIQUE_CLIENT_ID         ( 1 )
 
@@ -147,6 +230,14 @@
  */
 #define MQTT_SNI_HOSTNAME                 "MY_MQTT_BROKER_ADDRESS"
 
+/* TLS Maximum Fragment Length the MQTT connection asks the broker for, as an
+ * MBEDTLS_SSL_MAX_FRAG_LEN_* code: 1 for 512, 2 for 1024, 3 for 2048 and 4 for
+ * 4096 bytes. If the broker accepts it, the TLS record buffers shrink to that
+ * size after the handshake. Set to 0 to not request a fragment length. Other
+ * TLS connections on the device are not affected.
+ */
+#define MQTT_TLS_MAX_FRAG_LEN_CODE        ( 4 )
+
 /* A Network buffer is allocated for sending and receiving MQTT packets over 
  * the network. Specify the size of this buffer using this macro.
  * 
@@ -162,6 +253,12 @@
 /* MQTT re-connection time interval in milliseconds. */
 #define MQTT_CONN_RETRY_INTERVAL_MS      (2000)
 
+/* Upper bound in milliseconds of the random jitter added to every MQTT 
+ * re-connection interval. The jitter keeps a fleet of devices that lost the
+ * broker at the same time from reconnecting in lockstep. Set to 0 to disable.
+ */
+#define MQTT_CONN_RETRY_JITTER_MS        (1000u)
+
 
 /**************** MQTT CLIENT CERTIFICATE CONFIGURATION MACROS ****************/
 
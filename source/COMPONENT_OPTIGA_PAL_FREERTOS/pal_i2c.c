@@ -70,6 +70,7 @@ _STATIC_H const pal_i2c_t * gp_pal_i2c_current_ctx;
 _STATIC_H uint8_t g_pal_i2c_init_flag = 0;
 _STATIC_H TaskHandle_t i2c_taskhandle = NULL;
 _STATIC_H SemaphoreHandle_t xIicSemaphoreHandle;
+_STATIC_H pal_i2c_stats_t g_pal_i2c_stats;
 
 /*******************************************************************************
  * Function Definitions
@@ -109,6 +110,8 @@ static void i2c_task(void *pvParameters)
     
     if (0UL != (CYHAL_I2C_MASTER_ERR_EVENT & event))
     {
+        g_pal_i2c_stats.errors++;
+
         /* In case of error abort transfer */
         cyhal_i2c_abort_async(((pal_psoc_i2c_t *)(gp_pal_i2c_current_ctx->p_i2c_hw_config))->i2c_master_channel);
         upper_layer_handler(gp_pal_i2c_current_ctx->p_upper_layer_ctx, PAL_I2C_EVENT_ERROR);
@@ -254,6 +257,8 @@ pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, ui
         }
         else
         {
+            g_pal_i2c_stats.writes++;
+            g_pal_i2c_stats.bytes += length;
             status = PAL_STATUS_SUCCESS;
         }
     }
@@ -294,6 +299,8 @@ pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uin
         }
         else
         {
+            g_pal_i2c_stats.reads++;
+            g_pal_i2c_stats.bytes += length;
             status = PAL_STATUS_SUCCESS;
         }
     }
@@ -307,6 +314,14 @@ pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uin
     return (status);
 }
 
+void pal_i2c_get_stats(pal_i2c_stats_t * p_stats)
+{
+    if (NULL != p_stats)
+    {
+        *p_stats = g_pal_i2c_stats;
+    }
+}
+
 pal_status_t pal_i2c_set_bitrate(const pal_i2c_t * p_i2c_context, uint16_t bitrate)
 {
 
@@ -47,6 +47,11 @@
 
 #include "include/pal/pal_logger.h"
 
+#ifdef DEVELOPER_MODE_LOGGER
+#include "FreeRTOS.h"
+#include "semphr.h"
+#endif
+
 /*******************************************************************************
  * Macros
  ******************************************************************************/
@@ -57,6 +62,8 @@
 #define DATA_BITS_8     8
 #define STOP_BITS_1     1
 #define PAL_LOGGER_UART_INTR_PRIO    (5U)
+// Upper bound for one UART transfer; 1 KB takes about 90 ms at 115200 baud
+#define PAL_LOGGER_TIMEOUT_MS        (1000U)
 #endif
 /// @cond hidden
 
@@ -74,7 +81,8 @@ pal_logger_t logger_console =
 #ifdef DEVELOPER_MODE_LOGGER
 cyhal_uart_t pal_logger_uart_obj;
 uint8_t cy_hal_uart_event_status = CYHAL_UART_IRQ_NONE;
-volatile bool event_status_busy = true;
+// Given by the UART event handler, so the caller blocks instead of spinning
+static SemaphoreHandle_t pal_logger_event_semaphore = NULL;
 
 /*******************************************************************************
  * Function Definitions
@@ -82,7 +90,8 @@ volatile bool event_status_busy = true;
 // Event handler callback function
 static void pal_logger_uart_event_handler(void* handler_arg, cyhal_uart_event_t event)
 {
-    event_status_busy = false;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
     if ((event & CYHAL_UART_IRQ_TX_DONE) == CYHAL_UART_IRQ_TX_DONE)
     {
         // All Tx data has been transmitted
@@ -103,12 +112,21 @@ static void pal_logger_uart_event_handler(void* handler_arg, cyhal_uart_event_t
         // Receive error
         cy_hal_uart_event_status = CYHAL_UART_IRQ_RX_ERROR;
     }
+
+    xSemaphoreGiveFromISR(pal_logger_event_semaphore, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 static void pal_logger_uart_rst_events(void)
 {
     cy_hal_uart_event_status = CYHAL_UART_IRQ_NONE;
-    event_status_busy = true;
+    // Drop an event left over from an earlier transfer
+    (void)xSemaphoreTake(pal_logger_event_semaphore, 0);
+}
+
+static bool pal_logger_uart_wait_event(void)
+{
+    return (pdTRUE == xSemaphoreTake(pal_logger_event_semaphore, pdMS_TO_TICKS(PAL_LOGGER_TIMEOUT_MS)));
 }
 
 #endif
@@ -129,6 +147,15 @@ pal_status_t pal_logger_init(void * p_logger_context)
 
     do
     {
+            if (NULL == pal_logger_event_semaphore)
+            {
+                pal_logger_event_semaphore = xSemaphoreCreateBinary();
+                if (NULL == pal_logger_event_semaphore)
+                {
+                    break;
+                }
+            }
+
             // Initialize the UART configuration structure
             cyhal_uart_cfg_t uart_config =
             {
@@ -197,7 +224,11 @@ pal_status_t pal_logger_write(void * p_logger_context, const uint8_t * p_log_dat
                break;
         }
 
-        while(event_status_busy);
+        if(!pal_logger_uart_wait_event())
+        {
+            (void)cyhal_uart_write_abort(&pal_logger_uart_obj);
+            break;
+        }
 
         if(CYHAL_UART_IRQ_TX_ERROR == cy_hal_uart_event_status)
         {
@@ -230,7 +261,8 @@ pal_status_t pal_logger_read(void * p_logger_context, uint8_t * p_log_data, uint
                break;
         }
 
-        while(event_status_busy);
+        // A read waits for the user, so it has no timeout
+        (void)xSemaphoreTake(pal_logger_event_semaphore, portMAX_DELAY);
 
         if(CYHAL_UART_IRQ_RX_ERROR == cy_hal_uart_event_status)
         {
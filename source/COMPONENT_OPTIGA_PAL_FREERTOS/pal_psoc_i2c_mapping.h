@@ -60,6 +60,20 @@ typedef struct pal_psoc_i2c
     cyhal_gpio_t      scl;
 }   pal_psoc_i2c_t;
 
+/**
+ * \brief Counters of the I2C transfers with the secure element, accumulated
+ * since boot. Take a snapshot before and after an operation to get its cost.
+ */
+typedef struct pal_i2c_stats
+{
+    uint32_t          writes;
+    uint32_t          reads;
+    uint32_t          bytes;
+    uint32_t          errors;     /* Failed transfers, e.g. NACKs while the chip is busy */
+}   pal_i2c_stats_t;
+
+void pal_i2c_get_stats(pal_i2c_stats_t * p_stats);
+
 
 #ifdef __cplusplus
 }
@@ -56,6 +56,10 @@
 #include <string.h>
 #include <time.h>
 #include <mbedtls/platform_time.h>
+#include <mbedtls/platform.h>
+#include "entropy_pool.h"
+#include "tls_memory.h"
+#include "cy_tls_ext.h"
 
 #ifdef COMPONENT_4390X
 extern cy_rslt_t cy_prng_get_random( void* buffer, uint32_t buffer_length );
@@ -75,6 +79,8 @@ extern cy_rslt_t cy_prng_get_random( void* buffer, uint32_t buffer_length );
 #include <core_pkcs11_config.h>
 #include <core_pkcs11.h>
 #include <core_pki_utils.h>
+#include <mbedtls/ecdsa.h>
+#include "pkcs11_optiga_trustm.h"
 #endif
 
 #ifdef ENABLE_SECURE_SOCKETS_LOGS
@@ -87,6 +93,33 @@ extern cy_rslt_t cy_prng_get_random( void* buffer, uint32_t buffer_length );
 #define MBEDTLS_VERBOSE 0
 #endif
 
+/* Upper bound for the TLS handshake when cy_tls_connect() is called without a
+ * timeout. The handshake used to loop without any limit.
+ */
+#ifndef CY_TLS_HANDSHAKE_TIMEOUT_MS
+#define CY_TLS_HANDSHAKE_TIMEOUT_MS (30000)
+#endif
+
+/* Time to yield when mbedTLS reports WANT_READ/WANT_WRITE and the socket
+ * cannot be polled, or when an operation is in progress in the crypto layer.
+ * Otherwise the loops wait on the socket, see cy_tls_wait_ready().
+ */
+#ifndef CY_TLS_RETRY_DELAY_MS
+#define CY_TLS_RETRY_DELAY_MS       (5)
+#endif
+
+/* Optional restrictions of what the client offers, to compare the cost of
+ * handshakes: CY_TLS_CIPHERSUITES as a comma separated list of
+ * MBEDTLS_TLS_* ciphersuite ids, CY_TLS_CURVES as one of MBEDTLS_ECP_DP_*
+ * group ids, both in order of preference. Unset, the mbedTLS defaults apply.
+ */
+#ifdef CY_TLS_CIPHERSUITES
+static const int cy_tls_ciphersuites[] = { CY_TLS_CIPHERSUITES, 0 };
+#endif
+#ifdef CY_TLS_CURVES
+static const mbedtls_ecp_group_id cy_tls_curves[] = { CY_TLS_CURVES, MBEDTLS_ECP_DP_NONE };
+#endif
+
 #if defined CY_SECURE_SOCKETS_PKCS_SUPPORT && defined CY_TFM_PSA_SUPPORTED
 #if MBEDTLS_VERSION_NUMBER != TFM_MBEDTLS_VERSION_NUMBER
 #error "MBEDTLS version mismatch between secure core and non-secure core implementation. Please refer tfm_mbedtls_version.h present inside trusted-firmware-m library and version.h in mbedtls library"
@@ -123,6 +156,10 @@ typedef struct cy_tls_context_mbedtls
     uint32_t                    alpn_protocols_count;
     bool                        tls_handshake_successful;
 
+    /* Bytes on the wire during the handshake, see cy_tls_get_handshake_stats() */
+    uint32_t                    handshake_bytes_sent;
+    uint32_t                    handshake_bytes_received;
+
     cy_network_send_t           cy_tls_network_send;
     cy_network_recv_t           cy_tls_network_recv;
     void                       *caller_context;
@@ -135,8 +172,6 @@ typedef struct cy_tls_context_mbedtls
     /* mbedTLS specific members */
     mbedtls_ssl_context         ssl_ctx;
     mbedtls_ssl_config          ssl_config;
-    mbedtls_entropy_context     entropy;
-    mbedtls_ctr_drbg_context    ctr_drbg;
 
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
     mbedtls_x509_crt            *cert_x509ca;
@@ -161,6 +196,19 @@ static int init_ref_count = 0;
 
 static mbedtls_x509_crt_profile *custom_cert_profile = NULL;
 
+/* Send path counters, see cy_tls_get_send_stats() */
+static cy_tls_send_stats_t send_stats;
+
+/* Handshake counters, see cy_tls_get_handshake_stats() */
+static cy_tls_handshake_stats_t handshake_stats;
+
+/* See cy_tls_set_wait_callback() */
+static cy_tls_wait_t wait_callback = NULL;
+
+/* Fragment length requested by one task, see cy_tls_set_task_mfl_code() */
+static cy_thread_t mfl_request_task = NULL;
+static unsigned char mfl_request_code = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
 static CK_RV cy_tls_initialize_client_credentials(cy_tls_context_mbedtls_t* context);
 #endif
@@ -331,6 +379,11 @@ static int cy_tls_internal_send(void *context, const unsigned char *buffer, size
     result =  tls_ctx->cy_tls_network_send(tls_ctx->caller_context, buffer, length, &bytes_sent);
     if(result == CY_RSLT_SUCCESS)
     {
+        send_stats.wire_bytes += bytes_sent;
+        if(!tls_ctx->tls_handshake_successful)
+        {
+            tls_ctx->handshake_bytes_sent += bytes_sent;
+        }
         return bytes_sent;
     }
     else if(result == CY_RSLT_MODULE_TLS_TIMEOUT)
@@ -377,6 +430,10 @@ static int cy_tls_internal_recv(void *context, unsigned char *buffer, size_t len
     result =  ctx->cy_tls_network_recv(ctx->caller_context, buffer, length, &bytes_received);
     if(result == CY_RSLT_SUCCESS)
     {
+        if(!ctx->tls_handshake_successful)
+        {
+            ctx->handshake_bytes_received += bytes_received;
+        }
         return bytes_received;
     }
     else if(result == CY_RSLT_MODULE_TLS_TIMEOUT)
@@ -398,6 +455,28 @@ static int cy_tls_internal_recv(void *context, unsigned char *buffer, size_t len
     return -1;
 }
 /*-----------------------------------------------------------*/
+/* Records the outcome of a handshake that started at 'start'. */
+static void cy_tls_record_handshake(cy_tls_context_mbedtls_t *ctx, cy_time_t start, bool success)
+{
+    cy_time_t now;
+
+    cy_rtos_get_time(&now);
+
+    handshake_stats.last_duration_ms = (uint32_t)(now - start);
+    handshake_stats.last_bytes_sent = ctx->handshake_bytes_sent;
+    handshake_stats.last_bytes_received = ctx->handshake_bytes_received;
+    if(success)
+    {
+        handshake_stats.handshakes++;
+        handshake_stats.last_ciphersuite = (uint16_t)ctx->ssl_ctx.session->ciphersuite;
+    }
+    else
+    {
+        handshake_stats.failures++;
+        handshake_stats.last_ciphersuite = 0;
+    }
+}
+/*-----------------------------------------------------------*/
 static cy_rslt_t cy_tls_internal_release_root_ca_certificates(mbedtls_x509_crt* root_ca_certs)
 {
     if(root_ca_certs == NULL)
@@ -406,7 +485,7 @@ static cy_rslt_t cy_tls_internal_release_root_ca_certificates(mbedtls_x509_crt*
     }
 
     mbedtls_x509_crt_free(root_ca_certs);
-    free(root_ca_certs);
+    mbedtls_free(root_ca_certs);
 
     return CY_RSLT_SUCCESS;
 }
@@ -422,7 +501,7 @@ static cy_rslt_t cy_tls_internal_load_root_ca_certificates(mbedtls_x509_crt** ro
 
     cy_tls_internal_release_root_ca_certificates(*root_ca_certs);
 
-    *root_ca_certs = malloc(sizeof(mbedtls_x509_crt));
+    *root_ca_certs = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
     if(*root_ca_certs == NULL)
     {
         return CY_RSLT_MODULE_TLS_OUT_OF_HEAP_SPACE;
@@ -436,7 +515,7 @@ static cy_rslt_t cy_tls_internal_load_root_ca_certificates(mbedtls_x509_crt** ro
     {
         tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_x509_crt_parse failed 0x%x\r\n", -result);
         mbedtls_x509_crt_free(*root_ca_certs);
-        free(*root_ca_certs);
+        mbedtls_free(*root_ca_certs);
         *root_ca_certs = NULL;
         return CY_RSLT_MODULE_TLS_PARSE_CERTIFICATE;
     }
@@ -664,6 +743,33 @@ cy_rslt_t cy_tls_delete_identity(void *tls_identity )
     return CY_RSLT_SUCCESS;
 }
 /*-----------------------------------------------------------*/
+void cy_tls_set_wait_callback(cy_tls_wait_t wait)
+{
+    wait_callback = wait;
+}
+/*-----------------------------------------------------------*/
+void cy_tls_set_task_mfl_code(unsigned char mfl_code)
+{
+    cy_thread_t self;
+
+    cy_rtos_get_thread_handle(&self);
+
+    /* Only the requesting task reads the code, so setting it before the task
+     * and clearing the task first keeps other tasks from ever seeing a
+     * mismatched pair.
+     */
+    if(mfl_code != MBEDTLS_SSL_MAX_FRAG_LEN_NONE)
+    {
+        mfl_request_task = NULL;
+        mfl_request_code = mfl_code;
+        mfl_request_task = self;
+    }
+    else if(mfl_request_task == self)
+    {
+        mfl_request_task = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
 cy_rslt_t cy_tls_create_context(void **context, cy_tls_params_t *params)
 {
     cy_tls_context_mbedtls_t *ctx = NULL;
@@ -694,6 +800,16 @@ cy_rslt_t cy_tls_create_context(void **context, cy_tls_params_t *params)
     ctx->auth_mode = params->auth_mode;
     ctx->alpn_list = params->alpn_list;
     ctx->mfl_code  = params->mfl_code;
+    if(ctx->mfl_code == MBEDTLS_SSL_MAX_FRAG_LEN_NONE)
+    {
+        cy_thread_t self;
+
+        cy_rtos_get_thread_handle(&self);
+        if((mfl_request_task != NULL) && (mfl_request_task == self))
+        {
+            ctx->mfl_code = mfl_request_code;
+        }
+    }
     ctx->hostname  = params->hostname;
 
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
@@ -744,6 +860,7 @@ static int cy_tls_sign_with_private_key(void* context, mbedtls_md_type_t xMdAlg,
     cy_tls_context_mbedtls_t* tls_context = (cy_tls_context_mbedtls_t*) context;
     CK_MECHANISM xMech = {0};
     CK_BYTE xToBeSigned[256];
+    CK_BYTE_PTR pxToBeSigned = xToBeSigned;
     CK_ULONG xToBeSignedLen = sizeof(xToBeSigned);
 
     if(context == NULL)
@@ -783,8 +900,17 @@ static int cy_tls_sign_with_private_key(void* context, mbedtls_md_type_t xMdAlg,
     }
     else if(tls_context->pkcs_context.key_type == CKK_EC)
     {
+#ifdef CKM_OPTIGA_ECDSA_DER
+        /* The secure element signs the hash as is and the module returns the
+         * DER signature mbedTLS expects, written straight into its buffer.
+         * Works for every curve the secure element supports.
+         */
+        xMech.mechanism = CKM_OPTIGA_ECDSA_DER;
+        pxToBeSigned = (CK_BYTE_PTR) hash;
+#else
         xMech.mechanism = CKM_ECDSA;
         memcpy(xToBeSigned, hash, hash_len);
+#endif
         xToBeSignedLen = hash_len;
     }
     else
@@ -801,7 +927,13 @@ static int cy_tls_sign_with_private_key(void* context, mbedtls_md_type_t xMdAlg,
     }
 
     *pxSigLen = sizeof( xToBeSigned );
-    result = tls_context->pkcs_context.functionlist->C_Sign((CK_SESSION_HANDLE)tls_context->pkcs_context.session, xToBeSigned,
+#ifdef CKM_OPTIGA_ECDSA_DER
+    if(xMech.mechanism == CKM_OPTIGA_ECDSA_DER)
+    {
+        *pxSigLen = MBEDTLS_ECDSA_MAX_LEN;
+    }
+#endif
+    result = tls_context->pkcs_context.functionlist->C_Sign((CK_SESSION_HANDLE)tls_context->pkcs_context.session, pxToBeSigned,
                                                       xToBeSignedLen, pucSig, (CK_ULONG_PTR) pxSigLen);
     if(result != CKR_OK)
     {
@@ -809,7 +941,7 @@ static int cy_tls_sign_with_private_key(void* context, mbedtls_md_type_t xMdAlg,
         return -1;
     }
 
-    if(tls_context->pkcs_context.key_type == CKK_EC)
+    if(xMech.mechanism == CKM_ECDSA)
     {
         /* PKCS #11 for P256 returns a 64-byte signature with 32 bytes for R and 32 bytes for S.
          * This must be converted to an ASN.1 encoded array. */
@@ -862,7 +994,7 @@ static CK_RV cy_tls_read_certificate(cy_tls_context_mbedtls_t* context, char *la
     }
 
     /* Create a buffer for the certificate. */
-    xTemplate.pValue = malloc(xTemplate.ulValueLen);
+    xTemplate.pValue = mbedtls_calloc(1, xTemplate.ulValueLen);
     if(xTemplate.pValue == NULL)
     {
         tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "PKCS : Failed to create buffer for the certificate \r\n");
@@ -877,11 +1009,11 @@ static CK_RV cy_tls_read_certificate(cy_tls_context_mbedtls_t* context, char *la
         goto cleanup;
     }
 
-    /* Decode the certificate. */
-    mbedtls_result = mbedtls_x509_crt_parse(cert_context, (const unsigned char*) xTemplate.pValue, xTemplate.ulValueLen);
+    /* Decode the certificate. The PKCS#11 module returns DER, so skip the PEM detection. */
+    mbedtls_result = mbedtls_x509_crt_parse_der(cert_context, (const unsigned char*) xTemplate.pValue, xTemplate.ulValueLen);
     if(mbedtls_result != 0)
     {
-        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_x509_crt_parse failed to parse certificate : 0x%x \r\n", mbedtls_result);
+        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_x509_crt_parse_der failed to parse certificate : 0x%x \r\n", mbedtls_result);
         result = CKR_GENERAL_ERROR;
         goto cleanup;
     }
@@ -890,7 +1022,7 @@ cleanup:
     /* Free memory. */
     if(xTemplate.pValue != NULL)
     {
-        free(xTemplate.pValue);
+        mbedtls_free(xTemplate.pValue);
     }
 
     return result;
@@ -1006,21 +1138,109 @@ static void mbedtls_debug_logs( void *ctx, int level,
 #endif
 
 /*-----------------------------------------------------------*/
-cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_t timeout)
+/*
+ * Returns true once 'timeout' milliseconds have elapsed since 'start'. A
+ * timeout of zero never expires.
+ */
+static bool cy_tls_timeout_expired(cy_time_t start, uint32_t timeout)
+{
+    cy_time_t now;
+
+    if(timeout == 0)
+    {
+        return false;
+    }
+
+    cy_rtos_get_time(&now);
+    return ((uint32_t)(now - start) >= timeout);
+}
+/*-----------------------------------------------------------*/
+/*
+ * Blocks until the transport is ready for what mbedTLS asked for in 'ret',
+ * readable on WANT_READ and writable on WANT_WRITE, or until what is left of
+ * 'timeout' since 'start' has expired. Waiting is left to the callback set
+ * with cy_tls_set_wait_callback(), which knows what the caller context of a
+ * TLS context is. Returns at once if mbedTLS still holds unprocessed input,
+ * and yields for CY_TLS_RETRY_DELAY_MS when there is no callback, it fails
+ * or the crypto layer is busy.
+ */
+static void cy_tls_wait_ready(cy_tls_context_mbedtls_t *ctx, int ret, cy_time_t start, uint32_t timeout)
+{
+    cy_tls_wait_t wait = wait_callback;
+    uint32_t remaining = 0;
+    cy_time_t now;
+
+    if((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE))
+    {
+        cy_rtos_delay_milliseconds(CY_TLS_RETRY_DELAY_MS);
+        return;
+    }
+
+    if((ret == MBEDTLS_ERR_SSL_WANT_READ) && (mbedtls_ssl_check_pending(&ctx->ssl_ctx) != 0))
+    {
+        return;
+    }
+
+    if(timeout != 0)
+    {
+        cy_rtos_get_time(&now);
+        if((uint32_t)(now - start) >= timeout)
+        {
+            return;
+        }
+        remaining = timeout - (uint32_t)(now - start);
+    }
+
+    if((wait == NULL) ||
+       (wait(ctx->caller_context, (ret == MBEDTLS_ERR_SSL_WANT_WRITE), remaining) != CY_RSLT_SUCCESS))
+    {
+        cy_rtos_delay_milliseconds(CY_TLS_RETRY_DELAY_MS);
+    }
+}
+/*-----------------------------------------------------------*/
+/*
+ * Logs the RAM held by a connection: the context itself, the current size of
+ * the record buffers and everything mbedTLS has allocated from the TLS arena.
+ */
+static void cy_tls_report_resident_ram(cy_tls_context_mbedtls_t *ctx, const char *stage)
+{
+#ifdef ENABLE_SECURE_SOCKETS_LOGS
+    tls_memory_stats_t stats;
+    size_t in_buf_len = MBEDTLS_SSL_IN_CONTENT_LEN;
+    size_t out_buf_len = MBEDTLS_SSL_OUT_CONTENT_LEN;
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    in_buf_len = ctx->ssl_ctx.in_buf_len;
+    out_buf_len = ctx->ssl_ctx.out_buf_len;
+#endif
+
+    tls_memory_get_stats(&stats);
+    tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "TLS RAM %s: context %lu, record buffers in %lu / out %lu, arena in use %lu bytes\r\n",
+                   stage, (unsigned long)sizeof(cy_tls_context_mbedtls_t), (unsigned long)in_buf_len,
+                   (unsigned long)out_buf_len, (unsigned long)stats.current);
+#else
+    (void)ctx;
+    (void)stage;
+#endif
+}
+/*-----------------------------------------------------------*/
+static cy_rslt_t cy_tls_connect_internal(void *context, cy_tls_endpoint_type_t endpoint, uint32_t timeout)
 {
     cy_tls_context_mbedtls_t *ctx = (cy_tls_context_mbedtls_t *) context;
-    const char *pers = "tls_drbg_seed";
     int ret;
     cy_tls_identity_t *tls_identity;
     cy_rslt_t result = CY_RSLT_SUCCESS;
     bool load_cert_key_from_ram = CY_TLS_LOAD_CERT_FROM_RAM;
-
-    (void)(timeout);
-
+    cy_time_t start;
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
     CK_RV pkcs_result = CKR_OK;
 #endif
 
+    if(timeout == 0)
+    {
+        timeout = CY_TLS_HANDSHAKE_TIMEOUT_MS;
+    }
+
     if(ctx == NULL)
     {
         return CY_RSLT_MODULE_TLS_BADARG;
@@ -1031,13 +1251,13 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
     /* Initialize mbedTLS structures. */
     mbedtls_ssl_init(&ctx->ssl_ctx);
     mbedtls_ssl_config_init(&ctx->ssl_config);
-    mbedtls_ctr_drbg_init(&ctx->ctr_drbg);
-    mbedtls_entropy_init(&ctx->entropy);
 
-    if((ret = mbedtls_ctr_drbg_seed(&ctx->ctr_drbg, mbedtls_entropy_func,
-            &ctx->entropy, (const unsigned char *) pers, strlen(pers))) != 0)
+    /* Random numbers come from the shared, pre-seeded entropy pool rather than
+     * a DRBG seeded per connection, which keeps TRNG reads off the connect path.
+     */
+    if(entropy_pool_init() != CY_RSLT_SUCCESS)
     {
-        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_ctr_drbg_seed failed 0x%x\r\n", -ret);
+        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "entropy_pool_init failed\r\n");
         return CY_RSLT_MODULE_TLS_ERROR;
     }
 
@@ -1053,7 +1273,7 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
         mbedtls_ssl_conf_cert_profile( &ctx->ssl_config, custom_cert_profile);
     }
 
-    mbedtls_ssl_conf_rng(&ctx->ssl_config, mbedtls_ctr_drbg_random, &ctx->ctr_drbg);
+    mbedtls_ssl_conf_rng(&ctx->ssl_config, entropy_pool_mbedtls_random, NULL);
 
     mbedtls_ssl_conf_authmode(&ctx->ssl_config, ctx->auth_mode);
     ret = mbedtls_ssl_conf_max_frag_len(&ctx->ssl_config, ctx->mfl_code);
@@ -1063,6 +1283,13 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
         return CY_RSLT_MODULE_TLS_ERROR;
     }
 
+#ifdef CY_TLS_CIPHERSUITES
+    mbedtls_ssl_conf_ciphersuites(&ctx->ssl_config, cy_tls_ciphersuites);
+#endif
+#ifdef CY_TLS_CURVES
+    mbedtls_ssl_conf_curves(&ctx->ssl_config, cy_tls_curves);
+#endif
+
     if(ctx->alpn_list)
     {
         ret = mbedtls_ssl_conf_alpn_protocols(&ctx->ssl_config, ctx->alpn_list);
@@ -1088,7 +1315,7 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
     {
         load_cert_key_from_ram = CY_TLS_LOAD_CERT_FROM_SECURE_STORAGE;
 
-        ctx->cert_x509ca = malloc(sizeof(mbedtls_x509_crt));
+        ctx->cert_x509ca = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
         if(ctx->cert_x509ca == NULL)
         {
             return CY_RSLT_MODULE_TLS_OUT_OF_HEAP_SPACE;
@@ -1131,7 +1358,7 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
     {
         load_cert_key_from_ram = CY_TLS_LOAD_CERT_FROM_SECURE_STORAGE;
 
-        ctx->cert_client = malloc(sizeof(mbedtls_x509_crt));
+        ctx->cert_client = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
         if(ctx->cert_client == NULL)
         {
             result = CY_RSLT_MODULE_TLS_OUT_OF_HEAP_SPACE;
@@ -1148,7 +1375,7 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
         {
             tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Reading device credentials from secure element failed with error %d \r\n", pkcs_result);
             mbedtls_x509_crt_free(ctx->cert_client);
-            free(ctx->cert_client);
+            mbedtls_free(ctx->cert_client);
             ctx->cert_client = NULL;
         }
     }
@@ -1187,11 +1414,31 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
 
     mbedtls_ssl_set_bio(&ctx->ssl_ctx, context, cy_tls_internal_send, cy_tls_internal_recv, NULL);
 
+    cy_tls_report_resident_ram(ctx, "before handshake");
+
     tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Performing the TLS handshake\r\n");
 
+    ctx->handshake_bytes_sent = 0;
+    ctx->handshake_bytes_received = 0;
+
+    cy_rtos_get_time(&start);
     while((ret = mbedtls_ssl_handshake( &ctx->ssl_ctx)) != 0)
     {
-        if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+        if((ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) && cy_tls_timeout_expired(start, timeout))
+        {
+            cy_tls_record_handshake(ctx, start, false);
+            mbedtls_ssl_free(&ctx->ssl_ctx);
+            mbedtls_ssl_config_free(&ctx->ssl_config);
+
+            tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_ssl_handshake timed out after %lu ms\r\n", (unsigned long)timeout);
+            result = CY_RSLT_MODULE_TLS_TIMEOUT;
+            goto cleanup;
+        }
+        else if(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            cy_tls_wait_ready(ctx, ret, start, timeout);
+        }
+        else
         {
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
             if(pkcs_result != CKR_OK)
@@ -1201,10 +1448,9 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
             }
 #endif
 
+            cy_tls_record_handshake(ctx, start, false);
             mbedtls_ssl_free(&ctx->ssl_ctx);
             mbedtls_ssl_config_free(&ctx->ssl_config);
-            mbedtls_ctr_drbg_free(&ctx->ctr_drbg);
-            mbedtls_entropy_free(&ctx->entropy);
 
             tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "mbedtls_ssl_handshake failed 0x%x\r\n", -ret);
             result = CY_RSLT_MODULE_TLS_ERROR;
@@ -1212,9 +1458,12 @@ cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_
         }
     }
 
+    cy_tls_record_handshake(ctx, start, true);
     ctx->tls_handshake_successful = true;
     tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "TLS handshake successful \r\n");
 
+    cy_tls_report_resident_ram(ctx, "after handshake");
+
     return CY_RSLT_SUCCESS;
 
 cleanup:
@@ -1222,14 +1471,14 @@ cleanup:
     if(ctx->cert_x509ca != NULL)
     {
         mbedtls_x509_crt_free(ctx->cert_x509ca);
-        free(ctx->cert_x509ca);
+        mbedtls_free(ctx->cert_x509ca);
         ctx->cert_x509ca = NULL;
     }
 
     if(ctx->cert_client != NULL)
     {
         mbedtls_x509_crt_free(ctx->cert_client);
-        free(ctx->cert_client);
+        mbedtls_free(ctx->cert_client);
         ctx->cert_client = NULL;
     }
 #endif
@@ -1237,34 +1486,53 @@ cleanup:
     return result;
 }
 /*-----------------------------------------------------------*/
-cy_rslt_t cy_tls_send(void *context, const unsigned char *data, uint32_t length, uint32_t timeout, uint32_t *bytes_sent)
+/*
+ * What mbedTLS allocates while the connection is set up comes from the TLS
+ * arena, which the connection keeps until cy_tls_delete_context(). If another
+ * connection holds the arena this one uses the heap.
+ */
+cy_rslt_t cy_tls_connect(void *context, cy_tls_endpoint_type_t endpoint, uint32_t timeout)
 {
-    cy_tls_context_mbedtls_t *ctx = (cy_tls_context_mbedtls_t *) context;
-    size_t sent = 0;
-    int ret;
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-
-    (void)(timeout);
+    cy_rslt_t result;
 
-    if(context == NULL || data == NULL || length == 0 || bytes_sent == NULL)
+    if(context == NULL)
     {
         return CY_RSLT_MODULE_TLS_BADARG;
     }
 
-    *bytes_sent = 0;
-
-    if(!ctx->tls_handshake_successful)
+    if(!tls_memory_enter(context))
     {
-        return CY_RSLT_MODULE_TLS_ERROR;
+        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "TLS arena held by another connection, using the heap\r\n");
     }
 
+    result = cy_tls_connect_internal(context, endpoint, timeout);
+
+    tls_memory_leave();
+
+    return result;
+}
+/*-----------------------------------------------------------*/
+/*
+ * Writes 'length' bytes through mbedtls_ssl_write(), retrying on WANT_READ and
+ * WANT_WRITE until everything is written, an error occurs or 'timeout' expires.
+ * 'bytes_sent' receives the number of bytes written even on error.
+ */
+static cy_rslt_t cy_tls_write(cy_tls_context_mbedtls_t *ctx, const unsigned char *data, uint32_t length, uint32_t timeout, uint32_t *bytes_sent)
+{
+    size_t sent = 0;
+    int ret;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    cy_time_t start;
+
+    cy_rtos_get_time(&start);
     while(sent < length)
     {
         ret = mbedtls_ssl_write(&ctx->ssl_ctx, data + sent, length-sent);
         if(ret > 0)
         {
-            /* Update sent count. */
+            /* Update sent count. Every successful write is one record. */
             sent += ret;
+            send_stats.records++;
         }
         else if(0 == ret)
         {
@@ -1299,8 +1567,47 @@ cy_rslt_t cy_tls_send(void *context, const unsigned char *data, uint32_t length,
             result = CY_RSLT_MODULE_TLS_ERROR;
             break;
         }
+        else if(cy_tls_timeout_expired(start, timeout))
+        {
+            tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Timeout\r\n");
+            result = CY_RSLT_MODULE_TLS_TIMEOUT;
+            break;
+        }
+        else
+        {
+            /* The transport is not ready yet. Wait for the socket instead of spinning. */
+            cy_tls_wait_ready(ctx, ret, start, timeout);
+        }
     }
 
+    *bytes_sent = sent;
+
+    return result;
+}
+/*-----------------------------------------------------------*/
+cy_rslt_t cy_tls_send(void *context, const unsigned char *data, uint32_t length, uint32_t timeout, uint32_t *bytes_sent)
+{
+    cy_tls_context_mbedtls_t *ctx = (cy_tls_context_mbedtls_t *) context;
+    uint32_t sent = 0;
+    cy_rslt_t result;
+
+    if(context == NULL || data == NULL || length == 0 || bytes_sent == NULL)
+    {
+        return CY_RSLT_MODULE_TLS_BADARG;
+    }
+
+    *bytes_sent = 0;
+
+    if(!ctx->tls_handshake_successful)
+    {
+        return CY_RSLT_MODULE_TLS_ERROR;
+    }
+
+    send_stats.app_writes++;
+    send_stats.app_bytes += length;
+
+    result = cy_tls_write(ctx, data, length, timeout, &sent);
+
     /* Check if bytes sent is != 0 then return success. If not, return error */
     if(sent != 0)
     {
@@ -1312,14 +1619,29 @@ cy_rslt_t cy_tls_send(void *context, const unsigned char *data, uint32_t length,
     return result;
 }
 /*-----------------------------------------------------------*/
+void cy_tls_get_send_stats(cy_tls_send_stats_t *stats)
+{
+    if(stats != NULL)
+    {
+        *stats = send_stats;
+    }
+}
+/*-----------------------------------------------------------*/
+void cy_tls_get_handshake_stats(cy_tls_handshake_stats_t *stats)
+{
+    if(stats != NULL)
+    {
+        *stats = handshake_stats;
+    }
+}
+/*-----------------------------------------------------------*/
 cy_rslt_t cy_tls_recv(void *context, unsigned char *buffer, uint32_t length, uint32_t timeout, uint32_t *bytes_received)
 {
     cy_tls_context_mbedtls_t *ctx = (cy_tls_context_mbedtls_t *) context;
     size_t read;
     int ret;
     cy_rslt_t result = CY_RSLT_SUCCESS;
-
-    (void)(timeout);
+    cy_time_t start;
 
     if(context == NULL || buffer == NULL || length == 0 || bytes_received == NULL)
     {
@@ -1335,6 +1657,7 @@ cy_rslt_t cy_tls_recv(void *context, unsigned char *buffer, uint32_t length, uin
 
     /* Read the data */
     read = 0;
+    cy_rtos_get_time(&start);
     do
     {
         ret = mbedtls_ssl_read(&ctx->ssl_ctx, buffer + read, length-read);
@@ -1342,11 +1665,26 @@ cy_rslt_t cy_tls_recv(void *context, unsigned char *buffer, uint32_t length, uin
         {
             /* Update read count. */
             read += ret;
+
+            /* Return what has arrived so far rather than blocking on the
+             * network for the rest; the caller reads again for more.
+             */
+            if((mbedtls_ssl_get_bytes_avail(&ctx->ssl_ctx) == 0) && (mbedtls_ssl_check_pending(&ctx->ssl_ctx) == 0))
+            {
+                break;
+            }
         }
         else if(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS)
         {
-            /* The handshake is not over yet. Retry */
-            continue;
+            if(cy_tls_timeout_expired(start, timeout))
+            {
+                tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Timeout\r\n");
+                result = CY_RSLT_MODULE_TLS_TIMEOUT;
+                break;
+            }
+
+            /* No complete record yet. Wait for the socket until the deadline. */
+            cy_tls_wait_ready(ctx, ret, start, timeout);
         }
         else if((ret == 0) || (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) || (ret == MBEDTLS_ERR_SSL_CLIENT_RECONNECT))
         {
@@ -1396,6 +1734,28 @@ cy_rslt_t cy_tls_recv(void *context, unsigned char *buffer, uint32_t length, uin
     return result;
 }
 /*-----------------------------------------------------------*/
+/*
+ * Reports the TLS arena usage of the connection that is being torn down and
+ * resets the arena if the connection held it, so that each connection starts
+ * from an unfragmented arena. Only the connection's own allocations are in
+ * the arena, so anything left over is a leak.
+ */
+static void cy_tls_release_memory_arena(cy_tls_context_mbedtls_t *ctx)
+{
+    tls_memory_stats_t stats;
+
+    tls_memory_get_stats(&stats);
+    tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "TLS arena: peak %lu of %lu bytes, %lu bytes in %lu blocks still allocated, %lu failed requests\r\n",
+                   (unsigned long)stats.peak, (unsigned long)stats.arena_size, (unsigned long)stats.current,
+                   (unsigned long)stats.allocations, (unsigned long)stats.failed);
+
+    if(!tls_memory_release(ctx))
+    {
+        tls_cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "TLS arena not reset, the connection leaked %lu allocations\r\n", (unsigned long)stats.allocations);
+        CY_ASSERT(0);
+    }
+}
+/*-----------------------------------------------------------*/
 cy_rslt_t cy_tls_delete_context(cy_tls_context_t context)
 {
     cy_tls_context_mbedtls_t *ctx = (cy_tls_context_mbedtls_t *) context;
@@ -1417,9 +1777,6 @@ cy_rslt_t cy_tls_delete_context(cy_tls_context_t context)
         mbedtls_ssl_close_notify(&ctx->ssl_ctx);
         mbedtls_ssl_free(&ctx->ssl_ctx);
         mbedtls_ssl_config_free(&ctx->ssl_config);
-
-        mbedtls_ctr_drbg_free(&ctx->ctr_drbg);
-        mbedtls_entropy_free(&ctx->entropy);
     }
 
 #ifdef CY_SECURE_SOCKETS_PKCS_SUPPORT
@@ -1431,19 +1788,22 @@ cy_rslt_t cy_tls_delete_context(cy_tls_context_t context)
     if(ctx->cert_x509ca != NULL)
     {
         mbedtls_x509_crt_free(ctx->cert_x509ca);
-        free(ctx->cert_x509ca);
+        mbedtls_free(ctx->cert_x509ca);
         ctx->cert_x509ca = NULL;
     }
 
     if(ctx->cert_client != NULL)
     {
         mbedtls_x509_crt_free(ctx->cert_client);
-        free(ctx->cert_client);
+        mbedtls_free(ctx->cert_client);
         ctx->cert_client = NULL;
     }
 #endif
 
+    cy_tls_release_memory_arena(ctx);
+
     free(context);
+
     return CY_RSLT_SUCCESS;
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+
+/** @file
+ *  Extensions of the TLS layer: counters for the send path and the handshake,
+ *  a wait callback supplied by the transport and a per-task maximum fragment
+ *  length request. The layer itself knows nothing of the protocol it carries;
+ *  MQTT specific write handling lives in the MQTT transport (mqtt_transport.h).
+ */
+
+#ifndef CY_TLS_EXT_H_
+#define CY_TLS_EXT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cy_result.h"
+
+/**
+ * Blocks until the transport under a TLS context is ready, readable if
+ * 'want_write' is false and writable if it is true, or until 'timeout_ms'
+ * expires; 0 means no limit. 'caller_context' is the context the transport
+ * passed in cy_tls_params_t. Returns CY_RSLT_SUCCESS when the transport is
+ * ready or the time is up, and an error if it cannot wait, in which case the
+ * TLS layer retries after a short delay.
+ */
+typedef cy_rslt_t (*cy_tls_wait_t)(void *caller_context, bool want_write, uint32_t timeout_ms);
+
+/**
+ * Counters for the send path, accumulated over all connections. Take a
+ * snapshot before and after an operation to get its cost on the wire.
+ */
+typedef struct cy_tls_send_stats
+{
+    uint32_t app_writes;        /**< Send calls made by the layer above */
+    uint32_t app_bytes;         /**< Plaintext bytes handed to the TLS layer */
+    uint32_t records;           /**< Application data records written */
+    uint32_t wire_bytes;        /**< Bytes passed to the network, including handshake */
+} cy_tls_send_stats_t;
+
+/**
+ * Handshake counters, accumulated over all connections, and the cost of the
+ * last handshake. Define CY_TLS_CIPHERSUITES or CY_TLS_CURVES to compare
+ * the cost of different parameters.
+ */
+typedef struct cy_tls_handshake_stats
+{
+    uint32_t handshakes;            /**< Handshakes completed */
+    uint32_t failures;              /**< Handshakes that failed or timed out */
+    uint32_t last_duration_ms;      /**< Time taken by the last handshake */
+    uint32_t last_bytes_sent;       /**< Bytes the last handshake sent */
+    uint32_t last_bytes_received;   /**< Bytes the last handshake received */
+    uint16_t last_ciphersuite;      /**< Negotiated ciphersuite id, 0 on failure */
+} cy_tls_handshake_stats_t;
+
+/**
+ * Sets the function the TLS layer waits with while a read or write cannot
+ * make progress, NULL to poll with a short delay instead. The transport that
+ * creates the TLS contexts supplies it, since only it knows what their caller
+ * context is.
+ */
+void cy_tls_set_wait_callback(cy_tls_wait_t wait);
+
+/**
+ * Requests a maximum fragment length for the TLS connections the calling task
+ * creates from now on, as an MBEDTLS_SSL_MAX_FRAG_LEN_* code. It applies only
+ * where the creator of the connection leaves cy_tls_params_t.mfl_code unset;
+ * every other connection keeps the library default of no request. Only one
+ * task can hold a request at a time. Pass MBEDTLS_SSL_MAX_FRAG_LEN_NONE (0)
+ * to withdraw it.
+ */
+void cy_tls_set_task_mfl_code(unsigned char mfl_code);
+
+/**
+ * Fills 'stats' with a snapshot of the send counters.
+ */
+void cy_tls_get_send_stats(cy_tls_send_stats_t *stats);
+
+/**
+ * Fills 'stats' with a snapshot of the handshake counters.
+ */
+void cy_tls_get_handshake_stats(cy_tls_handshake_stats_t *stats);
+
+#endif /* CY_TLS_EXT_H_ */
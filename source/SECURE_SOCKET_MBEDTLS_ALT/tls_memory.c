@@ -0,0 +1,402 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/** @file
+ *  Static memory arena for the mbedTLS allocations of one TLS connection.
+ *
+ *  The arena is a first-fit allocator with boundary tags: every block carries
+ *  its own size and the size of the block in front of it, so freed blocks are
+ *  merged with both neighbours in constant time. Free blocks are kept on a
+ *  doubly linked list threaded through their payload. The allocator is
+ *  serialised with the scheduler suspended, in the same way as the FreeRTOS
+ *  heap_3 wrapper around malloc.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cy_utils.h"
+#include "tls_memory.h"
+
+#define TLS_MEMORY_ALIGNMENT            (8u)
+#define TLS_MEMORY_ALIGN_UP(x)          (((x) + (TLS_MEMORY_ALIGNMENT - 1u)) & ~(TLS_MEMORY_ALIGNMENT - 1u))
+#define TLS_MEMORY_ARENA_BYTES          (TLS_MEMORY_ARENA_SIZE & ~(TLS_MEMORY_ALIGNMENT - 1u))
+
+/* Bit 0 of the block size marks a block as allocated; sizes are always aligned. */
+#define TLS_MEMORY_IN_USE               (1u)
+
+typedef struct tls_memory_block
+{
+    uint32_t                        size;       /* Size including this header, TLS_MEMORY_IN_USE while allocated */
+    uint32_t                        prev_size;  /* Size of the physically preceding block, 0 for the first block */
+} tls_memory_block_t;
+
+typedef struct tls_memory_free_block
+{
+    tls_memory_block_t              header;
+    struct tls_memory_free_block   *next;
+    struct tls_memory_free_block   *prev;
+} tls_memory_free_block_t;
+
+#define TLS_MEMORY_HEADER_SIZE          (sizeof(tls_memory_block_t))
+#define TLS_MEMORY_MIN_BLOCK_SIZE       TLS_MEMORY_ALIGN_UP(sizeof(tls_memory_free_block_t))
+
+CY_ALIGN(TLS_MEMORY_ALIGNMENT) static uint8_t tls_arena[TLS_MEMORY_ARENA_BYTES];
+
+static tls_memory_free_block_t *free_list = NULL;
+static tls_memory_stats_t tls_memory_stats;
+static bool tls_memory_initialized = false;
+
+/* Connection the arena belongs to, and the task allocating for it. */
+static const void *arena_owner = NULL;
+static TaskHandle_t arena_task = NULL;
+
+/*-----------------------------------------------------------*/
+static uint32_t tls_memory_block_size(const tls_memory_block_t *block)
+{
+    return (block->size & ~TLS_MEMORY_IN_USE);
+}
+
+/*-----------------------------------------------------------*/
+static bool tls_memory_is_last_block(const tls_memory_block_t *block)
+{
+    return (((const uint8_t *)block + tls_memory_block_size(block)) >= &tls_arena[TLS_MEMORY_ARENA_BYTES]);
+}
+
+/*-----------------------------------------------------------*/
+static tls_memory_block_t *tls_memory_next_block(tls_memory_block_t *block)
+{
+    return (tls_memory_block_t *)((uint8_t *)block + tls_memory_block_size(block));
+}
+
+/*-----------------------------------------------------------*/
+static void tls_memory_free_list_insert(tls_memory_free_block_t *block)
+{
+    block->prev = NULL;
+    block->next = free_list;
+    if(free_list != NULL)
+    {
+        free_list->prev = block;
+    }
+    free_list = block;
+}
+
+/*-----------------------------------------------------------*/
+static void tls_memory_free_list_remove(tls_memory_free_block_t *block)
+{
+    if(block->prev != NULL)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        free_list = block->next;
+    }
+
+    if(block->next != NULL)
+    {
+        block->next->prev = block->prev;
+    }
+}
+
+/*-----------------------------------------------------------*/
+/* Must be called with the scheduler suspended. */
+static void tls_memory_init_arena(void)
+{
+    tls_memory_free_block_t *block = (tls_memory_free_block_t *)tls_arena;
+
+    block->header.size = TLS_MEMORY_ARENA_BYTES;
+    block->header.prev_size = 0;
+
+    free_list = NULL;
+    tls_memory_free_list_insert(block);
+
+    tls_memory_stats.arena_size = TLS_MEMORY_ARENA_BYTES;
+    tls_memory_stats.current = 0;
+    tls_memory_stats.peak = 0;
+    tls_memory_stats.allocations = 0;
+    tls_memory_initialized = true;
+}
+
+/*-----------------------------------------------------------*/
+void *tls_memory_calloc(size_t nmemb, size_t size)
+{
+    tls_memory_free_block_t *block;
+    tls_memory_free_block_t *remainder;
+    size_t total;
+    uint32_t required;
+    void *ptr = NULL;
+
+    if((arena_task == NULL) || (arena_task != xTaskGetCurrentTaskHandle()))
+    {
+        /* Not made for the connection that holds the arena. */
+        return calloc(nmemb, size);
+    }
+
+    if((size != 0) && (nmemb > (SIZE_MAX / size)))
+    {
+        return NULL;
+    }
+
+    /* Hand out a unique pointer for zero-sized requests, as calloc() does. */
+    total = (nmemb * size == 0) ? 1 : (nmemb * size);
+    if(total > (TLS_MEMORY_ARENA_BYTES - TLS_MEMORY_HEADER_SIZE))
+    {
+        tls_memory_stats.failed++;
+        return NULL;
+    }
+
+    required = TLS_MEMORY_ALIGN_UP(total + TLS_MEMORY_HEADER_SIZE);
+    if(required < TLS_MEMORY_MIN_BLOCK_SIZE)
+    {
+        required = TLS_MEMORY_MIN_BLOCK_SIZE;
+    }
+
+    vTaskSuspendAll();
+
+    if(!tls_memory_initialized)
+    {
+        tls_memory_init_arena();
+    }
+
+    for(block = free_list; block != NULL; block = block->next)
+    {
+        if(block->header.size >= required)
+        {
+            break;
+        }
+    }
+
+    if(block != NULL)
+    {
+        tls_memory_free_list_remove(block);
+
+        /* Split off the tail if it is big enough to be a block on its own. */
+        if((block->header.size - required) >= TLS_MEMORY_MIN_BLOCK_SIZE)
+        {
+            remainder = (tls_memory_free_block_t *)((uint8_t *)block + required);
+            remainder->header.size = block->header.size - required;
+            remainder->header.prev_size = required;
+            if(!tls_memory_is_last_block(&remainder->header))
+            {
+                tls_memory_next_block(&remainder->header)->prev_size = remainder->header.size;
+            }
+            tls_memory_free_list_insert(remainder);
+            block->header.size = required;
+        }
+
+        tls_memory_stats.current += block->header.size;
+        if(tls_memory_stats.current > tls_memory_stats.peak)
+        {
+            tls_memory_stats.peak = tls_memory_stats.current;
+        }
+        tls_memory_stats.allocations++;
+
+        block->header.size |= TLS_MEMORY_IN_USE;
+        ptr = (uint8_t *)block + TLS_MEMORY_HEADER_SIZE;
+    }
+    else
+    {
+        tls_memory_stats.failed++;
+    }
+
+    (void) xTaskResumeAll();
+
+    if(ptr != NULL)
+    {
+        memset(ptr, 0, total);
+    }
+
+    return ptr;
+}
+
+/*-----------------------------------------------------------*/
+void tls_memory_free(void *ptr)
+{
+    tls_memory_block_t *block;
+    tls_memory_block_t *neighbour;
+
+    if(ptr == NULL)
+    {
+        return;
+    }
+
+    if(((uint8_t *)ptr < &tls_arena[TLS_MEMORY_HEADER_SIZE]) || ((uint8_t *)ptr >= &tls_arena[TLS_MEMORY_ARENA_BYTES]))
+    {
+        /* Allocated from the heap by tls_memory_calloc(). */
+        free(ptr);
+        return;
+    }
+
+    block = (tls_memory_block_t *)((uint8_t *)ptr - TLS_MEMORY_HEADER_SIZE);
+
+    vTaskSuspendAll();
+
+    if((block->size & TLS_MEMORY_IN_USE) != 0)
+    {
+        block->size = tls_memory_block_size(block);
+        tls_memory_stats.current -= block->size;
+        tls_memory_stats.allocations--;
+
+        /* Merge with the following block if it is free. */
+        if(!tls_memory_is_last_block(block))
+        {
+            neighbour = tls_memory_next_block(block);
+            if((neighbour->size & TLS_MEMORY_IN_USE) == 0)
+            {
+                tls_memory_free_list_remove((tls_memory_free_block_t *)neighbour);
+                block->size += neighbour->size;
+            }
+        }
+
+        /* Merge into the preceding block if it is free. */
+        if(block->prev_size != 0)
+        {
+            neighbour = (tls_memory_block_t *)((uint8_t *)block - block->prev_size);
+            if((neighbour->size & TLS_MEMORY_IN_USE) == 0)
+            {
+                tls_memory_free_list_remove((tls_memory_free_block_t *)neighbour);
+                neighbour->size += block->size;
+                block = neighbour;
+            }
+        }
+
+        if(!tls_memory_is_last_block(block))
+        {
+            tls_memory_next_block(block)->prev_size = block->size;
+        }
+
+        tls_memory_free_list_insert((tls_memory_free_block_t *)block);
+    }
+
+    (void) xTaskResumeAll();
+}
+
+/*-----------------------------------------------------------*/
+void tls_memory_get_stats(tls_memory_stats_t *stats)
+{
+    tls_memory_free_block_t *block;
+
+    if(stats == NULL)
+    {
+        return;
+    }
+
+    vTaskSuspendAll();
+
+    if(!tls_memory_initialized)
+    {
+        tls_memory_init_arena();
+    }
+
+    *stats = tls_memory_stats;
+    stats->largest_free = 0;
+    for(block = free_list; block != NULL; block = block->next)
+    {
+        if(block->header.size > stats->largest_free)
+        {
+            stats->largest_free = block->header.size;
+        }
+    }
+    if(stats->largest_free >= TLS_MEMORY_HEADER_SIZE)
+    {
+        stats->largest_free -= TLS_MEMORY_HEADER_SIZE;
+    }
+
+    (void) xTaskResumeAll();
+}
+
+/*-----------------------------------------------------------*/
+bool tls_memory_enter(const void *owner)
+{
+    bool entered = false;
+
+    vTaskSuspendAll();
+
+    if(arena_owner == NULL)
+    {
+        arena_owner = owner;
+    }
+    if(arena_owner == owner)
+    {
+        arena_task = xTaskGetCurrentTaskHandle();
+        entered = true;
+    }
+
+    (void) xTaskResumeAll();
+
+    return entered;
+}
+
+/*-----------------------------------------------------------*/
+void tls_memory_leave(void)
+{
+    vTaskSuspendAll();
+
+    if(arena_task == xTaskGetCurrentTaskHandle())
+    {
+        arena_task = NULL;
+    }
+
+    (void) xTaskResumeAll();
+}
+
+/*-----------------------------------------------------------*/
+bool tls_memory_release(const void *owner)
+{
+    bool released = true;
+
+    vTaskSuspendAll();
+
+    if((owner != NULL) && (arena_owner == owner))
+    {
+        arena_owner = NULL;
+        arena_task = NULL;
+
+        if(tls_memory_stats.allocations == 0)
+        {
+            tls_memory_init_arena();
+            tls_memory_stats.resets++;
+        }
+        else
+        {
+            tls_memory_stats.leaks++;
+            released = false;
+        }
+    }
+
+    (void) xTaskResumeAll();
+
+    return released;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/** @file
+ *  Static memory arena for the mbedTLS allocations of one TLS connection.
+ *
+ *  mbedtls_calloc()/mbedtls_free() are mapped to tls_memory_calloc() and
+ *  tls_memory_free() through MBEDTLS_PLATFORM_CALLOC_MACRO and
+ *  MBEDTLS_PLATFORM_FREE_MACRO in mbedtls_user_config.h. While a connection
+ *  is being set up (between tls_memory_enter() and tls_memory_leave()) the
+ *  allocations of the connecting task come from the arena, so the SSL record
+ *  buffers, parsed certificates and handshake state never touch the general
+ *  heap and cannot fragment it across reconnects. All other allocations, such
+ *  as the global root CA or the device identity, go to the heap, so nothing
+ *  outside the connection can keep the arena from being reset at teardown.
+ */
+
+#ifndef TLS_MEMORY_H_
+#define TLS_MEMORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Size of the arena in bytes. It has to hold one connection's record buffers
+ * plus the handshake state and the parsed certificate chain.
+ */
+#ifndef TLS_MEMORY_ARENA_SIZE
+#define TLS_MEMORY_ARENA_SIZE           (48 * 1024)
+#endif
+
+/**
+ * Usage counters of the arena. All sizes include the block headers, i.e. they
+ * are the number of arena bytes actually consumed.
+ */
+typedef struct tls_memory_stats
+{
+    uint32_t arena_size;        /**< Total size of the arena */
+    uint32_t current;           /**< Bytes currently allocated */
+    uint32_t peak;              /**< Highest value of 'current' since the last reset */
+    uint32_t largest_free;      /**< Largest free block, i.e. biggest satisfiable request */
+    uint32_t allocations;       /**< Number of live allocations */
+    uint32_t failed;            /**< Number of requests that could not be satisfied */
+    uint32_t resets;            /**< Number of times the arena was reset on teardown */
+    uint32_t leaks;             /**< Teardowns that left allocations in the arena */
+} tls_memory_stats_t;
+
+void *tls_memory_calloc(size_t nmemb, size_t size);
+void tls_memory_free(void *ptr);
+
+/**
+ * Fills 'stats' with a snapshot of the arena counters.
+ */
+void tls_memory_get_stats(tls_memory_stats_t *stats);
+
+/**
+ * Routes the allocations of the calling task to the arena on behalf of the
+ * connection 'owner', until tls_memory_leave(). The arena belongs to the
+ * first connection that enters it until that connection calls
+ * tls_memory_release().
+ *
+ * @return true if the arena is used, false if another connection holds it and
+ *         the allocations go to the heap.
+ */
+bool tls_memory_enter(const void *owner);
+
+/**
+ * Ends tls_memory_enter() for the calling task.
+ */
+void tls_memory_leave(void);
+
+/**
+ * Called when the connection 'owner' is torn down. If it held the arena, the
+ * arena is reinitialised to a single free block, which guarantees that no
+ * fragmentation carries over to the next connection, and the peak counter is
+ * restarted.
+ *
+ * @return false if the connection left allocations in the arena, i.e. leaked
+ *         them. The arena is then released without a reset.
+ */
+bool tls_memory_release(const void *owner);
+
+#endif /* TLS_MEMORY_H_ */
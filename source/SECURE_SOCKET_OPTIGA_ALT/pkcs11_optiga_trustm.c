@@ -64,6 +64,7 @@
 #include "pal/pal_ifx_i2c_config.h"
 #include "optiga_lib_common.h"
 #include "pkcs11_optiga_trustm.h"
+#include "entropy_pool.h"
 
 /* Memory routines */
 #ifndef PKCS11_MALLOC
@@ -113,6 +114,7 @@
 /* Meta Data Defines */
 #define OPTIGA_METADATA_TLV_OBJECT_TAG            0x20
 #define OPTIGA_METADATA_KEY_ALGO_IDFR_TAG         0xE0
+#define OPTIGA_METADATA_USED_SIZE_TAG             0xC5
 #define OPTIGA_PLATFORM_BINDING_SHARED_SECRET_OID 0xE140
 
 #define OPTIGA_TLS_IDENTITY_TAG                   0xC0
@@ -144,6 +146,24 @@ typedef struct P11Object_t
     CK_BYTE xLabel[ pkcs11configMAX_LABEL_LENGTH + 1 ]; /* Plus 1 for the null terminator. */
 } P11Object_t;
 
+/*
+ * Directory entry for an object exposed by this module. The OID, key algorithm
+ * and size are resolved once in C_Initialize, so later lookups neither parse
+ * the label nor read the metadata over I2C.
+ */
+typedef struct P11DirectoryEntry_t
+{
+    P11ObjectHandles_t xHandle;
+    const char_t *     pcLabel;
+    CK_OBJECT_CLASS    xClass;
+    uint16_t           usOid;
+    uint16_t           usKeyAlgorithm;  /* OPTIGA key algorithm, 0 if not a key */
+    CK_KEY_TYPE        xKeyType;        /* PKCS #11 key type for usKeyAlgorithm */
+    uint16_t           usDataSize;      /* Used size at C_Initialize, 0 if unknown */
+} P11DirectoryEntry_t;
+
+#define pkcs11DIRECTORY_SIZE    3
+
 typedef struct P11ObjectList_t
 {
     optiga_crypt_t*               optigaCryptInst;
@@ -151,6 +171,7 @@ typedef struct P11ObjectList_t
     volatile optiga_lib_status_t  optigaLibStatus;
     uint16_t                      waitCounter;
     P11Object_t                   xObjects[ pkcs11configMAX_NUM_OBJECTS ];
+    P11DirectoryEntry_t           xDirectory[ pkcs11DIRECTORY_SIZE ];
     cy_mutex_t                    xOptigaMutex;
 } P11ObjectList_t;
 
@@ -203,6 +224,12 @@ typedef struct pkcs11_session
 /* ASN.1 DER Tag for INTEGER */
 #define DER_TAG_INTEGER          0x02
 
+/* ASN.1 DER Tag for SEQUENCE */
+#define DER_TAG_SEQUENCE         0x30
+
+/* ASN.1 DER long form LENGTH with one length byte */
+#define DER_LEN_LONG_FORM_1      0x81
+
 #define DER_UINT_MASK            0x80
 
 /*
@@ -412,6 +439,40 @@ static bool prvAsn1ToEcdsaRS(uint8_t* asn1,
     return prvSeparateAsn1ToEcdsaRS(asn1, asn1_len, rs, &r_len, rs + component_length, &s_len);
 }
 
+/**
+ * @brief Completes an OPTIGA(TM) ECDSA signature into a DER ECDSA-Sig-Value
+ *
+ * The OPTIGA(TM) Trust M returns the R and S INTEGERs without the enclosing
+ * SEQUENCE. The caller reserves 'header_len' bytes in front of them; the
+ * SEQUENCE header is written into that space.
+ *
+ * @param  sig[in,out]      Buffer with 'header_len' reserved bytes followed by the INTEGERs
+ * @param  header_len[in]   Number of reserved bytes, 2 or 3
+ * @param  integers_len[in] Length of the INTEGERs
+ * @return The length of the DER encoded signature, which starts at 'sig'
+ */
+static size_t prvWrapEcdsaSignatureInSequence(uint8_t* sig,
+                                              uint8_t header_len,
+                                              size_t integers_len)
+{
+    if(integers_len > DER_INTEGER_MAX_LEN)
+    {
+        sig[ASN1_DER_TAG_OFFSET] = DER_TAG_SEQUENCE;
+        sig[ASN1_DER_LEN_OFFSET] = DER_LEN_LONG_FORM_1;
+        sig[ASN1_DER_VAL_OFFSET] = (uint8_t) integers_len;
+        return 3 + integers_len;
+    }
+
+    /* Short form length: only needed when the long form was anticipated. */
+    if(header_len == 3)
+    {
+        memmove(sig + 2, sig + 3, integers_len);
+    }
+    sig[ASN1_DER_TAG_OFFSET] = DER_TAG_SEQUENCE;
+    sig[ASN1_DER_LEN_OFFSET] = (uint8_t) integers_len;
+    return 2 + integers_len;
+}
+
 /**
  * Callback when optiga_util_xxxx operation is completed asynchronously
  */
@@ -430,74 +491,174 @@ P11SessionPtr_t prvSessionPointerFromHandle( CK_SESSION_HANDLE xSession )
     return ( P11SessionPtr_t ) xSession; /*lint !e923 Allow casting integer type to pointer for handle. */
 }
 /*
- * Retrieve the key type from the OID.
+ * Reads the metadata of an OPTIGA object and extracts the key algorithm and
+ * the used size of a data object. Tags that are not present are reported as 0.
+ * The caller must hold xOptigaMutex.
  */
-static uint16_t prvGetKeyAlgorithm(optiga_util_t *pvUtil, uint16_t oid)
+static CK_RV prvReadObjectMetadata( uint16_t usOid,
+                                    uint16_t * pusKeyAlgorithm,
+                                    uint16_t * pusUsedSize )
 {
     uint8_t readData[64];
-    optiga_lib_status_t xReturn = !OPTIGA_LIB_SUCCESS;
-    uint16_t offset = 0;
     uint16_t bytesToRead = sizeof(readData);
-    uint32_t val = 0;
+    uint16_t offset;
+    uint16_t end;
+    uint8_t tag;
+    uint8_t len;
+    uint8_t i;
+    uint32_t val;
+
+    *pusKeyAlgorithm = 0;
+    *pusUsedSize = 0;
 
-    /* Read MetaData */
     P11CTX_SET_OPTIGA_LIB_STATUS_BUSY;
 
-    xReturn = optiga_util_read_metadata(pvUtil,
-                                        oid,
-                                        readData,
-                                        &bytesToRead);
+    if(OPTIGA_LIB_SUCCESS != optiga_util_read_metadata(xP11Context.xObjectList.optigaUtilInst,
+                                                       usOid,
+                                                       readData,
+                                                       &bytesToRead))
+    {
+        return CKR_DEVICE_ERROR;
+    }
+
+    P11CTX_WAIT_FOR_OPTIGA_STATUS;
 
-    if(OPTIGA_LIB_SUCCESS == xReturn)
+    if((OPTIGA_LIB_SUCCESS != xP11Context.xObjectList.optigaLibStatus) ||
+       (bytesToRead < 2) || (readData[0] != OPTIGA_METADATA_TLV_OBJECT_TAG))
     {
-        P11CTX_WAIT_FOR_OPTIGA_STATUS;
+        return CKR_DEVICE_ERROR;
+    }
+
+    end = 2 + readData[1];
+    if(end > bytesToRead)
+    {
+        end = bytesToRead;
+    }
+
+    /* Walk the TLVs inside the metadata object, values are big endian. */
+    for(offset = 2; (offset + 2) <= end; offset += 2 + len)
+    {
+        tag = readData[offset];
+        len = readData[offset + 1];
+
+        if((offset + 2 + len) > end)
+        {
+            break;
+        }
 
-        if(OPTIGA_LIB_SUCCESS == xP11Context.xObjectList.optigaLibStatus)
+        if((len == 0) || (len > sizeof(val)))
         {
-            CK_BBOOL start = CK_FALSE;
-            uint8_t *ptr = readData;
+            continue;
+        }
 
-            while (offset < bytesToRead)
-            {
-                if(ptr[offset] == OPTIGA_METADATA_TLV_OBJECT_TAG)
-                {
-                    start = CK_TRUE;
-                    /* Skip to the value (Type and Length) */
-                    offset += 2;
-                }
-                if (start == CK_TRUE)
-                {
-                    if(ptr[offset] == OPTIGA_METADATA_KEY_ALGO_IDFR_TAG)
-                    {
-                        offset += 1;
+        val = 0;
+        for(i = 0; i < len; i++)
+        {
+            val = (val << 8) | readData[offset + 2 + i];
+        }
 
-                        switch ( ptr[offset] )
-                        {
-                            case 1:
-                                val = (uint32_t)(*(uint8_t*)&ptr[offset+1]);
-                                break;
-                            case 2:
-                                val = (uint32_t)(*(uint16_t*)&ptr[offset+1]);
-                                break;
-                            case 4:
-                                val = (uint32_t)(*(uint32_t*)&ptr[offset+1]);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        uint8_t len = ptr[offset+1];
-                        offset += (2 + len);
-                    }
-                }
-                else
-                {
-                    offset++;
-                }
-            }
+        if(tag == OPTIGA_METADATA_KEY_ALGO_IDFR_TAG)
+        {
+            *pusKeyAlgorithm = (uint16_t) val;
+        }
+        else if(tag == OPTIGA_METADATA_USED_SIZE_TAG)
+        {
+            *pusUsedSize = (uint16_t) val;
+        }
+    }
+
+    return CKR_OK;
+}
+
+/*
+ * Maps an OPTIGA key algorithm to the PKCS #11 key type.
+ */
+static CK_KEY_TYPE prvKeyTypeFromAlgorithm( uint16_t usKeyAlgorithm )
+{
+    CK_KEY_TYPE xPkcsKeyType = ( CK_KEY_TYPE ) ~0;
+
+    switch(usKeyAlgorithm)
+    {
+        case OPTIGA_ECC_CURVE_NIST_P_256:
+        case OPTIGA_ECC_CURVE_NIST_P_384:
+#ifdef OPTIGA_CRYPT_ECC_NIST_P_521_ENABLED
+        case OPTIGA_ECC_CURVE_NIST_P_521:
+#endif
+#ifdef OPTIGA_CRYPT_ECC_BRAINPOOL_P_R1_ENABLED
+        case OPTIGA_ECC_CURVE_BRAIN_POOL_P_256R1:
+        case OPTIGA_ECC_CURVE_BRAIN_POOL_P_384R1:
+        case OPTIGA_ECC_CURVE_BRAIN_POOL_P_512R1:
+#endif
+            xPkcsKeyType = CKK_EC;
+            break;
+
+        case OPTIGA_RSA_KEY_1024_BIT_EXPONENTIAL:
+        case OPTIGA_RSA_KEY_2048_BIT_EXPONENTIAL:
+            xPkcsKeyType = CKK_RSA;
+            break;
+
+#ifdef OPTIGA_CRYPT_SYM_GENERATE_KEY_ENABLED
+        case OPTIGA_SYMMETRIC_AES_128:
+        case OPTIGA_SYMMETRIC_AES_192:
+        case OPTIGA_SYMMETRIC_AES_256:
+            xPkcsKeyType = CKK_AES;
+            break;
+#endif
+    }
+    return xPkcsKeyType;
+}
+
+/*
+ * Fills the object directory: parses each label into its OID once and caches
+ * the key algorithm and used size from the object metadata. An object whose
+ * metadata cannot be read keeps its OID; its algorithm and size stay 0.
+ * The caller must hold xOptigaMutex.
+ */
+static void prvBuildObjectDirectory( void )
+{
+    static const P11DirectoryEntry_t xDirectoryTemplate[ pkcs11DIRECTORY_SIZE ] =
+    {
+        { DeviceCertificate, LABEL_DEVICE_CERTIFICATE_FOR_TLS, CKO_CERTIFICATE },
+        { DevicePrivateKey,  LABEL_DEVICE_PRIVATE_KEY_FOR_TLS, CKO_PRIVATE_KEY },
+        { RootCertificate,   LABEL_ROOT_CERTIFICATE,           CKO_CERTIFICATE },
+    };
+    P11DirectoryEntry_t * pxEntry;
+    uint8_t ucIndex;
+
+    memcpy( xP11Context.xObjectList.xDirectory, xDirectoryTemplate, sizeof( xDirectoryTemplate ) );
+
+    for(ucIndex = 0; ucIndex < pkcs11DIRECTORY_SIZE; ucIndex++)
+    {
+        pxEntry = &xP11Context.xObjectList.xDirectory[ ucIndex ];
+        pxEntry->usOid = (uint16_t) strtol( pxEntry->pcLabel, NULL, 16 );
+
+        if(CKR_OK != prvReadObjectMetadata( pxEntry->usOid, &pxEntry->usKeyAlgorithm, &pxEntry->usDataSize ))
+        {
+            PKCS11_WARNING_PRINT("Metadata of object 0x%04X not available\r\n", pxEntry->usOid);
         }
+        pxEntry->xKeyType = prvKeyTypeFromAlgorithm( pxEntry->usKeyAlgorithm );
+
+        PKCS11_INFO_PRINT("Object 0x%04X: algorithm 0x%02X, %u bytes\r\n",
+                          pxEntry->usOid, pxEntry->usKeyAlgorithm, pxEntry->usDataSize);
     }
-    return val;
+}
+
+/*
+ * Returns the directory entry of a PAL handle, or NULL if the module does not
+ * expose it.
+ */
+static const P11DirectoryEntry_t * prvGetDirectoryEntry( CK_OBJECT_HANDLE xPalHandle )
+{
+    uint8_t ucIndex;
+
+    for(ucIndex = 0; ucIndex < pkcs11DIRECTORY_SIZE; ucIndex++)
+    {
+        if(xP11Context.xObjectList.xDirectory[ ucIndex ].xHandle == xPalHandle)
+        {
+            return &xP11Context.xObjectList.xDirectory[ ucIndex ];
+        }
+    }
+    return NULL;
 }
 
 static void prvGetObjectValueCleanup( uint8_t * pucData,
@@ -638,36 +799,24 @@ static void prvFindObjectInListByLabel( uint8_t * pcLabel,
 
 /*
  * Translates a PKCS #11 label into an object handle.
+ *
+ * The device private key isn't readable on the OPTIGA(TM) Trust M due to security
+ * considerations, but it is given a handle as the AWS can't handle the labels
+ * without having a handle.
  */
 static CK_OBJECT_HANDLE prvFindObject( uint8_t * pLabel )
 {
-    CK_OBJECT_HANDLE object_handle = InvalidHandle;
+    uint8_t ucIndex;
 
-    /* Translate from the PKCS#11 label to local storage file name. */
-    if(0 == memcmp( pLabel,
-                    &LABEL_DEVICE_CERTIFICATE_FOR_TLS,
-                    sizeof( LABEL_DEVICE_CERTIFICATE_FOR_TLS )))
+    for(ucIndex = 0; ucIndex < pkcs11DIRECTORY_SIZE; ucIndex++)
     {
-        object_handle = DeviceCertificate;
-    }
-    else if(0 == memcmp( pLabel,
-                         &LABEL_DEVICE_PRIVATE_KEY_FOR_TLS,
-                         sizeof( LABEL_DEVICE_PRIVATE_KEY_FOR_TLS )))
-    {
-        /* This operation isn't supported for the OPTIGA(TM) Trust M due to a security considerations
-         * You can only generate a keypair and export a private component if you like.
-         * We do assign a handle though, as the AWS can't handle the lables without having a handle.
-         */
-        object_handle = DevicePrivateKey;
-    }
-    else if(0 == memcmp( pLabel,
-                         &LABEL_ROOT_CERTIFICATE,
-                         sizeof( LABEL_ROOT_CERTIFICATE )))
-    {
-        object_handle = RootCertificate;
+        if(0 == strcmp( ( const char_t * ) pLabel, xP11Context.xObjectList.xDirectory[ ucIndex ].pcLabel ))
+        {
+            return xP11Context.xObjectList.xDirectory[ ucIndex ].xHandle;
+        }
     }
 
-    return object_handle;
+    return InvalidHandle;
 }
 
 /*
@@ -678,90 +827,109 @@ static uint32_t prvGetObjectValue( CK_OBJECT_HANDLE object_handle, uint8_t **  p
     uint32_t xResult = CKR_OK;
     optiga_lib_status_t xReturn;
     uint32_t lOptigaOid = 0;
-    char_t* xEnd = NULL;
+    const P11DirectoryEntry_t * pxEntry;
     uint8_t xOffset = 0;
+    uint32_t ulAllocSize = pkcs11OBJECT_CERTIFICATE_MAX_SIZE;
+    uint16_t usKeyAlgorithm;
+    uint16_t usUsedSize;
     cy_rslt_t result = CY_RSLT_SUCCESS;
     *pIsPrivate = CK_FALSE;
+    *ppucData = NULL;
+
+    pxEntry = prvGetDirectoryEntry( object_handle );
+
+    switch (object_handle)
+    {
+        case RootCertificate:
+        case DeviceCertificate:
+            lOptigaOid = (pxEntry != NULL) ? pxEntry->usOid : 0;
+            break;
+        case DevicePublicKey:
+        case CodeSigningKey:
+            /*
+             * We are not handling DevicePublicKey and CodeSigningKey now
+             */
+        case DevicePrivateKey:
+            /*
+             * This operation isn't supported for the OPTIGA(TM) Trust M due to a security considerations
+             * You can only generate a key-pair and export a private component if you like
+             */
+        default:
+            xResult = CKR_KEY_HANDLE_INVALID;
+            break;
+    }
+
+    if(NULL == pulDataSize)
+    {
+        return CKR_ARGUMENTS_BAD;
+    }
+
+    if((0 == lOptigaOid) || (USHRT_MAX <= lOptigaOid))
+    {
+        return xResult;
+    }
+
+    result = cy_rtos_get_mutex(&xP11Context.xObjectList.xOptigaMutex, CY_RTOS_NEVER_TIMEOUT);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        PKCS11_INFO_PRINT("Error Acquiring Mutex : %lu\r\n",result );
+        return CY_RSLT_TYPE_ERROR;
+    }
+
+    /* The object may have been written since the directory was built, so
+     * size the buffer from its current used size and fall back to the
+     * maximum when the metadata cannot be read. Holding the mutex keeps the
+     * object from changing before it is read. */
+    if((CKR_OK == prvReadObjectMetadata( (uint16_t) lOptigaOid, &usKeyAlgorithm, &usUsedSize )) &&
+       (usUsedSize != 0) && (usUsedSize <= pkcs11OBJECT_CERTIFICATE_MAX_SIZE))
+    {
+        ulAllocSize = usUsedSize;
+    }
 
     /* Allocate buffer for a certificate/certificate chain Objects.
      * This data is later should be freed with prvGetObjectValueCleanup
      */
-    *ppucData = PKCS11_MALLOC( pkcs11OBJECT_CERTIFICATE_MAX_SIZE );
-    if(NULL != *ppucData && NULL != pulDataSize)
+    *ppucData = PKCS11_MALLOC( ulAllocSize );
+    if(NULL != *ppucData)
     {
-        *pulDataSize = pkcs11OBJECT_CERTIFICATE_MAX_SIZE;
-        *pIsPrivate = CK_FALSE;
+        *pulDataSize = ulAllocSize;
 
-        switch (object_handle)
-        {
-            case RootCertificate:
-                lOptigaOid = strtol(LABEL_ROOT_CERTIFICATE, &xEnd, 16);
-                break;
-            case DeviceCertificate:
-                lOptigaOid = strtol(LABEL_DEVICE_CERTIFICATE_FOR_TLS, &xEnd, 16);
-                break;
-            case DevicePublicKey:
-            case CodeSigningKey:
-                /*
-                 * We are not handling DevicePublicKey and CodeSigningKey now
-                 */
-            case DevicePrivateKey:
-                /*
-                 * This operation isn't supported for the OPTIGA(TM) Trust M due to a security considerations
-                 * You can only generate a key-pair and export a private component if you like
-                 */
-            default:
-                xResult = CKR_KEY_HANDLE_INVALID;
-                break;
-        }
+        P11CTX_SET_OPTIGA_LIB_STATUS_BUSY;
+        xReturn = optiga_util_read_data(xP11Context.xObjectList.optigaUtilInst,
+                                        lOptigaOid,
+                                        xOffset,
+                                        *ppucData,
+                                        (uint16_t*)pulDataSize);
 
-        if((0 != lOptigaOid) && (USHRT_MAX > lOptigaOid))
+        if (OPTIGA_LIB_SUCCESS == xReturn)
         {
-            result = cy_rtos_get_mutex(&xP11Context.xObjectList.xOptigaMutex, CY_RTOS_NEVER_TIMEOUT);
-            if (result != CY_RSLT_SUCCESS)
+            P11CTX_WAIT_FOR_OPTIGA_STATUS;
+
+            /* If the first byte is TLS Identity Tag, than we need to skip 9 bytes */
+            if(object_handle == DeviceCertificate && *ppucData[0] == OPTIGA_TLS_IDENTITY_TAG)
             {
-                PKCS11_INFO_PRINT("Error Acquiring Mutex : %lu\r\n",result );
-                return CY_RSLT_TYPE_ERROR;
+                xOffset = OPTIGA_TLS_IDENTITY_TAG_LEN;
             }
 
-            P11CTX_SET_OPTIGA_LIB_STATUS_BUSY;
-            xReturn = optiga_util_read_data(xP11Context.xObjectList.optigaUtilInst,
-                                            lOptigaOid,
-                                            xOffset,
-                                            *ppucData,
-                                            (uint16_t*)pulDataSize);
-
-            if (OPTIGA_LIB_SUCCESS == xReturn)
+            if(OPTIGA_LIB_SUCCESS != xP11Context.xObjectList.optigaLibStatus)
             {
-                P11CTX_WAIT_FOR_OPTIGA_STATUS;
-
-                /* If the first byte is TLS Identity Tag, than we need to skip 9 bytes */
-                if(object_handle == DeviceCertificate && *ppucData[0] == OPTIGA_TLS_IDENTITY_TAG)
-                {
-                    xOffset = OPTIGA_TLS_IDENTITY_TAG_LEN;
-                }
-
-                if(OPTIGA_LIB_SUCCESS != xP11Context.xObjectList.optigaLibStatus)
-                {
-                    PKCS11_FREE(*ppucData);
-                    *ppucData = NULL;
-                    *pulDataSize = 0;
-                    xResult = CKR_KEY_HANDLE_INVALID;
-                }
-                else
-                {
-                    if(xOffset != 0)
-                    {
-                        *pulDataSize -= xOffset;
-                        memmove(*ppucData, *ppucData+xOffset, *pulDataSize);
-                    }
-                }
+                PKCS11_FREE(*ppucData);
+                *ppucData = NULL;
+                *pulDataSize = 0;
+                xResult = CKR_KEY_HANDLE_INVALID;
             }
             else
             {
-                PKCS11_INFO_PRINT("Read Data Failed %u %lu\r\n", xReturn, object_handle);
+                if(xOffset != 0)
+                {
+                    *pulDataSize -= xOffset;
+                    memmove(*ppucData, *ppucData+xOffset, *pulDataSize);
+                }
             }
-            cy_rtos_set_mutex(&xP11Context.xObjectList.xOptigaMutex);
+        }
+        else
+        {
+            PKCS11_INFO_PRINT("Read Data Failed %u %lu\r\n", xReturn, object_handle);
         }
     }
     else
@@ -769,6 +937,9 @@ static uint32_t prvGetObjectValue( CK_OBJECT_HANDLE object_handle, uint8_t **  p
         /* Failed to allocate memory to the buffer */
         xResult = CKR_DEVICE_MEMORY;
     }
+
+    cy_rtos_set_mutex(&xP11Context.xObjectList.xOptigaMutex);
+
     return xResult;
 }
 
@@ -1002,6 +1173,8 @@ static CK_RV prvOptiga_Initialize( void )
                     }
                 }
 
+                prvBuildObjectDirectory();
+
             }while(FALSE);
 
             PKCS11_INFO_PRINT("PKCS #11 Object Status : 0x%x\r\n", xP11Context.xObjectList.optigaLibStatus);
@@ -1309,6 +1482,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
     uint8_t ucP384Oid[] = pkcs11DER_ENCODED_OID_P384;
     uint8_t ucP521Oid[] = pkcs11DER_ENCODED_OID_P521;
     CK_OBJECT_HANDLE xPalHandle = CK_INVALID_HANDLE;
+    const P11DirectoryEntry_t * pxEntry = NULL;
     size_t xSize;
     uint8_t * pcLabel = NULL;
     uint32_t ulLength = pkcs11OBJECT_MAX_SIZE;
@@ -1330,6 +1504,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
          * xSize is ignored.
          */
         prvFindObjectInListByHandle( xObject, &xPalHandle, &pcLabel, &xSize );
+        pxEntry = prvGetDirectoryEntry( xPalHandle );
 
         if(xPalHandle != CK_INVALID_HANDLE && xPalHandle != DevicePrivateKey)
         {
@@ -1356,23 +1531,19 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
                     {
                         if(pxTemplate[ iAttrib ].ulValueLen >= sizeof(CK_OBJECT_CLASS))
                         {
-                            switch (( P11ObjectHandles_t ) xPalHandle)
+                            if(pxEntry != NULL)
+                            {
+                                xClass = pxEntry->xClass;
+                            }
+                            else if(DevicePublicKey == ( P11ObjectHandles_t ) xPalHandle)
+                            {
+                                /* Has no object of its own on the chip, so no
+                                 * directory entry, but keeps its class. */
+                                xClass = CKO_PUBLIC_KEY;
+                            }
+                            else
                             {
-                                case DevicePrivateKey:
-                                    xClass = CKO_PRIVATE_KEY;
-                                    break;
-                                case DevicePublicKey:
-                                    xClass = CKO_PUBLIC_KEY;
-                                    break;
-                                case DeviceCertificate:
-                                    xClass = CKO_CERTIFICATE;
-                                    break;
-                                case RootCertificate:
-                                    xClass = CKO_CERTIFICATE;
-                                    break;
-                                default:
-                                    xResult = CKR_DATA_INVALID;
-                                    break;
+                                xResult = CKR_DATA_INVALID;
                             }
                             memcpy( pxTemplate[ iAttrib ].pValue, &xClass, sizeof( CK_OBJECT_CLASS ) );
                         }
@@ -1421,41 +1592,15 @@ CK_DEFINE_FUNCTION( CK_RV, C_GetAttributeValue )( CK_SESSION_HANDLE xSession,
                         {
                             xResult = CKR_FUNCTION_FAILED;
                         }
+                        else if(pxEntry == NULL)
+                        {
+                            xResult = CKR_DATA_INVALID;
+                        }
                         else
                         {
-                            char_t *xEnd = NULL;
-                            uint16_t oid = (uint16_t) strtol((char_t*)pcLabel, &xEnd, 16);
-
-                            session->xKeyType = prvGetKeyAlgorithm(xP11Context.xObjectList.optigaUtilInst, oid);
+                            session->xKeyType = pxEntry->usKeyAlgorithm;
+                            xPkcsKeyType = pxEntry->xKeyType;
 
-                            switch(session->xKeyType)
-                            {
-                                case OPTIGA_ECC_CURVE_NIST_P_256:
-                                case OPTIGA_ECC_CURVE_NIST_P_384:
-#ifdef OPTIGA_CRYPT_ECC_NIST_P_521_ENABLED
-                                case OPTIGA_ECC_CURVE_NIST_P_521:
-#endif
-#ifdef OPTIGA_CRYPT_ECC_BRAINPOOL_P_R1_ENABLED
-                                case OPTIGA_ECC_CURVE_BRAIN_POOL_P_256R1:
-                                case OPTIGA_ECC_CURVE_BRAIN_POOL_P_384R1:
-                                case OPTIGA_ECC_CURVE_BRAIN_POOL_P_512R1:
-#endif
-                                    xPkcsKeyType = CKK_EC;
-                                    break;
-
-                                case OPTIGA_RSA_KEY_1024_BIT_EXPONENTIAL:
-                                case OPTIGA_RSA_KEY_2048_BIT_EXPONENTIAL:
-                                    xPkcsKeyType = CKK_RSA;
-                                    break;
-
-#ifdef OPTIGA_CRYPT_SYM_GENERATE_KEY_ENABLED
-                                case OPTIGA_SYMMETRIC_AES_128:
-                                case OPTIGA_SYMMETRIC_AES_192:
-                                case OPTIGA_SYMMETRIC_AES_256:
-                                    xPkcsKeyType = CKK_AES;
-                                    break;
-#endif
-                                }
                             if( xResult == CKR_OK )
                             {
                                 memcpy( pxTemplate[ iAttrib ].pValue, &xPkcsKeyType, sizeof( CK_KEY_TYPE ) );
@@ -1772,8 +1917,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
     CK_OBJECT_HANDLE xPalHandle;
     uint8_t * pcLabel = NULL;
     size_t xLabelLength = 0;
-    uint32_t lOptigaOid = 0;
-    char_t* xEnd = NULL;
+    const P11DirectoryEntry_t * pxEntry;
 
     P11SessionPtr_t pxSession = prvSessionPointerFromHandle( xSession );
 
@@ -1802,10 +1946,11 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
              */
             if(xPalHandle == DevicePrivateKey)
             {
-                lOptigaOid = strtol((char_t*)pcLabel, &xEnd, 16);
-                if (0 != lOptigaOid)
+                pxEntry = prvGetDirectoryEntry( xPalHandle );
+                if((pxEntry != NULL) && (0 != pxEntry->usOid))
                 {
-                    pxSession->xSignKeyOid = (uint16_t) lOptigaOid;
+                    pxSession->xSignKeyOid = pxEntry->usOid;
+                    pxSession->xKeyType = pxEntry->usKeyAlgorithm;
                 }
                 else
                 {
@@ -1815,7 +1960,8 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
             }
 
             /* Check that the mechanism and key type are compatible, supported. */
-            if((pxMechanism->mechanism != CKM_ECDSA) && (prvCheckValidRSASignatureScheme(pxMechanism->mechanism)))
+            if((pxMechanism->mechanism != CKM_ECDSA) && (pxMechanism->mechanism != CKM_OPTIGA_ECDSA_DER) &&
+               (prvCheckValidRSASignatureScheme(pxMechanism->mechanism)))
             {
                 PKCS11_ERROR_PRINT("Unsupported mechanism type %ld. \r\n", pxMechanism->mechanism);
                 xResult = CKR_MECHANISM_INVALID;
@@ -1845,6 +1991,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
     /* Signature Length + 3x2 bytes reserved for DER tags */
     uint8_t ecSignature[ pkcs11ECDSA_P521_SIGNATURE_LENGTH + 3 + 3 ];
     uint16_t ecSignatureLength = sizeof(ecSignature);
+    uint8_t ucDerHeaderLength = 0;
     optiga_rsa_signature_scheme_t rsa_signature_scheme;
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
@@ -1863,7 +2010,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
         do
         {
             /* Update the signature length. */
-            if(session->xSignMechanism == CKM_ECDSA)
+            if((session->xSignMechanism == CKM_ECDSA) || (session->xSignMechanism == CKM_OPTIGA_ECDSA_DER))
             {
                 if(session->xKeyType == OPTIGA_ECC_CURVE_NIST_P_256)
                 {
@@ -1884,6 +2031,16 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
                     xResult = CKR_ARGUMENTS_BAD;
                     break;
                 }
+
+                if(session->xSignMechanism == CKM_OPTIGA_ECDSA_DER)
+                {
+                    /* The INTEGERs are written straight into the output, behind
+                     * room for the SEQUENCE header, which needs the long form
+                     * length once the signature may exceed 127 bytes.
+                     */
+                    xSignatureLength = pkcs11ECDSA_DER_SIGNATURE_MAX_LENGTH(xSignatureLength);
+                    ucDerHeaderLength = ((xSignatureLength - 2) > DER_INTEGER_MAX_LEN) ? 3 : 2;
+                }
             }
             else if(CKR_OK == prvCheckValidRSASignatureScheme(session->xSignMechanism))
             {
@@ -1906,6 +2063,14 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
                 xResult = CKR_ARGUMENTS_BAD;
             }
 
+            /* Without a signature buffer the caller only asks for the length,
+             * and the operation stays active for the actual call. */
+            if((CKR_OK == xResult) && (NULL == pucSignature))
+            {
+                *pulSignatureLen = xSignatureLength;
+                break;
+            }
+
             /* Check that the signature buffer is long enough. */
             if(*pulSignatureLen < xSignatureLength)
             {
@@ -1934,6 +2099,18 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
                                                       (optiga_key_id_t) session->xSignKeyOid,
                                                       ecSignature,
                                                       &ecSignatureLength);
+#endif
+                }
+                else if(session->xSignMechanism == CKM_OPTIGA_ECDSA_DER)
+                {
+#ifdef OPTIGA_CRYPT_ECDSA_SIGN_ENABLED
+                    ecSignatureLength = (uint16_t)(xSignatureLength - ucDerHeaderLength);
+                    xResult = optiga_crypt_ecdsa_sign(xP11Context.xObjectList.optigaCryptInst,
+                                                      pucData,
+                                                      ulDataLen,
+                                                      (optiga_key_id_t) session->xSignKeyOid,
+                                                      pucSignature + ucDerHeaderLength,
+                                                      &ecSignatureLength);
 #endif
                 }
                 else if(CKR_OK == prvSetValidRSASignatureScheme(session->xSignMechanism, &rsa_signature_scheme))
@@ -1981,6 +2158,10 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
                 prvAsn1ToEcdsaRS(ecSignature, ecSignatureLength, pucSignature, xSignatureLength);
                 *pulSignatureLen = xSignatureLength;
             }
+            else if(session->xSignMechanism == CKM_OPTIGA_ECDSA_DER)
+            {
+                *pulSignatureLen = prvWrapEcdsaSignatureInSequence(pucSignature, ucDerHeaderLength, ecSignatureLength);
+            }
 
             /* Complete the operation in the context. */
             if(xResult != CKR_BUFFER_TOO_SMALL)
@@ -2001,6 +2182,9 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignFinal)( CK_SESSION_HANDLE xSession,
 
 /**
  * @brief Generate cryptographically random bytes.
+ *
+ * Served from the shared entropy pool, which is seeded from the OPTIGA TRNG
+ * in large blocks, so a call does not cost an I2C round trip.
  */
 CK_DEFINE_FUNCTION( CK_RV, C_GenerateRandom )( CK_SESSION_HANDLE xSession,
                                                CK_BYTE_PTR pucRandomData,
@@ -2008,48 +2192,17 @@ CK_DEFINE_FUNCTION( CK_RV, C_GenerateRandom )( CK_SESSION_HANDLE xSession,
 {
 
     CK_RV xResult = CKR_OK;
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    PKCS11_UNUSED_PARAM (xSession);
 
     if((NULL == pucRandomData) || ( ulRandomLen == 0 ))
     {
         xResult = CKR_ARGUMENTS_BAD;
     }
-    else
+    else if(CY_RSLT_SUCCESS != entropy_pool_get_bytes(pucRandomData, ulRandomLen))
     {
-        result = cy_rtos_get_mutex(&xP11Context.xObjectList.xOptigaMutex, CY_RTOS_NEVER_TIMEOUT);
-        if(result != CY_RSLT_SUCCESS)
-        {
-            PKCS11_ERROR_PRINT("Error Acquiring Mutex : %lu\r\n", result);
-            return CKR_FUNCTION_FAILED;
-        }
-
-        P11CTX_SET_OPTIGA_LIB_STATUS_BUSY;
-
-#ifdef OPTIGA_CRYPT_RANDOM_ENABLED
-        xResult = optiga_crypt_random(xP11Context.xObjectList.optigaCryptInst,
-                                      OPTIGA_RNG_TYPE_TRNG,
-                                      pucRandomData,
-                                      ulRandomLen);
-#else
-        xResult = OPTIGA_CRYPT_ERROR;
-#endif
-        if(OPTIGA_LIB_SUCCESS != xResult)
-        {
-            PKCS11_ERROR_PRINT("Failed to generate random number\r\n");
-            xResult = CKR_FUNCTION_FAILED;
-        }
-        else
-        {
-            P11CTX_WAIT_FOR_OPTIGA_STATUS;
-
-            if(OPTIGA_LIB_SUCCESS != xP11Context.xObjectList.optigaLibStatus)
-            {
-                PKCS11_ERROR_PRINT("Generate a random number failed : 0x%x\r\n",
-                                    xP11Context.xObjectList.optigaLibStatus);
-                xResult = CKR_FUNCTION_FAILED;
-            }
-        }
-        cy_rtos_set_mutex(&xP11Context.xObjectList.xOptigaMutex);
+        PKCS11_ERROR_PRINT("Failed to generate random number\r\n");
+        xResult = CKR_FUNCTION_FAILED;
     }
     return xResult;
 }
@@ -115,6 +115,21 @@
 #define pkcs11ECDSA_P521_SIGNATURE_LENGTH       132
 #include "pkcs11.h"
 
+/**
+ * @brief Vendor defined mechanism for ECDSA with a DER encoded result.
+ *
+ * Takes the same input as CKM_ECDSA, but C_Sign returns the ECDSA-Sig-Value
+ * SEQUENCE produced by the OPTIGA(TM) Trust M instead of raw R || S. This is
+ * the format mbedTLS expects, so the TLS layer can use it without re-encoding.
+ */
+#define CKM_OPTIGA_ECDSA_DER                    ( CKM_VENDOR_DEFINED | 0x00000001UL )
+
+/**
+ * @brief Largest DER encoded ECDSA signature for a raw R || S length:
+ * the INTEGER headers plus a leading zero per component and the SEQUENCE header.
+ */
+#define pkcs11ECDSA_DER_SIGNATURE_MAX_LENGTH( xRSLength )  ( ( xRSLength ) + 6 + 3 )
+
 /* System dependencies.  */
 #if defined(_WIN32) || defined(CRYPTOKI_FORCE_WIN32)
 #pragma pack(pop, cryptoki)
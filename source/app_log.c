@@ -0,0 +1,268 @@
+/******************************************************************************
+* File Name:   app_log.c
+*
+* Description: This file contains the deferred logger. Producers reserve a
+*              record in a bounded lock-free ring buffer with a compare and
+*              swap, so logging from the MQTT callbacks costs a few stores
+*              instead of a UART transfer. A low priority task formats the
+*              records and prints them.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_log.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#define APP_LOG_RING_MASK                   (APP_LOG_RING_RECORDS - 1u)
+
+#if (APP_LOG_RING_RECORDS == 0u) || ((APP_LOG_RING_RECORDS & APP_LOG_RING_MASK) != 0u)
+#error "APP_LOG_RING_RECORDS must be a power of two"
+#endif
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+/* A record is free for the producer at position 'pos' when its sequence is
+ * 'pos', and ready for the drain task when it is 'pos + 1'. The sequence is
+ * stored relative to the record index so that the zero initialised ring is
+ * already valid and APP_LOG() works before app_log_init().
+ */
+typedef struct
+{
+    uint32_t    seq;
+    const char  *fmt;
+    uintptr_t   args[APP_LOG_MAX_ARGS];
+} app_log_record_t;
+
+static app_log_record_t app_log_ring[APP_LOG_RING_RECORDS];
+static uint32_t app_log_head = 0;       /* Next position to reserve */
+static uint32_t app_log_tail = 0;       /* Next position to drain */
+static uint32_t app_log_overruns = 0;
+static TaskHandle_t app_log_task_handle = NULL;
+
+/******************************************************************************
+ * Function Name: app_log_write
+ ******************************************************************************
+ * Summary:
+ *  Stores a record in the ring buffer. Use it through APP_LOG().
+ *
+ * Parameters:
+ *  const char *fmt : printf style format string literal
+ *  uintptr_t a, b, c, d : Arguments of the format string
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void app_log_write(const char *fmt, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d)
+{
+    app_log_record_t *record;
+    uint32_t pos = __atomic_load_n(&app_log_head, __ATOMIC_RELAXED);
+    uint32_t index;
+    int32_t diff;
+
+    while (true)
+    {
+        index = pos & APP_LOG_RING_MASK;
+        record = &app_log_ring[index];
+        diff = (int32_t) (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) + index - pos);
+
+        if (0 == diff)
+        {
+            /* The record is free, try to claim it. On failure 'pos' is
+             * reloaded with the current head. */
+            if (__atomic_compare_exchange_n(&app_log_head, &pos, pos + 1u, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* The drain task has not caught up, drop the record. */
+            __atomic_fetch_add(&app_log_overruns, 1u, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n(&app_log_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    record->fmt = fmt;
+    record->args[0] = a;
+    record->args[1] = b;
+    record->args[2] = c;
+    record->args[3] = d;
+
+    /* Hand the record to the drain task. */
+    __atomic_store_n(&record->seq, pos + 1u - index, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * Function Name: app_log_get_overruns
+ ******************************************************************************
+ * Summary:
+ *  Returns the number of records dropped because the ring buffer was full.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Number of dropped records since start up.
+ *
+ ******************************************************************************/
+uint32_t app_log_get_overruns(void)
+{
+    return __atomic_load_n(&app_log_overruns, __ATOMIC_RELAXED);
+}
+
+/******************************************************************************
+ * Function Name: app_log_drain
+ ******************************************************************************
+ * Summary:
+ *  Formats and prints all records that are ready. Only the drain task calls
+ *  this, so the tail needs no synchronisation.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void app_log_drain(void)
+{
+    app_log_record_t *record;
+    app_log_record_t copy;
+    uint32_t index;
+
+    while (true)
+    {
+        index = app_log_tail & APP_LOG_RING_MASK;
+        record = &app_log_ring[index];
+
+        if ((__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) + index) != (app_log_tail + 1u))
+        {
+            break;
+        }
+
+        /* Copy the record out and release it before the slow printf. */
+        copy = *record;
+        __atomic_store_n(&record->seq, app_log_tail + APP_LOG_RING_RECORDS - index, __ATOMIC_RELEASE);
+        app_log_tail++;
+
+        printf(copy.fmt, copy.args[0], copy.args[1], copy.args[2], copy.args[3]);
+    }
+}
+
+/******************************************************************************
+ * Function Name: app_log_task
+ ******************************************************************************
+ * Summary:
+ *  Low priority task that drains the ring buffer every
+ *  APP_LOG_DRAIN_INTERVAL_MS and reports dropped records.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void app_log_task(void *pvParameters)
+{
+    uint32_t reported_overruns = 0;
+    uint32_t overruns;
+
+    (void) pvParameters;
+
+    while (true)
+    {
+        app_log_drain();
+
+        overruns = app_log_get_overruns();
+        if (overruns != reported_overruns)
+        {
+            printf("Log: %lu records dropped!\n", (unsigned long) (overruns - reported_overruns));
+            reported_overruns = overruns;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(APP_LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+/******************************************************************************
+ * Function Name: app_log_init
+ ******************************************************************************
+ * Summary:
+ *  Starts the drain task. Records logged before this call are printed once
+ *  the task runs.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t app_log_init(void)
+{
+    if (NULL != app_log_task_handle)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (pdPASS != xTaskCreate(app_log_task, "Log", APP_LOG_TASK_STACK_SIZE,
+                              NULL, APP_LOG_TASK_PRIORITY, &app_log_task_handle))
+    {
+        printf("Log: failed to create the drain task!\n");
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   app_log.h
+*
+* Description: This file contains the declarations of the deferred logger.
+*              APP_LOG() stores a binary record of a format string and its
+*              arguments in a lock-free ring buffer, and a low priority task
+*              formats and prints the records later.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef APP_LOG_H_
+#define APP_LOG_H_
+
+#include <stdint.h>
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of records in the ring buffer, must be a power of two. A record takes
+ * 24 bytes.
+ */
+#ifndef APP_LOG_RING_RECORDS
+#define APP_LOG_RING_RECORDS                (32u)
+#endif
+
+/* Interval in milliseconds at which the drain task empties the ring buffer. */
+#ifndef APP_LOG_DRAIN_INTERVAL_MS
+#define APP_LOG_DRAIN_INTERVAL_MS           (50u)
+#endif
+
+/* Maximum number of arguments of a record. */
+#define APP_LOG_MAX_ARGS                    (4u)
+
+/* Task parameters for the drain task. */
+#define APP_LOG_TASK_PRIORITY               (1)
+#define APP_LOG_TASK_STACK_SIZE             (1024 * 1)
+
+/* Logs a printf style message without formatting it. Only the address of the
+ * format string and up to APP_LOG_MAX_ARGS integer arguments are stored, so
+ *  - the format must be a string literal,
+ *  - the arguments must be integers of at most 32 bits or pointers to strings
+ *    that stay valid, such as literals; no floating point and no %.*s.
+ * Callable from tasks, callbacks and interrupts. If the ring buffer is full
+ * the record is dropped and counted.
+ */
+#define APP_LOG(...)                        APP_LOG_RECORD(__VA_ARGS__, 0, 0, 0, 0, 0)
+#define APP_LOG_RECORD(fmt, a, b, c, d, ...) \
+    app_log_write("" fmt, (uintptr_t) (a), (uintptr_t) (b), (uintptr_t) (c), (uintptr_t) (d))
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t app_log_init(void);
+void app_log_write(const char *fmt, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d);
+uint32_t app_log_get_overruns(void);
+
+#endif /* APP_LOG_H_ */
+
+/* [] END OF FILE */
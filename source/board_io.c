@@ -0,0 +1,213 @@
+/******************************************************************************
+* File Name:   board_io.c
+*
+* Description: This file contains the HAL implementation of the user LED,
+*              the user button and the cycle counter used by the publisher
+*              and subscriber tasks.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "cyhal.h"
+#include "cybsp.h"
+#include "board_io.h"
+#include "subscriber_task.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Interrupt priority for User Button Input. */
+#define USER_BTN_INTR_PRIORITY          (3)
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event);
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Structure that stores the callback data for the GPIO interrupt event. */
+static cyhal_gpio_callback_data_t cb_data =
+{
+    .callback = isr_button_press,
+    .callback_arg = NULL
+};
+
+/* Handler registered by board_button_enable(). */
+static board_button_handler_t button_handler = NULL;
+
+/******************************************************************************
+ * Function Name: board_led_init
+ ******************************************************************************
+ * Summary:
+ *  Initializes the user LED GPIO, with the LED off.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void board_led_init(void)
+{
+    cyhal_gpio_init(CYBSP_USER_LED, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_PULLUP,
+                    CYBSP_LED_STATE_OFF);
+}
+
+/******************************************************************************
+ * Function Name: board_led_write
+ ******************************************************************************
+ * Summary:
+ *  Shows the device state on the user LED.
+ *
+ * Parameters:
+ *  uint32_t device_state : DEVICE_ON_STATE or DEVICE_OFF_STATE
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void board_led_write(uint32_t device_state)
+{
+    /* The LED is active low, which is how the device states are defined. */
+    cyhal_gpio_write(CYBSP_USER_LED, (DEVICE_ON_STATE == device_state) ?
+                     CYBSP_LED_STATE_ON : CYBSP_LED_STATE_OFF);
+}
+
+/******************************************************************************
+ * Function Name: board_button_enable
+ ******************************************************************************
+ * Summary:
+ *  Initializes the user button GPIO and calls 'handler' from its interrupt on
+ *  every falling edge.
+ *
+ * Parameters:
+ *  board_button_handler_t handler : Function to call on a button press
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void board_button_enable(board_button_handler_t handler)
+{
+    button_handler = handler;
+
+    /* Initialize the user button GPIO and register interrupt on falling edge. */
+    cyhal_gpio_init(CYBSP_USER_BTN, CYHAL_GPIO_DIR_INPUT,
+                    CYHAL_GPIO_DRIVE_PULLUP, CYBSP_BTN_OFF);
+    cyhal_gpio_register_callback(CYBSP_USER_BTN, &cb_data);
+    cyhal_gpio_enable_event(CYBSP_USER_BTN, CYHAL_GPIO_IRQ_FALL,
+                            USER_BTN_INTR_PRIORITY, true);
+}
+
+/******************************************************************************
+ * Function Name: board_button_disable
+ ******************************************************************************
+ * Summary:
+ *  Disables the user button interrupt and deinits the user button GPIO pin.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void board_button_disable(void)
+{
+    /* Deregister the ISR and disable the interrupt on the user button. */
+    cyhal_gpio_register_callback(CYBSP_USER_BTN, &cb_data);
+    cyhal_gpio_enable_event(CYBSP_USER_BTN, CYHAL_GPIO_IRQ_FALL,
+                            USER_BTN_INTR_PRIORITY, false);
+    cyhal_gpio_free(CYBSP_USER_BTN);
+}
+
+/******************************************************************************
+ * Function Name: board_cycle_count
+ ******************************************************************************
+ * Summary:
+ *  Returns the CPU cycle counter, starting it on first use. It stops in deep
+ *  sleep and wraps after about 28 seconds at 150 MHz, so it is only meant for
+ *  timing short stretches of code.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Current cycle count
+ *
+ ******************************************************************************/
+uint32_t board_cycle_count(void)
+{
+    if (0u == (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    return DWT->CYCCNT;
+}
+
+/******************************************************************************
+ * Function Name: isr_button_press
+ ******************************************************************************
+ * Summary:
+ *  GPIO interrupt service routine of the user button. Forwards the press to
+ *  the handler registered by board_button_enable().
+ *
+ * Parameters:
+ *  void *callback_arg : pointer to variable passed to the ISR (unused)
+ *  cyhal_gpio_event_t event : GPIO event type (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event)
+{
+    /* To avoid compiler warnings */
+    (void) callback_arg;
+    (void) event;
+
+    if (NULL != button_handler)
+    {
+        button_handler();
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/******************************************************************************
+* File Name:   board_io.h
+*
+* Description: This file contains the declarations of the board I/O used by
+*              the publisher and subscriber: the user LED that shows the
+*              device state and the user button that toggles it.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOARD_IO_H_
+#define BOARD_IO_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Called on every press of the user button. On the PSoC 6 kits this runs in
+ * the GPIO interrupt, so it must only use FromISR APIs.
+ */
+typedef void (*board_button_handler_t)(void);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+/* The publisher and subscriber tasks reach the board only through these
+ * functions. board_io.c implements them with the HAL; a port of the
+ * application to another platform provides its own implementation, see
+ * README.md for the other target-only modules such a port has to replace.
+ */
+void board_led_init(void);
+void board_led_write(uint32_t device_state);
+void board_button_enable(board_button_handler_t handler);
+void board_button_disable(void);
+uint32_t board_cycle_count(void);
+
+#endif /* BOARD_IO_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,667 @@
+/******************************************************************************
+* File Name:   cbor_codec.c
+*
+* Description: This file contains a streaming CBOR (RFC 8949) writer and an
+*              in-place reader. Both work on caller-supplied buffers and never
+*              allocate. Only definite lengths are produced and accepted,
+*              integers are limited to 32 bits.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <string.h>
+
+#include "cbor_codec.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Additional information values of the initial byte. */
+#define CBOR_AI_1BYTE                       (24u)
+#define CBOR_AI_2BYTES                      (25u)
+#define CBOR_AI_4BYTES                      (26u)
+#define CBOR_AI_8BYTES                      (27u)
+
+/* Simple values and floats of major type 7. */
+#define CBOR_FALSE                          (0xF4u)
+#define CBOR_TRUE                           (0xF5u)
+#define CBOR_NULL                           (0xF6u)
+#define CBOR_HALF                           (0xF9u)
+#define CBOR_SINGLE                         (0xFAu)
+#define CBOR_DOUBLE                         (0xFBu)
+
+/******************************************************************************
+ * Function Name: cbor_put_raw
+ ******************************************************************************
+ * Summary:
+ *  Appends bytes to the output, or marks the writer failed if they do not fit.
+ *
+ * Parameters:
+ *  cbor_writer_t *writer : Writer
+ *  const void *data : Bytes to append
+ *  size_t length : Number of bytes
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void cbor_put_raw(cbor_writer_t *writer, const void *data, size_t length)
+{
+    if (writer->error || (length > (writer->size - writer->length)))
+    {
+        writer->error = true;
+        return;
+    }
+
+    memcpy(&writer->buffer[writer->length], data, length);
+    writer->length += length;
+}
+
+/******************************************************************************
+ * Function Name: cbor_put_head
+ ******************************************************************************
+ * Summary:
+ *  Appends an initial byte with its argument in the shortest form.
+ *
+ * Parameters:
+ *  cbor_writer_t *writer : Writer
+ *  cbor_type_t type : Major type
+ *  uint32_t argument : Value, length or count
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void cbor_put_head(cbor_writer_t *writer, cbor_type_t type, uint32_t argument)
+{
+    uint8_t head[CBOR_HEADER_MAX_SIZE];
+    size_t length;
+    uint8_t major = (uint8_t)((uint32_t) type << 5);
+
+    if (argument < CBOR_AI_1BYTE)
+    {
+        head[0] = major | (uint8_t) argument;
+        length = 1;
+    }
+    else if (argument <= 0xFFu)
+    {
+        head[0] = major | CBOR_AI_1BYTE;
+        head[1] = (uint8_t) argument;
+        length = 2;
+    }
+    else if (argument <= 0xFFFFu)
+    {
+        head[0] = major | CBOR_AI_2BYTES;
+        head[1] = (uint8_t)(argument >> 8);
+        head[2] = (uint8_t) argument;
+        length = 3;
+    }
+    else
+    {
+        head[0] = major | CBOR_AI_4BYTES;
+        head[1] = (uint8_t)(argument >> 24);
+        head[2] = (uint8_t)(argument >> 16);
+        head[3] = (uint8_t)(argument >> 8);
+        head[4] = (uint8_t) argument;
+        length = 5;
+    }
+
+    cbor_put_raw(writer, head, length);
+}
+
+/******************************************************************************
+ * Function Name: cbor_writer_init
+ ******************************************************************************
+ * Summary:
+ *  Starts encoding into 'buffer'.
+ *
+ * Parameters:
+ *  cbor_writer_t *writer : Writer to initialize
+ *  uint8_t *buffer : Output buffer
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buffer, size_t size)
+{
+    writer->buffer = buffer;
+    writer->size = (NULL != buffer) ? size : 0u;
+    writer->length = 0;
+    writer->error = false;
+}
+
+/******************************************************************************
+ * Function Name: cbor_writer_finish
+ ******************************************************************************
+ * Summary:
+ *  Returns the length of the encoded data.
+ *
+ * Parameters:
+ *  const cbor_writer_t *writer : Writer
+ *
+ * Return:
+ *  size_t : Number of bytes written, or 0 if the buffer was too small.
+ *
+ ******************************************************************************/
+size_t cbor_writer_finish(const cbor_writer_t *writer)
+{
+    return writer->error ? 0u : writer->length;
+}
+
+void cbor_put_uint(cbor_writer_t *writer, uint32_t value)
+{
+    cbor_put_head(writer, CBOR_TYPE_UINT, value);
+}
+
+void cbor_put_int(cbor_writer_t *writer, int32_t value)
+{
+    if (value >= 0)
+    {
+        cbor_put_head(writer, CBOR_TYPE_UINT, (uint32_t) value);
+    }
+    else
+    {
+        /* -1 - value, which is the bitwise complement. */
+        cbor_put_head(writer, CBOR_TYPE_NEGINT, ~(uint32_t) value);
+    }
+}
+
+void cbor_put_bool(cbor_writer_t *writer, bool value)
+{
+    uint8_t byte = value ? CBOR_TRUE : CBOR_FALSE;
+
+    cbor_put_raw(writer, &byte, 1);
+}
+
+void cbor_put_float(cbor_writer_t *writer, float value)
+{
+    uint8_t encoded[CBOR_SIZE_float];
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    encoded[0] = CBOR_SINGLE;
+    encoded[1] = (uint8_t)(bits >> 24);
+    encoded[2] = (uint8_t)(bits >> 16);
+    encoded[3] = (uint8_t)(bits >> 8);
+    encoded[4] = (uint8_t) bits;
+
+    cbor_put_raw(writer, encoded, sizeof(encoded));
+}
+
+void cbor_put_null(cbor_writer_t *writer)
+{
+    uint8_t byte = CBOR_NULL;
+
+    cbor_put_raw(writer, &byte, 1);
+}
+
+void cbor_put_text(cbor_writer_t *writer, const char *text, size_t length)
+{
+    cbor_put_head(writer, CBOR_TYPE_TEXT, (uint32_t) length);
+    cbor_put_raw(writer, text, length);
+}
+
+void cbor_put_bytes(cbor_writer_t *writer, const void *data, size_t length)
+{
+    cbor_put_head(writer, CBOR_TYPE_BYTES, (uint32_t) length);
+    cbor_put_raw(writer, data, length);
+}
+
+/* Arrays and maps are followed by 'count' items, or 'count' key and value
+ * pairs, written with the other functions.
+ */
+void cbor_put_array(cbor_writer_t *writer, uint32_t count)
+{
+    cbor_put_head(writer, CBOR_TYPE_ARRAY, count);
+}
+
+void cbor_put_map(cbor_writer_t *writer, uint32_t count)
+{
+    cbor_put_head(writer, CBOR_TYPE_MAP, count);
+}
+
+/******************************************************************************
+ * Function Name: cbor_fail
+ ******************************************************************************
+ * Summary:
+ *  Marks the reader failed.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader
+ *
+ * Return:
+ *  bool : Always false, for use in return statements.
+ *
+ ******************************************************************************/
+static bool cbor_fail(cbor_reader_t *reader)
+{
+    reader->error = true;
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: cbor_get_head
+ ******************************************************************************
+ * Summary:
+ *  Consumes an initial byte and its argument. Indefinite lengths and the
+ *  reserved encodings are rejected.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader
+ *  cbor_type_t *type : Receives the major type
+ *  uint8_t *info : Receives the additional information (low five bits)
+ *  uint64_t *argument : Receives the value, length or count
+ *
+ * Return:
+ *  bool : true on success.
+ *
+ ******************************************************************************/
+static bool cbor_get_head(cbor_reader_t *reader, cbor_type_t *type, uint8_t *info, uint64_t *argument)
+{
+    size_t extra;
+    uint8_t initial;
+
+    if (reader->error || (reader->position >= reader->length))
+    {
+        return cbor_fail(reader);
+    }
+
+    initial = reader->buffer[reader->position++];
+    *type = (cbor_type_t)(initial >> 5);
+    *info = initial & 0x1Fu;
+
+    if (*info < CBOR_AI_1BYTE)
+    {
+        *argument = *info;
+        return true;
+    }
+    if (*info > CBOR_AI_8BYTES)
+    {
+        return cbor_fail(reader);
+    }
+
+    extra = (size_t) 1u << (*info - CBOR_AI_1BYTE);
+    if (extra > (reader->length - reader->position))
+    {
+        return cbor_fail(reader);
+    }
+
+    *argument = 0;
+    while (extra-- > 0u)
+    {
+        *argument = (*argument << 8) | reader->buffer[reader->position++];
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: cbor_get_typed
+ ******************************************************************************
+ * Summary:
+ *  Consumes an item of major type 'expected' whose argument fits 32 bits.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader
+ *  cbor_type_t expected : Major type the item must have
+ *  uint32_t *argument : Receives the value, length or count
+ *
+ * Return:
+ *  bool : true on success.
+ *
+ ******************************************************************************/
+static bool cbor_get_typed(cbor_reader_t *reader, cbor_type_t expected, uint32_t *argument)
+{
+    cbor_type_t type;
+    uint8_t info;
+    uint64_t value;
+
+    if (!cbor_get_head(reader, &type, &info, &value) || (type != expected) || (value > UINT32_MAX))
+    {
+        return cbor_fail(reader);
+    }
+
+    *argument = (uint32_t) value;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: cbor_get_string
+ ******************************************************************************
+ * Summary:
+ *  Consumes a byte or text string and returns where its content starts.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader
+ *  cbor_type_t expected : CBOR_TYPE_BYTES or CBOR_TYPE_TEXT
+ *  const uint8_t **data : Receives a pointer into the input
+ *  size_t *length : Receives the length of the content
+ *
+ * Return:
+ *  bool : true on success.
+ *
+ ******************************************************************************/
+static bool cbor_get_string(cbor_reader_t *reader, cbor_type_t expected, const uint8_t **data, size_t *length)
+{
+    uint32_t size;
+
+    if (!cbor_get_typed(reader, expected, &size) || (size > (reader->length - reader->position)))
+    {
+        return cbor_fail(reader);
+    }
+
+    *data = &reader->buffer[reader->position];
+    *length = size;
+    reader->position += size;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: cbor_half_to_float
+ ******************************************************************************
+ * Summary:
+ *  Widens an IEEE 754 half precision value, which other encoders use for
+ *  floats that fit it exactly.
+ *
+ * Parameters:
+ *  uint16_t half : Half precision bits
+ *
+ * Return:
+ *  float : The same value in single precision.
+ *
+ ******************************************************************************/
+static float cbor_half_to_float(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+    float value;
+
+    if (0u == exponent)
+    {
+        if (0u == mantissa)
+        {
+            bits = sign;
+        }
+        else
+        {
+            /* Subnormal: normalize it, single precision has the range. */
+            exponent = 127u - 15u + 1u;
+            while (0u == (mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+    }
+    else if (0x1Fu == exponent)
+    {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+    }
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/******************************************************************************
+ * Function Name: cbor_reader_init
+ ******************************************************************************
+ * Summary:
+ *  Starts decoding 'buffer'. The buffer must stay valid while strings
+ *  returned by the reader are in use.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader to initialize
+ *  const uint8_t *buffer : Encoded data
+ *  size_t length : Length of the encoded data
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buffer, size_t length)
+{
+    reader->buffer = buffer;
+    reader->length = (NULL != buffer) ? length : 0u;
+    reader->position = 0;
+    reader->error = false;
+}
+
+/******************************************************************************
+ * Function Name: cbor_peek_type
+ ******************************************************************************
+ * Summary:
+ *  Returns the major type of the next item without consuming it.
+ *
+ * Parameters:
+ *  const cbor_reader_t *reader : Reader
+ *
+ * Return:
+ *  cbor_type_t : Major type, or CBOR_TYPE_NONE at the end or after an error.
+ *
+ ******************************************************************************/
+cbor_type_t cbor_peek_type(const cbor_reader_t *reader)
+{
+    if (reader->error || (reader->position >= reader->length))
+    {
+        return CBOR_TYPE_NONE;
+    }
+
+    return (cbor_type_t)(reader->buffer[reader->position] >> 5);
+}
+
+/* The cbor_get_ functions consume one item and return false, leaving the
+ * reader failed, if it is not of the requested type or does not fit it.
+ */
+bool cbor_get_uint(cbor_reader_t *reader, uint32_t *value)
+{
+    return cbor_get_typed(reader, CBOR_TYPE_UINT, value);
+}
+
+bool cbor_get_int(cbor_reader_t *reader, int32_t *value)
+{
+    cbor_type_t type;
+    uint8_t info;
+    uint64_t argument;
+
+    if (!cbor_get_head(reader, &type, &info, &argument) || (argument > INT32_MAX))
+    {
+        return cbor_fail(reader);
+    }
+
+    if (CBOR_TYPE_UINT == type)
+    {
+        *value = (int32_t) argument;
+    }
+    else if (CBOR_TYPE_NEGINT == type)
+    {
+        *value = -1 - (int32_t) argument;
+    }
+    else
+    {
+        return cbor_fail(reader);
+    }
+
+    return true;
+}
+
+bool cbor_get_bool(cbor_reader_t *reader, bool *value)
+{
+    if ((CBOR_TYPE_SIMPLE != cbor_peek_type(reader)) ||
+        ((CBOR_TRUE != reader->buffer[reader->position]) && (CBOR_FALSE != reader->buffer[reader->position])))
+    {
+        return cbor_fail(reader);
+    }
+
+    *value = (CBOR_TRUE == reader->buffer[reader->position++]);
+    return true;
+}
+
+bool cbor_get_float(cbor_reader_t *reader, float *value)
+{
+    cbor_type_t type;
+    uint8_t info;
+    uint64_t bits;
+    uint32_t single;
+    double wide;
+
+    if (!cbor_get_head(reader, &type, &info, &bits) || (CBOR_TYPE_SIMPLE != type))
+    {
+        return cbor_fail(reader);
+    }
+
+    switch (info)
+    {
+        case CBOR_AI_2BYTES:
+            *value = cbor_half_to_float((uint16_t) bits);
+            break;
+
+        case CBOR_AI_4BYTES:
+            single = (uint32_t) bits;
+            memcpy(value, &single, sizeof(*value));
+            break;
+
+        case CBOR_AI_8BYTES:
+            memcpy(&wide, &bits, sizeof(wide));
+            *value = (float) wide;
+            break;
+
+        default:
+            return cbor_fail(reader);
+    }
+
+    return true;
+}
+
+bool cbor_get_text(cbor_reader_t *reader, const char **text, size_t *length)
+{
+    return cbor_get_string(reader, CBOR_TYPE_TEXT, (const uint8_t **) text, length);
+}
+
+bool cbor_get_bytes(cbor_reader_t *reader, const uint8_t **data, size_t *length)
+{
+    return cbor_get_string(reader, CBOR_TYPE_BYTES, data, length);
+}
+
+/* For arrays and maps the reader is left at the first item. */
+bool cbor_get_array(cbor_reader_t *reader, uint32_t *count)
+{
+    return cbor_get_typed(reader, CBOR_TYPE_ARRAY, count);
+}
+
+bool cbor_get_map(cbor_reader_t *reader, uint32_t *count)
+{
+    return cbor_get_typed(reader, CBOR_TYPE_MAP, count);
+}
+
+/******************************************************************************
+ * Function Name: cbor_skip
+ ******************************************************************************
+ * Summary:
+ *  Consumes the next item including everything nested in it, for example
+ *  the value of a map key the caller does not know. Works without recursion,
+ *  so hostile input cannot exhaust the stack.
+ *
+ * Parameters:
+ *  cbor_reader_t *reader : Reader
+ *
+ * Return:
+ *  bool : true on success.
+ *
+ ******************************************************************************/
+bool cbor_skip(cbor_reader_t *reader)
+{
+    cbor_type_t type;
+    uint8_t info;
+    uint64_t argument;
+    size_t pending = 1;
+
+    while (pending-- > 0u)
+    {
+        if (!cbor_get_head(reader, &type, &info, &argument))
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+            case CBOR_TYPE_BYTES:
+            case CBOR_TYPE_TEXT:
+                if (argument > (reader->length - reader->position))
+                {
+                    return cbor_fail(reader);
+                }
+                reader->position += (size_t) argument;
+                break;
+
+            case CBOR_TYPE_ARRAY:
+            case CBOR_TYPE_MAP:
+                if (argument > (reader->length - reader->position))
+                {
+                    return cbor_fail(reader);
+                }
+                pending += (size_t) argument * ((CBOR_TYPE_MAP == type) ? 2u : 1u);
+                break;
+
+            case CBOR_TYPE_TAG:
+                /* The tagged item follows. */
+                pending++;
+                break;
+
+            default:
+                break;
+        }
+
+        /* Every item takes at least one byte, which bounds the nesting. */
+        if (pending > (reader->length - reader->position))
+        {
+            return cbor_fail(reader);
+        }
+    }
+
+    return true;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,201 @@
+/******************************************************************************
+* File Name:   cbor_codec.h
+*
+* Description: This file contains the declarations of the CBOR (RFC 8949)
+*              writer and reader used for binary telemetry, and the helpers
+*              that define fixed record shapes at compile time.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef CBOR_CODEC_H_
+#define CBOR_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Largest encoded size of each value type, for sizing buffers at compile
+ * time. Integers are limited to 32 bits and floats are single precision.
+ */
+#define CBOR_HEADER_MAX_SIZE                (5u)
+#define CBOR_SIZE_uint                      (5u)
+#define CBOR_SIZE_int                       (5u)
+#define CBOR_SIZE_bool                      (1u)
+#define CBOR_SIZE_float                     (5u)
+#define CBOR_TEXT_MAX_SIZE(len)             (CBOR_HEADER_MAX_SIZE + (len))
+
+/* Record schemas. A record shape is listed once as entries
+ *
+ *     X(key, type, member)
+ *
+ * where 'key' is an integer below 24 and 'type' is one of uint, int, bool or
+ * float for a member of type uint32_t, int32_t, bool or float. For example
+ *
+ *     #define SENSOR_SCHEMA(X)  X(1, uint, uptime_ms) X(2, float, celsius)
+ *     CBOR_DEFINE_RECORD(sensor, sensor_t, SENSOR_SCHEMA)
+ *
+ * defines sensor_encode() and sensor_decode(), and
+ * CBOR_RECORD_MAX_SIZE(SENSOR_SCHEMA) is the buffer size that always fits.
+ * The record is a map keyed by the small integers, which keeps it compact
+ * and lets the decoder skip keys it does not know. Members whose key is
+ * missing from the input keep their value.
+ */
+#define CBOR_RECORD_MAX_SIZE(SCHEMA)        (1u SCHEMA(CBOR_FIELD_MAX_SIZE_))
+
+#define CBOR_FIELD_MAX_SIZE_(key, type, member) + 1u + CBOR_SIZE_##type
+#define CBOR_FIELD_COUNT_(key, type, member)    + 1u
+#define CBOR_FIELD_ENCODE_(key, type, member)                                   \
+    cbor_put_uint(writer, (key));                                               \
+    cbor_put_##type(writer, record->member);
+#define CBOR_FIELD_DECODE_(key, type, member)                                   \
+    case (key):                                                                 \
+        ok = cbor_get_##type(reader, &record->member);                          \
+        break;
+
+#define CBOR_DEFINE_RECORD(name, record_type, SCHEMA)                           \
+static inline size_t name##_encode(const record_type *record,                   \
+                                   uint8_t *buffer, size_t size)                \
+{                                                                               \
+    cbor_writer_t writer_state;                                                 \
+    cbor_writer_t *writer = &writer_state;                                      \
+                                                                                \
+    cbor_writer_init(writer, buffer, size);                                     \
+    cbor_put_map(writer, 0u SCHEMA(CBOR_FIELD_COUNT_));                         \
+    SCHEMA(CBOR_FIELD_ENCODE_)                                                  \
+    return cbor_writer_finish(writer);                                          \
+}                                                                               \
+static inline bool name##_decode(record_type *record,                           \
+                                 const uint8_t *buffer, size_t length)          \
+{                                                                               \
+    cbor_reader_t reader_state;                                                 \
+    cbor_reader_t *reader = &reader_state;                                      \
+    uint32_t count;                                                             \
+    uint32_t key;                                                               \
+    bool ok;                                                                    \
+                                                                                \
+    cbor_reader_init(reader, buffer, length);                                   \
+    ok = cbor_get_map(reader, &count);                                          \
+    while (ok && (count-- > 0u))                                                \
+    {                                                                           \
+        if (!cbor_get_uint(reader, &key))                                       \
+        {                                                                       \
+            return false;                                                       \
+        }                                                                       \
+        switch (key)                                                            \
+        {                                                                       \
+            SCHEMA(CBOR_FIELD_DECODE_)                                          \
+            default:                                                            \
+                ok = cbor_skip(reader);                                         \
+                break;                                                          \
+        }                                                                       \
+    }                                                                           \
+    return ok;                                                                  \
+}
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+/* CBOR major types. */
+typedef enum
+{
+    CBOR_TYPE_UINT = 0,
+    CBOR_TYPE_NEGINT = 1,
+    CBOR_TYPE_BYTES = 2,
+    CBOR_TYPE_TEXT = 3,
+    CBOR_TYPE_ARRAY = 4,
+    CBOR_TYPE_MAP = 5,
+    CBOR_TYPE_TAG = 6,
+    CBOR_TYPE_SIMPLE = 7,
+    CBOR_TYPE_NONE = 0xFF       /* End of input or error */
+} cbor_type_t;
+
+/* Encodes into a caller-supplied buffer. Running out of space is sticky:
+ * later writes are dropped and cbor_writer_finish() returns 0, so a
+ * sequence of writes needs only one check at the end.
+ */
+typedef struct
+{
+    uint8_t *buffer;
+    size_t size;
+    size_t length;
+    bool error;
+} cbor_writer_t;
+
+/* Decodes in place. Text and byte strings are returned as pointers into the
+ * input, nothing is copied. Errors are sticky as well.
+ */
+typedef struct
+{
+    const uint8_t *buffer;
+    size_t length;
+    size_t position;
+    bool error;
+} cbor_reader_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buffer, size_t size);
+size_t cbor_writer_finish(const cbor_writer_t *writer);
+void cbor_put_uint(cbor_writer_t *writer, uint32_t value);
+void cbor_put_int(cbor_writer_t *writer, int32_t value);
+void cbor_put_bool(cbor_writer_t *writer, bool value);
+void cbor_put_float(cbor_writer_t *writer, float value);
+void cbor_put_null(cbor_writer_t *writer);
+void cbor_put_text(cbor_writer_t *writer, const char *text, size_t length);
+void cbor_put_bytes(cbor_writer_t *writer, const void *data, size_t length);
+void cbor_put_array(cbor_writer_t *writer, uint32_t count);
+void cbor_put_map(cbor_writer_t *writer, uint32_t count);
+
+void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buffer, size_t length);
+cbor_type_t cbor_peek_type(const cbor_reader_t *reader);
+bool cbor_get_uint(cbor_reader_t *reader, uint32_t *value);
+bool cbor_get_int(cbor_reader_t *reader, int32_t *value);
+bool cbor_get_bool(cbor_reader_t *reader, bool *value);
+bool cbor_get_float(cbor_reader_t *reader, float *value);
+bool cbor_get_text(cbor_reader_t *reader, const char **text, size_t *length);
+bool cbor_get_bytes(cbor_reader_t *reader, const uint8_t **data, size_t *length);
+bool cbor_get_array(cbor_reader_t *reader, uint32_t *count);
+bool cbor_get_map(cbor_reader_t *reader, uint32_t *count);
+bool cbor_skip(cbor_reader_t *reader);
+
+#endif /* CBOR_CODEC_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,546 @@
+/******************************************************************************
+* File Name:   entropy_pool.c
+*
+* Description: This file implements the entropy pool service. A single CTR-DRBG
+*              is seeded from the OPTIGA TRNG and shared by PKCS#11, every TLS
+*              context and the application. The TRNG is read in large blocks and
+*              the DRBG is reseeded from a low priority task, so callers never
+*              wait on an I2C transaction for random data.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "cyabs_rtos.h"
+
+/* OPTIGA(TM) Trust M Includes */
+#include "include/optiga_crypt.h"
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/platform_util.h"
+
+#include "entropy_pool.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Polling interval and upper bound while waiting for the OPTIGA TRNG. */
+#define ENTROPY_POOL_OPTIGA_WAIT_DELAY_MS   (5u)
+#define ENTROPY_POOL_OPTIGA_TIMEOUT_MS      (5000u)
+
+#if (ENTROPY_POOL_TRNG_BLOCK_SIZE < 8u) || (ENTROPY_POOL_TRNG_BLOCK_SIZE > 256u)
+#error "ENTROPY_POOL_TRNG_BLOCK_SIZE must be in the range supported by optiga_crypt_random (8 to 256 bytes)"
+#endif
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+typedef enum
+{
+    ENTROPY_POOL_UNINITIALIZED,
+    ENTROPY_POOL_INITIALIZING,
+    ENTROPY_POOL_READY
+} entropy_pool_state_t;
+
+typedef struct entropy_pool
+{
+    mbedtls_ctr_drbg_context    drbg;
+    cy_mutex_t                  drbg_mutex;
+    cy_mutex_t                  trng_mutex;
+    optiga_crypt_t             *crypt;
+    TaskHandle_t                task;
+    /* TRNG bytes fetched from OPTIGA but not yet consumed by the DRBG. */
+    uint8_t                     trng_block[ENTROPY_POOL_TRNG_BLOCK_SIZE];
+    size_t                      trng_offset;
+    size_t                      bytes_since_reseed;
+    bool                        reseed_pending;
+    volatile entropy_pool_state_t state;
+} entropy_pool_t;
+
+static entropy_pool_t entropy_pool;
+
+static volatile optiga_lib_status_t entropy_pool_optiga_status;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void entropy_pool_optiga_callback(void *context, optiga_lib_status_t return_status);
+static int entropy_pool_trng_read(uint8_t *output, uint16_t length);
+static int entropy_pool_entropy_source(void *data, unsigned char *output, size_t length);
+static void entropy_pool_refill(void);
+static void entropy_pool_task(void *pvParameters);
+static cy_rslt_t entropy_pool_setup(void);
+
+/******************************************************************************
+ * Function Name: entropy_pool_optiga_callback
+ ******************************************************************************
+ * Summary:
+ *  Callback invoked when the asynchronous optiga_crypt_random operation is
+ *  completed.
+ *
+ * Parameters:
+ *  void *context : Context passed during optiga_crypt_create() (unused)
+ *  optiga_lib_status_t return_status : Completion status of the operation
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void entropy_pool_optiga_callback(void *context, optiga_lib_status_t return_status)
+{
+    (void) context;
+    entropy_pool_optiga_status = return_status;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_trng_read
+ ******************************************************************************
+ * Summary:
+ *  Reads 'length' bytes from the OPTIGA TRNG in a single transaction. The TRNG
+ *  mutex serialises the pool's crypt instance between the background task and
+ *  entropy_pool_init(). Never called with the DRBG mutex held.
+ *
+ * Parameters:
+ *  uint8_t *output : Buffer receiving the random bytes
+ *  uint16_t length : Number of bytes to read
+ *
+ * Return:
+ *  int : 0 on success, -1 on failure
+ *
+ ******************************************************************************/
+static int entropy_pool_trng_read(uint8_t *output, uint16_t length)
+{
+    int ret = -1;
+#ifdef OPTIGA_CRYPT_RANDOM_ENABLED
+    uint32_t waited_ms = 0;
+
+    if (CY_RSLT_SUCCESS != cy_rtos_get_mutex(&entropy_pool.trng_mutex, CY_RTOS_NEVER_TIMEOUT))
+    {
+        return ret;
+    }
+
+    entropy_pool_optiga_status = OPTIGA_LIB_BUSY;
+    if (OPTIGA_LIB_SUCCESS == optiga_crypt_random(entropy_pool.crypt, OPTIGA_RNG_TYPE_TRNG,
+                                                  output, length))
+    {
+        while ((OPTIGA_LIB_BUSY == entropy_pool_optiga_status) &&
+               (waited_ms < ENTROPY_POOL_OPTIGA_TIMEOUT_MS))
+        {
+            cy_rtos_delay_milliseconds(ENTROPY_POOL_OPTIGA_WAIT_DELAY_MS);
+            waited_ms += ENTROPY_POOL_OPTIGA_WAIT_DELAY_MS;
+        }
+
+        if (OPTIGA_LIB_SUCCESS == entropy_pool_optiga_status)
+        {
+            ret = 0;
+        }
+    }
+
+    cy_rtos_set_mutex(&entropy_pool.trng_mutex);
+#else
+    (void) output;
+    (void) length;
+#endif
+    return ret;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_entropy_source
+ ******************************************************************************
+ * Summary:
+ *  Entropy callback handed to mbedtls_ctr_drbg_seed(). Entropy is served only
+ *  from the TRNG block prefetched by entropy_pool_refill(). It never touches
+ *  the I2C bus, since it is called with the DRBG mutex held. If the block runs
+ *  short the (re)seed fails and the DRBG keeps its current state until the
+ *  background task has refilled the block.
+ *
+ * Parameters:
+ *  void *data : Entropy context (unused)
+ *  unsigned char *output : Buffer receiving the entropy
+ *  size_t length : Number of bytes requested by the DRBG
+ *
+ * Return:
+ *  int : 0 on success, MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED on failure
+ *
+ ******************************************************************************/
+static int entropy_pool_entropy_source(void *data, unsigned char *output, size_t length)
+{
+    size_t chunk;
+
+    (void) data;
+
+    chunk = sizeof(entropy_pool.trng_block) - entropy_pool.trng_offset;
+    if (chunk < length)
+    {
+        /* Wake the background task to fetch a new block. */
+        if (NULL != entropy_pool.task)
+        {
+            xTaskNotifyGive(entropy_pool.task);
+        }
+        return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+    }
+
+    /* Hand out each TRNG byte exactly once. */
+    memcpy(output, &entropy_pool.trng_block[entropy_pool.trng_offset], length);
+    mbedtls_platform_zeroize(&entropy_pool.trng_block[entropy_pool.trng_offset], length);
+    entropy_pool.trng_offset += length;
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_refill
+ ******************************************************************************
+ * Summary:
+ *  Fetches a new TRNG block if fewer bytes than one DRBG reseed are left. The
+ *  I2C transaction runs on a local buffer without holding the DRBG mutex, the
+ *  mutex is only taken to swap the block in.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void entropy_pool_refill(void)
+{
+    uint8_t trng_block[ENTROPY_POOL_TRNG_BLOCK_SIZE];
+    size_t trng_available;
+
+    cy_rtos_get_mutex(&entropy_pool.drbg_mutex, CY_RTOS_NEVER_TIMEOUT);
+    trng_available = sizeof(entropy_pool.trng_block) - entropy_pool.trng_offset;
+    cy_rtos_set_mutex(&entropy_pool.drbg_mutex);
+
+    if ((trng_available >= MBEDTLS_CTR_DRBG_ENTROPY_LEN) ||
+        (0 != entropy_pool_trng_read(trng_block, sizeof(trng_block))))
+    {
+        return;
+    }
+
+    cy_rtos_get_mutex(&entropy_pool.drbg_mutex, CY_RTOS_NEVER_TIMEOUT);
+    memcpy(entropy_pool.trng_block, trng_block, sizeof(trng_block));
+    entropy_pool.trng_offset = 0;
+    cy_rtos_set_mutex(&entropy_pool.drbg_mutex);
+    mbedtls_platform_zeroize(trng_block, sizeof(trng_block));
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_task
+ ******************************************************************************
+ * Summary:
+ *  Low priority task that refills the TRNG block and reseeds the DRBG, either
+ *  periodically or when ENTROPY_POOL_RESEED_BYTES have been drawn. The I2C
+ *  transaction is performed without holding the DRBG mutex so that consumers
+ *  are never stalled behind the secure element. The block is refilled again
+ *  after the reseed, so that the next reseed finds its entropy ready.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void entropy_pool_task(void *pvParameters)
+{
+    bool reseed;
+
+    (void) pvParameters;
+
+    while (true)
+    {
+        reseed = (0 == ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ENTROPY_POOL_RESEED_INTERVAL_MS)));
+
+        entropy_pool_refill();
+
+        cy_rtos_get_mutex(&entropy_pool.drbg_mutex, CY_RTOS_NEVER_TIMEOUT);
+        if (entropy_pool.reseed_pending)
+        {
+            reseed = true;
+        }
+        if (reseed && (0 == mbedtls_ctr_drbg_reseed(&entropy_pool.drbg, NULL, 0)))
+        {
+            entropy_pool.bytes_since_reseed = 0;
+            entropy_pool.reseed_pending = false;
+        }
+        cy_rtos_set_mutex(&entropy_pool.drbg_mutex);
+
+        entropy_pool_refill();
+    }
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_setup
+ ******************************************************************************
+ * Summary:
+ *  Creates the OPTIGA crypt instance and the mutexes, fetches the first TRNG
+ *  block, seeds the shared CTR-DRBG from it and starts the background reseed
+ *  task. Releases everything it created on failure, so that a later
+ *  entropy_pool_init() can retry.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+static cy_rslt_t entropy_pool_setup(void)
+{
+    static const char pers[] = "optiga_entropy_pool";
+    int ret;
+
+    entropy_pool.crypt = optiga_crypt_create(0, entropy_pool_optiga_callback, NULL);
+    if (NULL == entropy_pool.crypt)
+    {
+        printf("Entropy pool: optiga_crypt_create failed!\n");
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    if (CY_RSLT_SUCCESS != cy_rtos_init_mutex(&entropy_pool.drbg_mutex))
+    {
+        printf("Entropy pool: mutex creation failed!\n");
+        goto err_crypt;
+    }
+
+    if (CY_RSLT_SUCCESS != cy_rtos_init_mutex(&entropy_pool.trng_mutex))
+    {
+        printf("Entropy pool: mutex creation failed!\n");
+        goto err_drbg_mutex;
+    }
+
+    /* Fetch the block for the initial seed before the DRBG mutex exists for
+     * anyone else, the entropy source itself never reads the TRNG. */
+    if (0 != entropy_pool_trng_read(entropy_pool.trng_block, sizeof(entropy_pool.trng_block)))
+    {
+        printf("Entropy pool: TRNG read failed!\n");
+        goto err_trng_mutex;
+    }
+    entropy_pool.trng_offset = 0;
+
+    mbedtls_ctr_drbg_init(&entropy_pool.drbg);
+    ret = mbedtls_ctr_drbg_seed(&entropy_pool.drbg, entropy_pool_entropy_source, NULL,
+                                (const unsigned char *) pers, sizeof(pers) - 1);
+    if (0 != ret)
+    {
+        printf("Entropy pool: mbedtls_ctr_drbg_seed failed -0x%x\n", -ret);
+        goto err_drbg;
+    }
+
+    if (pdPASS != xTaskCreate(entropy_pool_task, "Entropy pool", ENTROPY_POOL_TASK_STACK_SIZE,
+                              NULL, ENTROPY_POOL_TASK_PRIORITY, &entropy_pool.task))
+    {
+        printf("Entropy pool: failed to create the reseed task!\n");
+        entropy_pool.task = NULL;
+        goto err_drbg;
+    }
+
+    return CY_RSLT_SUCCESS;
+
+err_drbg:
+    mbedtls_ctr_drbg_free(&entropy_pool.drbg);
+    mbedtls_platform_zeroize(entropy_pool.trng_block, sizeof(entropy_pool.trng_block));
+err_trng_mutex:
+    cy_rtos_deinit_mutex(&entropy_pool.trng_mutex);
+err_drbg_mutex:
+    cy_rtos_deinit_mutex(&entropy_pool.drbg_mutex);
+err_crypt:
+    optiga_crypt_destroy(entropy_pool.crypt);
+    entropy_pool.crypt = NULL;
+    return ~CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_init
+ ******************************************************************************
+ * Summary:
+ *  Sets up the pool on the first call, after the OPTIGA application has been
+ *  opened. Safe to call from several tasks, e.g. from main and from every
+ *  cy_tls_connect(): the first caller claims the setup in a critical section,
+ *  concurrent callers wait for its outcome and later calls return immediately.
+ *  A failed setup is retried by the next call.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t entropy_pool_init(void)
+{
+    cy_rslt_t result;
+    entropy_pool_state_t state;
+
+    if (ENTROPY_POOL_READY == entropy_pool.state)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    taskENTER_CRITICAL();
+    state = entropy_pool.state;
+    if (ENTROPY_POOL_UNINITIALIZED == state)
+    {
+        entropy_pool.state = ENTROPY_POOL_INITIALIZING;
+    }
+    taskEXIT_CRITICAL();
+
+    if (ENTROPY_POOL_UNINITIALIZED != state)
+    {
+        /* Another task owns the setup, wait until it has finished. */
+        while (ENTROPY_POOL_INITIALIZING == entropy_pool.state)
+        {
+            cy_rtos_delay_milliseconds(ENTROPY_POOL_OPTIGA_WAIT_DELAY_MS);
+        }
+        return (ENTROPY_POOL_READY == entropy_pool.state) ? CY_RSLT_SUCCESS : ~CY_RSLT_SUCCESS;
+    }
+
+    result = entropy_pool_setup();
+    entropy_pool.state = (CY_RSLT_SUCCESS == result) ? ENTROPY_POOL_READY : ENTROPY_POOL_UNINITIALIZED;
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_get_bytes
+ ******************************************************************************
+ * Summary:
+ *  Fills 'output' with 'length' bytes from the shared CTR-DRBG. Requests a
+ *  background reseed once ENTROPY_POOL_RESEED_BYTES have been drawn.
+ *
+ * Parameters:
+ *  uint8_t *output : Buffer receiving the random bytes
+ *  size_t length : Number of bytes requested
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t entropy_pool_get_bytes(uint8_t *output, size_t length)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    size_t chunk;
+
+    if ((ENTROPY_POOL_READY != entropy_pool.state) || (NULL == output))
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    if (CY_RSLT_SUCCESS != cy_rtos_get_mutex(&entropy_pool.drbg_mutex, CY_RTOS_NEVER_TIMEOUT))
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    while (length > 0)
+    {
+        chunk = (length > MBEDTLS_CTR_DRBG_MAX_REQUEST) ? MBEDTLS_CTR_DRBG_MAX_REQUEST : length;
+        if (0 != mbedtls_ctr_drbg_random(&entropy_pool.drbg, output, chunk))
+        {
+            result = ~CY_RSLT_SUCCESS;
+            break;
+        }
+        output += chunk;
+        length -= chunk;
+        entropy_pool.bytes_since_reseed += chunk;
+    }
+
+    if ((entropy_pool.bytes_since_reseed >= ENTROPY_POOL_RESEED_BYTES) && (!entropy_pool.reseed_pending))
+    {
+        entropy_pool.reseed_pending = true;
+        xTaskNotifyGive(entropy_pool.task);
+    }
+
+    cy_rtos_set_mutex(&entropy_pool.drbg_mutex);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_get_uint32
+ ******************************************************************************
+ * Summary:
+ *  Convenience wrapper returning a single 32-bit random value, e.g. for
+ *  client identifiers and retry jitter.
+ *
+ * Parameters:
+ *  uint32_t *value : Receives the random value
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t entropy_pool_get_uint32(uint32_t *value)
+{
+    return entropy_pool_get_bytes((uint8_t *) value, sizeof(*value));
+}
+
+/******************************************************************************
+ * Function Name: entropy_pool_mbedtls_random
+ ******************************************************************************
+ * Summary:
+ *  RNG callback with the mbedTLS f_rng signature, for use with
+ *  mbedtls_ssl_conf_rng(). Lets every TLS context share the pool instead of
+ *  seeding a DRBG of its own on each connect.
+ *
+ * Parameters:
+ *  void *p_rng : RNG context (unused)
+ *  unsigned char *output : Buffer receiving the random bytes
+ *  size_t output_len : Number of bytes requested
+ *
+ * Return:
+ *  int : 0 on success, MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED on failure
+ *
+ ******************************************************************************/
+int entropy_pool_mbedtls_random(void *p_rng, unsigned char *output, size_t output_len)
+{
+    (void) p_rng;
+
+    if (CY_RSLT_SUCCESS != entropy_pool_get_bytes(output, output_len))
+    {
+        return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
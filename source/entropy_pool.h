@@ -0,0 +1,85 @@
+/******************************************************************************
+* File Name:   entropy_pool.h
+*
+* Description: This file contains the declarations of the entropy pool service
+*              which owns the shared CTR-DRBG seeded from the OPTIGA TRNG.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef ENTROPY_POOL_H_
+#define ENTROPY_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of TRNG bytes fetched from OPTIGA in a single I2C transaction. The
+ * OPTIGA accepts requests between 8 and 256 bytes. One block covers several
+ * DRBG reseeds, so the I2C round trip is amortised.
+ */
+#ifndef ENTROPY_POOL_TRNG_BLOCK_SIZE
+#define ENTROPY_POOL_TRNG_BLOCK_SIZE        (128u)
+#endif
+
+/* Number of DRBG output bytes after which the background task reseeds. */
+#ifndef ENTROPY_POOL_RESEED_BYTES
+#define ENTROPY_POOL_RESEED_BYTES           (4096u)
+#endif
+
+/* Period in milliseconds of the background reseed, independent of usage. */
+#ifndef ENTROPY_POOL_RESEED_INTERVAL_MS
+#define ENTROPY_POOL_RESEED_INTERVAL_MS     (10u * 60u * 1000u)
+#endif
+
+/* Task parameters for the background reseed task. */
+#define ENTROPY_POOL_TASK_PRIORITY          (1)
+#define ENTROPY_POOL_TASK_STACK_SIZE        (1024 * 1)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t entropy_pool_init(void);
+cy_rslt_t entropy_pool_get_bytes(uint8_t *output, size_t length);
+cy_rslt_t entropy_pool_get_uint32(uint32_t *value);
+int entropy_pool_mbedtls_random(void *p_rng, unsigned char *output, size_t output_len);
+
+#endif /* ENTROPY_POOL_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,224 @@
+/******************************************************************************
+* File Name:   handshake_benchmark.c
+*
+* Description: This file contains the reconnect benchmark. The MQTT client
+*              task brackets each connection attempt with
+*              handshake_benchmark_begin() and handshake_benchmark_end(),
+*              which print one JSON line per attempt and a summary at the end.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Configuration file for MQTT client */
+#include "mqtt_client_config.h"
+
+#include "latency_histogram.h"
+#include "handshake_benchmark.h"
+
+#if ENABLE_HANDSHAKE_BENCHMARK
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+/* Distribution of the handshake and the whole connection times. */
+static latency_histogram_t handshake_histogram;
+static latency_histogram_t connect_histogram;
+
+/* Totals over the successful handshakes, for the averages. */
+static uint32_t benchmark_failures;
+static uint32_t benchmark_i2c_transfers;
+static uint32_t benchmark_i2c_bytes;
+static uint32_t benchmark_wire_bytes;
+
+/* Arena counters before the first cycle, for the soak summary. */
+static tls_memory_stats_t benchmark_arena_start;
+static bool benchmark_arena_started;
+
+/******************************************************************************
+ * Function Name: handshake_benchmark_begin
+ ******************************************************************************
+ * Summary:
+ *  Takes the counters before a connection attempt.
+ *
+ * Parameters:
+ *  handshake_benchmark_sample_t *sample : Receives the counters
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void handshake_benchmark_begin(handshake_benchmark_sample_t *sample)
+{
+    cy_tls_get_handshake_stats(&sample->tls);
+    pal_i2c_get_stats(&sample->i2c);
+    tls_memory_get_stats(&sample->arena);
+    if (!benchmark_arena_started)
+    {
+        benchmark_arena_start = sample->arena;
+        benchmark_arena_started = true;
+    }
+    sample->start = xTaskGetTickCount();
+}
+
+/******************************************************************************
+ * Function Name: handshake_benchmark_end
+ ******************************************************************************
+ * Summary:
+ *  Prints the cost of a connection attempt as one JSON line and adds it to
+ *  the summary. The connection time covers TCP, TLS and MQTT CONNECT; the
+ *  handshake time, bytes and ciphersuite are those of the TLS handshake, and
+ *  the I2C counters show the work of the secure element, which signs with
+ *  the device key and may take part in the key exchange and verification.
+ *  The arena figures are the TLS arena peak of this connection and the
+ *  teardowns so far that left allocations behind.
+ *
+ * Parameters:
+ *  const handshake_benchmark_sample_t *sample : Counters before the attempt
+ *  uint32_t iteration : Number of the attempt
+ *  cy_rslt_t result : Result of the connection attempt
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void handshake_benchmark_end(const handshake_benchmark_sample_t *sample, uint32_t iteration,
+                             cy_rslt_t result)
+{
+    cy_tls_handshake_stats_t tls;
+    pal_i2c_stats_t i2c;
+    tls_memory_stats_t arena;
+    uint32_t connect_ms = (uint32_t) ((xTaskGetTickCount() - sample->start) * portTICK_PERIOD_MS);
+    uint32_t i2c_transfers;
+    uint32_t i2c_bytes;
+    bool handshake_done;
+
+    cy_tls_get_handshake_stats(&tls);
+    pal_i2c_get_stats(&i2c);
+    tls_memory_get_stats(&arena);
+
+    i2c_transfers = (i2c.writes - sample->i2c.writes) + (i2c.reads - sample->i2c.reads);
+    i2c_bytes = i2c.bytes - sample->i2c.bytes;
+    handshake_done = (tls.handshakes != sample->tls.handshakes);
+
+    if ((CY_RSLT_SUCCESS == result) && handshake_done)
+    {
+        latency_histogram_add(&handshake_histogram, tls.last_duration_ms * 1000u);
+        latency_histogram_add(&connect_histogram, connect_ms * 1000u);
+        benchmark_i2c_transfers += i2c_transfers;
+        benchmark_i2c_bytes += i2c_bytes;
+        benchmark_wire_bytes += tls.last_bytes_sent + tls.last_bytes_received;
+    }
+    else
+    {
+        benchmark_failures++;
+    }
+
+    printf("{\"benchmark\":\"handshake\",\"iteration\":%lu,\"result\":%lu,\"connect_ms\":%lu,"
+           "\"handshake_ms\":%lu,\"tls_tx_bytes\":%lu,\"tls_rx_bytes\":%lu,\"ciphersuite\":%u,"
+           "\"i2c_transfers\":%lu,\"i2c_bytes\":%lu,\"i2c_errors\":%lu,\"arena_peak\":%lu,"
+           "\"arena_leaks\":%lu}\n",
+           (unsigned long) iteration, (unsigned long) result, (unsigned long) connect_ms,
+           (unsigned long) (handshake_done ? tls.last_duration_ms : 0u),
+           (unsigned long) (handshake_done ? tls.last_bytes_sent : 0u),
+           (unsigned long) (handshake_done ? tls.last_bytes_received : 0u),
+           (unsigned int) (handshake_done ? tls.last_ciphersuite : 0u),
+           (unsigned long) i2c_transfers, (unsigned long) i2c_bytes,
+           (unsigned long) (i2c.errors - sample->i2c.errors), (unsigned long) arena.peak,
+           (unsigned long) arena.leaks);
+}
+
+/******************************************************************************
+ * Function Name: handshake_benchmark_report
+ ******************************************************************************
+ * Summary:
+ *  Prints the distribution of the handshake and connection times and the
+ *  average cost of a successful handshake as one JSON line, with the TLS
+ *  arena resets and leaks over all cycles. The percentiles are upper bounds
+ *  from log2 buckets, see latency_percentile_us().
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void handshake_benchmark_report(void)
+{
+    uint32_t count = handshake_histogram.count;
+    tls_memory_stats_t arena;
+
+    tls_memory_get_stats(&arena);
+
+    printf("{\"benchmark\":\"handshake_summary\",\"handshakes\":%lu,\"failures\":%lu,"
+           "\"handshake_p50_ms\":%lu,\"handshake_p90_ms\":%lu,\"handshake_max_ms\":%lu,"
+           "\"connect_p50_ms\":%lu,\"connect_p90_ms\":%lu,\"connect_max_ms\":%lu,"
+           "\"avg_wire_bytes\":%lu,\"avg_i2c_transfers\":%lu,\"avg_i2c_bytes\":%lu,"
+           "\"arena_resets\":%lu,\"arena_leaks\":%lu,\"arena_failed\":%lu}\n",
+           (unsigned long) count, (unsigned long) benchmark_failures,
+           (unsigned long) (latency_percentile_us(&handshake_histogram, 500u) / 1000u),
+           (unsigned long) (latency_percentile_us(&handshake_histogram, 900u) / 1000u),
+           (unsigned long) (handshake_histogram.max_us / 1000u),
+           (unsigned long) (latency_percentile_us(&connect_histogram, 500u) / 1000u),
+           (unsigned long) (latency_percentile_us(&connect_histogram, 900u) / 1000u),
+           (unsigned long) (connect_histogram.max_us / 1000u),
+           (unsigned long) ((0u == count) ? 0u : (benchmark_wire_bytes / count)),
+           (unsigned long) ((0u == count) ? 0u : (benchmark_i2c_transfers / count)),
+           (unsigned long) ((0u == count) ? 0u : (benchmark_i2c_bytes / count)),
+           (unsigned long) (arena.resets - benchmark_arena_start.resets),
+           (unsigned long) (arena.leaks - benchmark_arena_start.leaks),
+           (unsigned long) (arena.failed - benchmark_arena_start.failed));
+
+    memset(&handshake_histogram, 0, sizeof(handshake_histogram));
+    memset(&connect_histogram, 0, sizeof(connect_histogram));
+    benchmark_failures = 0;
+    benchmark_i2c_transfers = 0;
+    benchmark_i2c_bytes = 0;
+    benchmark_wire_bytes = 0;
+    benchmark_arena_started = false;
+}
+
+#endif /* ENABLE_HANDSHAKE_BENCHMARK */
+
+/* [] END OF FILE */
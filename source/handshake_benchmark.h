@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   handshake_benchmark.h
+*
+* Description: This file contains the declarations of the reconnect benchmark,
+*              which measures the time, the bytes on the wire and the secure
+*              element traffic of each MQTT connection and its TLS handshake.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef HANDSHAKE_BENCHMARK_H_
+#define HANDSHAKE_BENCHMARK_H_
+
+#include <stdint.h>
+#include "cy_result.h"
+#include "FreeRTOS.h"
+#include "cy_tls_ext.h"
+#include "tls_memory.h"
+#include "pal_psoc_i2c_mapping.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of disconnect and connect cycles measured. Raise it into the
+ * thousands to soak the TLS arena across reconnects: every cycle reports the
+ * arena peak and the teardowns that leaked, which must stay at 0.
+ */
+#ifndef HANDSHAKE_BENCHMARK_ITERATIONS
+#define HANDSHAKE_BENCHMARK_ITERATIONS          (20u)
+#endif
+
+/* Pause in milliseconds between the cycles, so that the broker does not
+ * throttle the client.
+ */
+#ifndef HANDSHAKE_BENCHMARK_INTERVAL_MS
+#define HANDSHAKE_BENCHMARK_INTERVAL_MS         (1000u)
+#endif
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+/* Counters at the start of a connection attempt. */
+typedef struct
+{
+    TickType_t               start;
+    cy_tls_handshake_stats_t tls;
+    pal_i2c_stats_t          i2c;
+    tls_memory_stats_t       arena;
+} handshake_benchmark_sample_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void handshake_benchmark_begin(handshake_benchmark_sample_t *sample);
+void handshake_benchmark_end(const handshake_benchmark_sample_t *sample, uint32_t iteration,
+                             cy_rslt_t result);
+void handshake_benchmark_report(void);
+
+#endif /* HANDSHAKE_BENCHMARK_H_ */
+
+/* [] END OF FILE */
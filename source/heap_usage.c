@@ -1,9 +1,11 @@
 /******************************************************************************
 * File Name:   heap_usage.c
 *
-* Description: This file contains the code for printing heap usage.
-*              Supports only GCC_ARM compiler. Define PRINT_HEAP_USAGE for
-*              printing the heap usage numbers.
+* Description: This file contains the heap telemetry. The RTOS allocation
+*              hooks keep the bytes in use and their peak; mallinfo() is only
+*              walked for the on-demand report. Byte tracking supports only
+*              GCC_ARM compiler. Define PRINT_HEAP_USAGE for printing the
+*              heap usage numbers.
 *
 * Related Document: See README.md
 *
@@ -48,12 +50,18 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 /* ARM compiler also defines __GNUC__ */
 #if defined (__GNUC__) && !defined(__ARMCC_VERSION)
 #include <malloc.h>
 #endif /* #if defined (__GNUC__) && !defined(__ARMCC_VERSION) */
 
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "heap_usage.h"
+
 
 /*******************************************************************************
  * Macros
@@ -61,42 +69,226 @@
 #define TO_KB(size_bytes)  ((float)(size_bytes)/1024)
 
 
+/*******************************************************************************
+ * Global Variables
+ ******************************************************************************/
+/* Allocation counters and bytes in use, updated on the hot path. */
+static volatile uint32_t heap_alloc_count = 0;
+static volatile uint32_t heap_free_count = 0;
+static volatile uint32_t heap_alloc_failures = 0;
+static volatile uint32_t heap_in_use = 0;
+static volatile uint32_t heap_peak = 0;
+
+static bool heap_above_warn_level = false;
+
+
 /*******************************************************************************
  * Function Definitions
  ******************************************************************************/
 
 /*******************************************************************************
-* Function Name: print_heap_usage
+* Function Name: heap_get_size
 ********************************************************************************
 * Summary:
-* Prints the available heap and utilized heap by using mallinfo().
+* Returns the size of the heap region exported by the linker, 0 if unknown.
 *
 *******************************************************************************/
-void print_heap_usage(char *msg)
+static uint32_t heap_get_size(void)
 {
     /* ARM compiler also defines __GNUC__ */
-#if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION)
-    struct mallinfo mall_info = mallinfo();
-
+#if defined (__GNUC__) && !defined(__ARMCC_VERSION)
     extern uint8_t __HeapBase;  /* Symbol exported by the linker. */
     extern uint8_t __HeapLimit; /* Symbol exported by the linker. */
 
-    uint8_t* heap_base = (uint8_t *)&__HeapBase;
-    uint8_t* heap_limit = (uint8_t *)&__HeapLimit;
-    uint32_t heap_size = (uint32_t)(heap_limit - heap_base);
+    return (uint32_t)((uint8_t *)&__HeapLimit - (uint8_t *)&__HeapBase);
+#else
+    return 0;
+#endif /* #if defined (__GNUC__) && !defined(__ARMCC_VERSION) */
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_on_malloc
+********************************************************************************
+* Summary:
+* Counts an allocation and adds its usable size to the bytes in use. Called
+* through traceMALLOC() from pvPortMalloc(), which suspends the scheduler
+* around it, so the updates are atomic.
+*
+*******************************************************************************/
+void heap_usage_on_malloc(void *ptr)
+{
+    if (NULL != ptr)
+    {
+        heap_alloc_count++;
+#if defined(HEAP_USAGE_WRAP) && HEAP_USAGE_WRAP
+        heap_in_use += malloc_usable_size(ptr);
+        if (heap_in_use > heap_peak)
+        {
+            heap_peak = heap_in_use;
+        }
+#endif /* #if defined(HEAP_USAGE_WRAP) && HEAP_USAGE_WRAP */
+    }
+    else
+    {
+        heap_alloc_failures++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_on_free
+********************************************************************************
+* Summary:
+* Counts a free. Called through traceFREE() from vPortFree(), which suspends
+* the scheduler around it, so a plain increment is atomic. The block is
+* already freed here, so its size is taken in __wrap_vPortFree() instead.
+*
+*******************************************************************************/
+void heap_usage_on_free(void *ptr)
+{
+    if (NULL != ptr)
+    {
+        heap_free_count++;
+    }
+}
+
+#if defined(HEAP_USAGE_WRAP) && HEAP_USAGE_WRAP
+/*******************************************************************************
+* Function Name: __wrap_vPortFree
+********************************************************************************
+* Summary:
+* Takes the usable size of a block off the bytes in use while the block is
+* still allocated, then frees it. Calls to vPortFree() are routed here by the
+* linker, see HEAP_USAGE_WRAP in the Makefile.
+*
+*******************************************************************************/
+void __real_vPortFree(void *pv);
+
+void __wrap_vPortFree(void *pv)
+{
+    vTaskSuspendAll();
+    if (NULL != pv)
+    {
+        heap_in_use -= malloc_usable_size(pv);
+    }
+    __real_vPortFree(pv);
+    (void) xTaskResumeAll();
+}
+#endif /* #if defined(HEAP_USAGE_WRAP) && HEAP_USAGE_WRAP */
+
+/*******************************************************************************
+* Function Name: heap_usage_sample
+********************************************************************************
+* Summary:
+* Warns when the heap in use crosses HEAP_USAGE_WARN_PERCENT. Called
+* periodically by the task monitor rather than from the allocation hooks,
+* which run with the scheduler suspended.
+*
+*******************************************************************************/
+void heap_usage_sample(void)
+{
+    uint32_t heap_size = heap_get_size();
+    uint32_t in_use = heap_in_use;
+    bool above_warn_level;
+
+    if (0 == heap_size)
+    {
+        return;
+    }
+
+    above_warn_level = ((uint64_t) in_use * 100u) >= ((uint64_t) heap_size * HEAP_USAGE_WARN_PERCENT);
+
+    if (above_warn_level && !heap_above_warn_level)
+    {
+        printf("Heap usage: %"PRIu32" of %"PRIu32" bytes in use!\n", in_use, heap_size);
+    }
+    heap_above_warn_level = above_warn_level;
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_reset_peak
+********************************************************************************
+* Summary:
+* Restarts the peak from the bytes in use now, so that a later
+* heap_usage_get_stats() reports the peak of what ran in between.
+*
+*******************************************************************************/
+void heap_usage_reset_peak(void)
+{
+    vTaskSuspendAll();
+    heap_peak = heap_in_use;
+    (void) xTaskResumeAll();
+}
+
+/*******************************************************************************
+* Function Name: heap_usage_get_stats
+********************************************************************************
+* Summary:
+* Returns the heap statistics kept by the allocation hooks.
+*
+*******************************************************************************/
+void heap_usage_get_stats(heap_usage_stats_t *stats)
+{
+    stats->heap_size = heap_get_size();
+
+    vTaskSuspendAll();
+    stats->current = heap_in_use;
+    stats->peak = heap_peak;
+    stats->alloc_count = heap_alloc_count;
+    stats->free_count = heap_free_count;
+    stats->alloc_failures = heap_alloc_failures;
+    (void) xTaskResumeAll();
+}
+
+/*******************************************************************************
+* Function Name: print_heap_usage
+********************************************************************************
+* Summary:
+* Prints the heap statistics, adding what mallinfo() reports for the whole
+* heap. Walking the allocator bins is slow, so this is meant for on-demand
+* reports, not for the publish and subscribe paths.
+*
+*******************************************************************************/
+void print_heap_usage(char *msg)
+{
+#if defined(PRINT_HEAP_USAGE)
+    heap_usage_stats_t stats;
+
+    heap_usage_get_stats(&stats);
 
     printf("\r\n\n********** Heap Usage **********\r\n");
     printf(msg);
-    printf("\r\nTotal available heap        : %"PRIu32" bytes/%.2f KB\r\n", heap_size, TO_KB(heap_size));
+    printf("\r\nTotal available heap        : %"PRIu32" bytes/%.2f KB\r\n", stats.heap_size, TO_KB(stats.heap_size));
+
+    /* ARM compiler also defines __GNUC__ */
+#if defined (__GNUC__) && !defined(__ARMCC_VERSION)
+    if (0 != stats.heap_size)
+    {
+        struct mallinfo mall_info = mallinfo();
+
+        /* The top chunk and the part of the region that was never claimed are
+         * contiguous. Freed chunks inside the arena may be larger, so this is
+         * a lower bound.
+         */
+        uint32_t largest_free = (stats.heap_size - mall_info.arena) + mall_info.keepcost;
+
+        printf("Maximum heap utilized so far: %u bytes/%.2f KB, %.2f%% of available heap\r\n",
+                mall_info.arena, TO_KB(mall_info.arena), ((float) mall_info.arena * 100u)/stats.heap_size);
 
-    printf("Maximum heap utilized so far: %u bytes/%.2f KB, %.2f%% of available heap\r\n",
-            mall_info.arena, TO_KB(mall_info.arena), ((float) mall_info.arena * 100u)/heap_size);
+        printf("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap\r\n",
+                mall_info.uordblks, TO_KB(mall_info.uordblks), ((float) mall_info.uordblks * 100u)/stats.heap_size);
+
+        printf("Largest free block (min)    : %"PRIu32" bytes/%.2f KB\r\n", largest_free, TO_KB(largest_free));
+    }
+#endif /* #if defined (__GNUC__) && !defined(__ARMCC_VERSION) */
 
-    printf("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap\r\n",
-            mall_info.uordblks, TO_KB(mall_info.uordblks), ((float) mall_info.uordblks * 100u)/heap_size);
+    printf("RTOS heap in use/peak       : %"PRIu32"/%"PRIu32" bytes\r\n", stats.current, stats.peak);
+    printf("RTOS allocations/frees      : %"PRIu32"/%"PRIu32", %"PRIu32" failed\r\n",
+            stats.alloc_count, stats.free_count, stats.alloc_failures);
 
     printf("********************************\r\n\n");
-#endif /* #if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION) */
+#else
+    (void) msg;
+#endif /* #if defined(PRINT_HEAP_USAGE) */
 }
 
 /* [] END OF FILE */
@@ -0,0 +1,85 @@
+/******************************************************************************
+* File Name:   heap_usage.h
+*
+* Description: This file contains the declarations of the heap telemetry,
+*              which keeps counters for the heap use of the application.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef HEAP_USAGE_H_
+#define HEAP_USAGE_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* A warning is printed when the heap in use crosses this percentage of the
+ * heap, and again only after it has dropped back below it.
+ */
+#ifndef HEAP_USAGE_WARN_PERCENT
+#define HEAP_USAGE_WARN_PERCENT             (85u)
+#endif
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+typedef struct
+{
+    uint32_t heap_size;         /* Size of the heap region */
+    uint32_t current;           /* Bytes held through pvPortMalloc() */
+    uint32_t peak;              /* Highest 'current' since boot or the last reset */
+    uint32_t alloc_count;       /* pvPortMalloc() calls */
+    uint32_t free_count;        /* vPortFree() calls */
+    uint32_t alloc_failures;    /* pvPortMalloc() calls that returned NULL */
+} heap_usage_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void heap_usage_sample(void);
+void heap_usage_reset_peak(void);
+void heap_usage_get_stats(heap_usage_stats_t *stats);
+void print_heap_usage(char *msg);
+
+/* Hot path hooks, see traceMALLOC and traceFREE in FreeRTOSConfig.h */
+void heap_usage_on_malloc(void *ptr);
+void heap_usage_on_free(void *ptr);
+
+#endif /* HEAP_USAGE_H_ */
+
+/* [] END OF FILE */
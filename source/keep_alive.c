@@ -0,0 +1,460 @@
+/******************************************************************************
+* File Name:   keep_alive.c
+*
+* Description: This file contains the adaptive keep-alive manager. Any packet
+*              in either direction counts as liveness; only when the path has
+*              been idle for the current interval does coreMQTT send a
+*              PINGREQ, see PACKET_TX_TIMEOUT_MS in core_mqtt_config.h. The
+*              interval is learned per network: it grows while pings get
+*              answered and is bisected between the longest idle time that
+*              survived and the shortest that did not, so it settles just
+*              under the idle timeout of the NAT or access point.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "cyabs_rtos.h"
+
+#include "core_mqtt_config.h"
+#include "mqtt_client_config.h"
+#include "mqtt_transport.h"
+#include "mqtt_task.h"
+#include "app_log.h"
+#include "keep_alive.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Polling interval while waiting for the reply to a PINGREQ. */
+#define KEEP_ALIVE_PINGRESP_POLL_MS         (100u)
+
+#if (KEEP_ALIVE_MIN_SECONDS > KEEP_ALIVE_INITIAL_SECONDS) || (KEEP_ALIVE_INITIAL_SECONDS > KEEP_ALIVE_MAX_SECONDS)
+#error "KEEP_ALIVE_INITIAL_SECONDS must lie between KEEP_ALIVE_MIN_SECONDS and KEEP_ALIVE_MAX_SECONDS"
+#endif
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+typedef struct keep_alive
+{
+    TaskHandle_t    task;
+    /* MQTT connection being watched. */
+    cy_mqtt_t       mqtt_handle;
+    /* Idle interval in seconds after which the next PINGREQ is sent. */
+    uint32_t        interval;
+    /* Longest idle time in seconds the path survived, 0 if none yet. */
+    uint32_t        survived;
+    /* Shortest idle time in seconds after which it closed, 0 if none yet. */
+    uint32_t        failed;
+    /* Set while the MQTT connection is up and its loss not yet reported. */
+    bool            connected;
+    bool            initialized;
+    /* Set from the moment coreMQTT is let ping until the task has seen
+     * whether the ping was answered, with the time it went out and how long
+     * the path was idle before.
+     */
+    bool            probe_pending;
+    uint32_t        probe_sent_at;
+    uint32_t        probe_idle_ms;
+} keep_alive_t;
+
+static keep_alive_t keep_alive;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void keep_alive_update(uint32_t idle_seconds, bool answered);
+static bool keep_alive_wait_for_answer(uint32_t sent_at);
+static void keep_alive_task(void *pvParameters);
+
+/******************************************************************************
+ * Function Name: keep_alive_update
+ ******************************************************************************
+ * Summary:
+ *  Records the outcome of a ping sent after 'idle_seconds' without traffic
+ *  and picks the interval to try next. Until the path has failed once the
+ *  interval grows by half each time; after that it is bisected between the
+ *  longest idle time that survived and the shortest that failed, and stays
+ *  at the former once the two are KEEP_ALIVE_RESOLUTION_SECONDS apart.
+ *
+ * Parameters:
+ *  uint32_t idle_seconds : Time the path was idle before the ping
+ *  bool answered : True if anything arrived after the ping
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void keep_alive_update(uint32_t idle_seconds, bool answered)
+{
+    uint32_t next;
+
+    taskENTER_CRITICAL();
+
+    if (answered)
+    {
+        if (idle_seconds > keep_alive.survived)
+        {
+            keep_alive.survived = idle_seconds;
+        }
+        /* The path may have changed since the failure was recorded. */
+        if ((keep_alive.failed != 0) && (keep_alive.failed <= keep_alive.survived))
+        {
+            keep_alive.failed = 0;
+        }
+    }
+    else if ((keep_alive.failed == 0) || (idle_seconds < keep_alive.failed))
+    {
+        keep_alive.failed = idle_seconds;
+    }
+
+    if (keep_alive.failed == 0)
+    {
+        next = keep_alive.survived + (keep_alive.survived / 2u);
+    }
+    else if ((keep_alive.failed - keep_alive.survived) > KEEP_ALIVE_RESOLUTION_SECONDS)
+    {
+        next = keep_alive.survived + ((keep_alive.failed - keep_alive.survived) / 2u);
+    }
+    else
+    {
+        next = keep_alive.survived;
+    }
+
+    if (next < KEEP_ALIVE_MIN_SECONDS)
+    {
+        next = KEEP_ALIVE_MIN_SECONDS;
+    }
+    if (next > KEEP_ALIVE_MAX_SECONDS)
+    {
+        next = KEEP_ALIVE_MAX_SECONDS;
+    }
+    keep_alive.interval = next;
+
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_wait_for_answer
+ ******************************************************************************
+ * Summary:
+ *  Waits up to KEEP_ALIVE_PINGRESP_TIMEOUT_MS for the connection to receive
+ *  anything after a PINGREQ that coreMQTT sent at 'sent_at'. The PINGRESP
+ *  itself is consumed by coreMQTT.
+ *
+ * Parameters:
+ *  uint32_t sent_at : cy_rtos_get_time() when the PINGREQ went out
+ *
+ * Return:
+ *  bool : True if the path answered
+ *
+ ******************************************************************************/
+static bool keep_alive_wait_for_answer(uint32_t sent_at)
+{
+    uint32_t last_sent;
+    uint32_t last_received;
+
+    for (uint32_t waited = 0; waited < KEEP_ALIVE_PINGRESP_TIMEOUT_MS; waited += KEEP_ALIVE_PINGRESP_POLL_MS)
+    {
+        vTaskDelay(pdMS_TO_TICKS(KEEP_ALIVE_PINGRESP_POLL_MS));
+
+        if (CY_RSLT_SUCCESS != mqtt_transport_get_activity(keep_alive.mqtt_handle, &last_sent, &last_received))
+        {
+            return false;
+        }
+        if ((int32_t) (last_received - sent_at) >= 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_task
+ ******************************************************************************
+ * Summary:
+ *  Woken by keep_alive_get_ping_timeout_ms() when coreMQTT is about to ping
+ *  an idle path, and judges the ping. A ping that goes unanswered means the
+ *  path closed before the interval was up: the interval is lowered and the
+ *  MQTT client task is told to reconnect, unless the MQTT event callback has
+ *  reported the loss already.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void keep_alive_task(void *pvParameters)
+{
+    uint32_t sent_at;
+    uint32_t idle_ms;
+    bool pending;
+    bool answered;
+    mqtt_task_cmd_t mqtt_task_cmd = HANDLE_DISCONNECTION;
+
+    (void) pvParameters;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        taskENTER_CRITICAL();
+        pending = keep_alive.probe_pending;
+        sent_at = keep_alive.probe_sent_at;
+        idle_ms = keep_alive.probe_idle_ms;
+        taskEXIT_CRITICAL();
+
+        if (!pending)
+        {
+            continue;
+        }
+
+        answered = keep_alive_wait_for_answer(sent_at);
+        keep_alive_update(idle_ms / 1000u, answered);
+
+        taskENTER_CRITICAL();
+        keep_alive.probe_pending = false;
+        taskEXIT_CRITICAL();
+
+        APP_LOG("Keep-alive: ping after %lu s idle %s, next interval %lu s\n",
+                (unsigned long) (idle_ms / 1000u), answered ? "answered" : "lost",
+                (unsigned long) keep_alive.interval);
+
+        if (!answered && keep_alive_disconnected())
+        {
+            xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_get_ping_timeout_ms
+ ******************************************************************************
+ * Summary:
+ *  Time in milliseconds without sending after which coreMQTT pings, read
+ *  through PACKET_TX_TIMEOUT_MS each time MQTT_ProcessLoop() checks the
+ *  keep-alive. The ping is thus sent by coreMQTT under the lock of the MQTT
+ *  library. Returns the learned interval once nothing has been received for
+ *  that long either, else UINT32_MAX so only the CONNECT keep-alive applies.
+ *  If the path is idle both ways, coreMQTT pings right after this returns,
+ *  so the ping is handed to the keep-alive task to judge.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Send timeout in milliseconds
+ *
+ ******************************************************************************/
+uint32_t keep_alive_get_ping_timeout_ms(void)
+{
+    uint32_t now;
+    uint32_t last_sent;
+    uint32_t last_received;
+    uint32_t interval_ms = keep_alive.interval * 1000u;
+    bool probe = false;
+
+    if (!keep_alive.connected ||
+        (CY_RSLT_SUCCESS != mqtt_transport_get_activity(keep_alive.mqtt_handle, &last_sent, &last_received)))
+    {
+        return UINT32_MAX;
+    }
+
+    cy_rtos_get_time(&now);
+    if ((now - last_received) < interval_ms)
+    {
+        /* Traffic from the broker pushes the next ping back. */
+        return UINT32_MAX;
+    }
+
+    if ((now - last_sent) >= interval_ms)
+    {
+        taskENTER_CRITICAL();
+        if (!keep_alive.probe_pending)
+        {
+            keep_alive.probe_pending = true;
+            keep_alive.probe_sent_at = now;
+            keep_alive.probe_idle_ms = ((int32_t) (last_sent - last_received) > 0) ?
+                                       (now - last_sent) : (now - last_received);
+            probe = true;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    if (probe && (keep_alive.task != NULL))
+    {
+        xTaskNotifyGive(keep_alive.task);
+    }
+
+    return interval_ms;
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_init
+ ******************************************************************************
+ * Summary:
+ *  Starts the keep-alive task at KEEP_ALIVE_INITIAL_SECONDS. coreMQTT keeps
+ *  to the CONNECT keep-alive until keep_alive_connected() is called.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value
+ *
+ ******************************************************************************/
+cy_rslt_t keep_alive_init(void)
+{
+    if (keep_alive.initialized)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    keep_alive.interval = KEEP_ALIVE_INITIAL_SECONDS;
+
+    if (pdPASS != xTaskCreate(keep_alive_task, "Keep-alive", KEEP_ALIVE_TASK_STACK_SIZE,
+                              NULL, KEEP_ALIVE_TASK_PRIORITY, &keep_alive.task))
+    {
+        printf("Keep-alive: failed to create the keep-alive task!\n");
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    keep_alive.initialized = true;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_connected
+ ******************************************************************************
+ * Summary:
+ *  Called once the MQTT connection is up, to start watching it.
+ *
+ * Parameters:
+ *  cy_mqtt_t mqtt_handle : Handle of the connection that came up
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void keep_alive_connected(cy_mqtt_t mqtt_handle)
+{
+    keep_alive.mqtt_handle = mqtt_handle;
+    keep_alive.connected = true;
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_disconnected
+ ******************************************************************************
+ * Summary:
+ *  Marks the MQTT connection as lost. Both the MQTT event callback and the
+ *  keep-alive task may notice the loss; only the first caller gets true, so
+ *  the disconnection is handled once.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : True if the connection was up until this call
+ *
+ ******************************************************************************/
+bool keep_alive_disconnected(void)
+{
+    bool was_connected;
+
+    taskENTER_CRITICAL();
+    was_connected = keep_alive.connected;
+    keep_alive.connected = false;
+    taskEXIT_CRITICAL();
+
+    return was_connected;
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_reset
+ ******************************************************************************
+ * Summary:
+ *  Forgets what was learned about the path, to be called after joining a
+ *  Wi-Fi network, whose NAT may behave differently.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void keep_alive_reset(void)
+{
+    taskENTER_CRITICAL();
+    keep_alive.interval = KEEP_ALIVE_INITIAL_SECONDS;
+    keep_alive.survived = 0;
+    keep_alive.failed = 0;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: keep_alive_get_interval
+ ******************************************************************************
+ * Summary:
+ *  Returns the idle interval in seconds after which coreMQTT sends the next
+ *  ping.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Current interval in seconds
+ *
+ ******************************************************************************/
+uint32_t keep_alive_get_interval(void)
+{
+    return keep_alive.interval;
+}
+
+/* [] END OF FILE */
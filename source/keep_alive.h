@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   keep_alive.h
+*
+* Description: This file contains the declarations of the adaptive keep-alive
+*              manager, which learns how long the network path to the broker
+*              stays open without traffic and pings just inside that.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef KEEP_ALIVE_H_
+#define KEEP_ALIVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy_result.h"
+#include "cy_mqtt_api.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Idle interval in seconds tried first on a new network. */
+#ifndef KEEP_ALIVE_INITIAL_SECONDS
+#define KEEP_ALIVE_INITIAL_SECONDS          (MQTT_KEEP_ALIVE_SECONDS)
+#endif
+
+/* Longest idle interval in seconds that is probed. With the manager enabled
+ * this is also the keep-alive sent in CONNECT, so coreMQTT pings at least
+ * this often while the broker keeps sending, and the broker declares the
+ * client gone after one and a half times this interval.
+ */
+#ifndef KEEP_ALIVE_MAX_SECONDS
+#define KEEP_ALIVE_MAX_SECONDS              (900u)
+#endif
+
+/* Shortest idle interval in seconds the manager falls back to. */
+#ifndef KEEP_ALIVE_MIN_SECONDS
+#define KEEP_ALIVE_MIN_SECONDS              (20u)
+#endif
+
+/* Probing stops once the longest interval that survived and the shortest one
+ * that failed are this many seconds apart.
+ */
+#ifndef KEEP_ALIVE_RESOLUTION_SECONDS
+#define KEEP_ALIVE_RESOLUTION_SECONDS       (15u)
+#endif
+
+/* Time in milliseconds to wait for the PINGRESP, or any other packet, after
+ * a PINGREQ before the path is considered closed.
+ */
+#ifndef KEEP_ALIVE_PINGRESP_TIMEOUT_MS
+#define KEEP_ALIVE_PINGRESP_TIMEOUT_MS      (MQTT_PINGRESP_TIMEOUT_MS)
+#endif
+
+/* Task parameters for the keep-alive task, which only judges the pings
+ * coreMQTT sends. It runs level with the MQTT tasks so that an answer is not
+ * mistaken for a loss while they are busy.
+ */
+#define KEEP_ALIVE_TASK_PRIORITY            (2)
+#define KEEP_ALIVE_TASK_STACK_SIZE          (1024 * 1)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t keep_alive_init(void);
+void keep_alive_connected(cy_mqtt_t mqtt_handle);
+bool keep_alive_disconnected(void);
+void keep_alive_reset(void);
+uint32_t keep_alive_get_interval(void);
+uint32_t keep_alive_get_ping_timeout_ms(void);
+
+#endif /* KEEP_ALIVE_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,374 @@
+/******************************************************************************
+* File Name:   latency_histogram.c
+*
+* Description: This file contains the end-to-end latency histograms. Each
+*              button press is stamped with the low power timer in its
+*              interrupt, when the publisher task dequeues it, when the
+*              PUBLISH has been written to TLS and when the publish completes.
+*              The time between checkpoints goes into fixed log2 buckets, so
+*              recording is constant time and needs no allocation.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "cbor_codec.h"
+#include "task_monitor.h"
+#include "latency_histogram.h"
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+static latency_histogram_t latency_histograms[LATENCY_STAGE_COUNT];
+
+static const char *const latency_stage_names[LATENCY_STAGE_COUNT] =
+{
+    "queue", "submit", "ack", "total"
+};
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void latency_record(latency_stage_t stage, uint32_t ticks);
+
+/******************************************************************************
+ * Function Name: latency_record
+ ******************************************************************************
+ * Summary:
+ *  Adds one latency, given in latency_now() ticks, to the histogram of
+ *  'stage'.
+ *
+ * Parameters:
+ *  latency_stage_t stage : Stage the latency belongs to
+ *  uint32_t ticks : Latency in latency_now() ticks
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void latency_record(latency_stage_t stage, uint32_t ticks)
+{
+    uint32_t us = (uint32_t) latency_ticks_to_us(ticks);
+
+    taskENTER_CRITICAL();
+    latency_histogram_add(&latency_histograms[stage], us);
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: latency_histogram_add
+ ******************************************************************************
+ * Summary:
+ *  Adds one latency to a histogram owned by the caller, which serializes the
+ *  calls. The stage histograms are filled by latency_trace_complete().
+ *
+ * Parameters:
+ *  latency_histogram_t *histogram : Histogram to add to
+ *  uint32_t us : Latency in microseconds
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void latency_histogram_add(latency_histogram_t *histogram, uint32_t us)
+{
+    uint32_t bucket = (us < 2u) ? 0u : (31u - (uint32_t) __builtin_clz(us));
+
+    if (bucket >= LATENCY_HISTOGRAM_BUCKETS)
+    {
+        bucket = LATENCY_HISTOGRAM_BUCKETS - 1u;
+    }
+
+    histogram->count++;
+    histogram->sum_us += us;
+    histogram->buckets[bucket]++;
+    if (us > histogram->max_us)
+    {
+        histogram->max_us = us;
+    }
+}
+
+/******************************************************************************
+ * Function Name: latency_ticks_to_us
+ ******************************************************************************
+ * Summary:
+ *  Converts a difference of latency_now() values to microseconds.
+ *
+ * Parameters:
+ *  uint64_t ticks : Time in latency_now() ticks
+ *
+ * Return:
+ *  uint64_t : Time in microseconds
+ *
+ ******************************************************************************/
+uint64_t latency_ticks_to_us(uint64_t ticks)
+{
+    return (ticks * 1000000u) / TASK_MONITOR_RUNTIME_COUNTER_HZ;
+}
+
+/******************************************************************************
+ * Function Name: latency_now
+ ******************************************************************************
+ * Summary:
+ *  Returns a checkpoint. Callable from interrupts. The checkpoints are taken
+ *  from the low power timer behind the run time stats, which keeps counting
+ *  while the device is in deep sleep between the stages of an event. It
+ *  resolves about 31 us and wraps after 36.4 hours, which bounds the longest
+ *  latency that can be measured.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Current count in ticks of TASK_MONITOR_RUNTIME_COUNTER_HZ,
+ *             never 0
+ *
+ ******************************************************************************/
+uint32_t latency_now(void)
+{
+    /* 0 marks a checkpoint that was not reached. */
+    return task_monitor_runtime_counter_get() | 1u;
+}
+
+/******************************************************************************
+ * Function Name: latency_trace_complete
+ ******************************************************************************
+ * Summary:
+ *  Records the stages of an event that completed at 'completed'. Stages with
+ *  a missing checkpoint, e.g. a publish that failed before it was written,
+ *  are left out; the total is always recorded.
+ *
+ * Parameters:
+ *  const latency_trace_t *trace : Checkpoints of the event
+ *  uint32_t completed : latency_now() at completion
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void latency_trace_complete(const latency_trace_t *trace, uint32_t completed)
+{
+    if ((NULL == trace) || (0u == trace->event))
+    {
+        return;
+    }
+
+    latency_record(LATENCY_STAGE_TOTAL, completed - trace->event);
+
+    if (0u != trace->dequeued)
+    {
+        latency_record(LATENCY_STAGE_QUEUE, trace->dequeued - trace->event);
+
+        if (0u != trace->written)
+        {
+            latency_record(LATENCY_STAGE_SUBMIT, trace->written - trace->dequeued);
+            latency_record(LATENCY_STAGE_ACK, completed - trace->written);
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: latency_get_histogram
+ ******************************************************************************
+ * Summary:
+ *  Copies the histogram of 'stage'.
+ *
+ * Parameters:
+ *  latency_stage_t stage : Stage to query
+ *  latency_histogram_t *histogram : Receives the histogram
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void latency_get_histogram(latency_stage_t stage, latency_histogram_t *histogram)
+{
+    if ((stage >= LATENCY_STAGE_COUNT) || (NULL == histogram))
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *histogram = latency_histograms[stage];
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: latency_reset
+ ******************************************************************************
+ * Summary:
+ *  Clears the histograms of all stages, e.g. to start a measurement run.
+ *  Publishes still in flight are recorded in the new histograms.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void latency_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(latency_histograms, 0, sizeof(latency_histograms));
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: latency_percentile_us
+ ******************************************************************************
+ * Summary:
+ *  Returns an upper bound of the given quantile: the top of the bucket it
+ *  falls in, but no more than the largest latency seen.
+ *
+ * Parameters:
+ *  const latency_histogram_t *histogram : Histogram to evaluate
+ *  uint32_t permille : Quantile in 1/1000, e.g. 990 for the 99th percentile
+ *
+ * Return:
+ *  uint32_t : Latency in microseconds, 0 for an empty histogram
+ *
+ ******************************************************************************/
+uint32_t latency_percentile_us(const latency_histogram_t *histogram, uint32_t permille)
+{
+    /* Rank of the sample the quantile points at, rounded up. */
+    uint64_t rank = (((uint64_t) histogram->count * permille) + 999u) / 1000u;
+    uint64_t seen = 0;
+    uint32_t bucket;
+
+    if (0u == histogram->count)
+    {
+        return 0;
+    }
+
+    for (bucket = 0; bucket < (LATENCY_HISTOGRAM_BUCKETS - 1u); bucket++)
+    {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+
+    if ((bucket < (LATENCY_HISTOGRAM_BUCKETS - 1u)) && ((2u << bucket) <= histogram->max_us))
+    {
+        return (2u << bucket) - 1u;
+    }
+
+    return histogram->max_us;
+}
+
+/******************************************************************************
+ * Function Name: latency_encode_summary
+ ******************************************************************************
+ * Summary:
+ *  Encodes all stages as CBOR for publishing: an array, in latency_stage_t
+ *  order, of [count, max, p50, p99, [buckets]] with times in microseconds.
+ *
+ * Parameters:
+ *  uint8_t *buffer : Output buffer, LATENCY_SUMMARY_MAX_SIZE bytes always fit
+ *  size_t size : Size of 'buffer'
+ *
+ * Return:
+ *  size_t : Length of the summary, 0 if it does not fit
+ *
+ ******************************************************************************/
+size_t latency_encode_summary(uint8_t *buffer, size_t size)
+{
+    cbor_writer_t writer;
+    latency_histogram_t histogram;
+
+    cbor_writer_init(&writer, buffer, size);
+    cbor_put_array(&writer, LATENCY_STAGE_COUNT);
+
+    for (uint32_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        latency_get_histogram((latency_stage_t) stage, &histogram);
+
+        cbor_put_array(&writer, 5u);
+        cbor_put_uint(&writer, histogram.count);
+        cbor_put_uint(&writer, histogram.max_us);
+        cbor_put_uint(&writer, latency_percentile_us(&histogram, 500u));
+        cbor_put_uint(&writer, latency_percentile_us(&histogram, 990u));
+        cbor_put_array(&writer, LATENCY_HISTOGRAM_BUCKETS);
+        for (uint32_t bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++)
+        {
+            cbor_put_uint(&writer, histogram.buckets[bucket]);
+        }
+    }
+
+    return cbor_writer_finish(&writer);
+}
+
+/******************************************************************************
+ * Function Name: latency_print
+ ******************************************************************************
+ * Summary:
+ *  Prints count, mean, median, 99th percentile and maximum of every stage.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void latency_print(void)
+{
+    latency_histogram_t histogram;
+
+    printf("  Latency (us)  count      mean       p50       p99       max\n");
+    for (uint32_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+    {
+        latency_get_histogram((latency_stage_t) stage, &histogram);
+        printf("  %-10s %8lu %9lu %9lu %9lu %9lu\n", latency_stage_names[stage],
+               (unsigned long) histogram.count,
+               (unsigned long) ((0u == histogram.count) ? 0u : (histogram.sum_us / histogram.count)),
+               (unsigned long) latency_percentile_us(&histogram, 500u),
+               (unsigned long) latency_percentile_us(&histogram, 990u),
+               (unsigned long) histogram.max_us);
+    }
+    printf("\n");
+}
+
+/* [] END OF FILE */
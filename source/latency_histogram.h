@@ -0,0 +1,111 @@
+/******************************************************************************
+* File Name:   latency_histogram.h
+*
+* Description: This file contains the declarations of the end-to-end latency
+*              histograms, which follow a button press from its interrupt to
+*              the acknowledgement of the resulting publish.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of buckets per histogram. Bucket 0 counts latencies below 2 us,
+ * bucket i those from 2^i up to 2^(i+1) us, and the last one everything
+ * above. 24 buckets reach 16 seconds.
+ */
+#ifndef LATENCY_HISTOGRAM_BUCKETS
+#define LATENCY_HISTOGRAM_BUCKETS           (24u)
+#endif
+
+/* Largest output of latency_encode_summary(): an array with one
+ * [count, max, p50, p99, [buckets]] array per stage, in microseconds.
+ */
+#define LATENCY_SUMMARY_MAX_SIZE            (1u + (LATENCY_STAGE_COUNT * \
+                                            (1u + (4u * 5u) + 5u + (LATENCY_HISTOGRAM_BUCKETS * 5u))))
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+/* Parts of the path from a button press to its acknowledgement. */
+typedef enum
+{
+    LATENCY_STAGE_QUEUE,        /* Interrupt until the publisher task dequeues it */
+    LATENCY_STAGE_SUBMIT,       /* Dequeue until the PUBLISH is written to TLS */
+    LATENCY_STAGE_ACK,          /* TLS write until the publish completes (PUBACK) */
+    LATENCY_STAGE_TOTAL,        /* Interrupt until the publish completes */
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+/* Checkpoints of one event, latency_now() values; 0 if not reached. */
+typedef struct
+{
+    uint32_t event;
+    uint32_t dequeued;
+    uint32_t written;
+} latency_trace_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+} latency_histogram_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+uint32_t latency_now(void);
+uint64_t latency_ticks_to_us(uint64_t ticks);
+void latency_trace_complete(const latency_trace_t *trace, uint32_t completed);
+void latency_get_histogram(latency_stage_t stage, latency_histogram_t *histogram);
+void latency_reset(void);
+void latency_histogram_add(latency_histogram_t *histogram, uint32_t us);
+uint32_t latency_percentile_us(const latency_histogram_t *histogram, uint32_t permille);
+size_t latency_encode_summary(uint8_t *buffer, size_t size);
+void latency_print(void);
+
+#endif /* LATENCY_HISTOGRAM_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,263 @@
+/******************************************************************************
+* File Name:   lz_compress.c
+*
+* Description: This file contains the payload compressor. It is an LZ77
+*              coder in the LZSS style: a flag byte announces the next eight
+*              items, each of which is either a literal byte or a two-byte
+*              match of 3 to 18 bytes at a distance of up to 4096 bytes.
+*              The match finder keeps one candidate per hash of three bytes,
+*              so it needs a fixed 512 bytes of state and no heap.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <string.h>
+
+#include "lz_compress.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (LZ_WINDOW_SIZE == 0u) || (LZ_WINDOW_SIZE > 4096u)
+#error "LZ_WINDOW_SIZE must be between 1 and 4096"
+#endif
+
+/* Marks an empty slot of the match finder. */
+#define LZ_NO_POSITION                      (0xFFFFu)
+
+/******************************************************************************
+ * Function Name: lz_hash
+ ******************************************************************************
+ * Summary:
+ *  Hashes the three bytes at 'p' into an index of the match finder.
+ *
+ * Parameters:
+ *  const uint8_t *p : Start of the three bytes
+ *
+ * Return:
+ *  uint32_t : Index into lz_compress_state_t.head
+ *
+ ******************************************************************************/
+static inline uint32_t lz_hash(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+
+    return (v * 2654435761u) >> (32u - LZ_HASH_BITS);
+}
+
+/******************************************************************************
+ * Function Name: lz_compress
+ ******************************************************************************
+ * Summary:
+ *  Compresses 'in' into 'out'. Gives up as soon as the coded form would not
+ *  fit 'out', so passing an 'out_size' below 'in_len' both bounds the output
+ *  buffer and skips payloads that do not compress.
+ *
+ * Parameters:
+ *  lz_compress_state_t *state : Working memory, initialized by this call
+ *  const uint8_t *in : Data to compress
+ *  size_t in_len : Length of the data, at most LZ_MAX_INPUT_SIZE
+ *  uint8_t *out : Receives the coded data
+ *  size_t out_size : Size of 'out'
+ *
+ * Return:
+ *  size_t : Length of the coded data, or 0 if it does not fit 'out'.
+ *
+ ******************************************************************************/
+size_t lz_compress(lz_compress_state_t *state, const uint8_t *in, size_t in_len,
+                   uint8_t *out, size_t out_size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    size_t flag_pos = 0;
+    uint32_t item = 0;
+    uint32_t candidate;
+    uint32_t match_len;
+    uint32_t max_len;
+    uint32_t distance;
+    uint32_t h;
+
+    if ((in_len == 0u) || (in_len > LZ_MAX_INPUT_SIZE))
+    {
+        return 0;
+    }
+
+    memset(state->head, 0xFF, sizeof(state->head));
+
+    while (ip < in_len)
+    {
+        if (0u == (item & 7u))
+        {
+            if (op >= out_size)
+            {
+                return 0;
+            }
+            flag_pos = op++;
+            out[flag_pos] = 0;
+        }
+
+        match_len = 0;
+        candidate = LZ_NO_POSITION;
+        if ((ip + LZ_MIN_MATCH) <= in_len)
+        {
+            h = lz_hash(&in[ip]);
+            candidate = state->head[h];
+            state->head[h] = (uint16_t) ip;
+
+            if ((LZ_NO_POSITION != candidate) && ((ip - candidate) <= LZ_WINDOW_SIZE))
+            {
+                max_len = ((in_len - ip) < LZ_MAX_MATCH) ? (uint32_t)(in_len - ip) : LZ_MAX_MATCH;
+                while ((match_len < max_len) && (in[candidate + match_len] == in[ip + match_len]))
+                {
+                    match_len++;
+                }
+            }
+        }
+
+        if (match_len >= LZ_MIN_MATCH)
+        {
+            if ((op + 2u) > out_size)
+            {
+                return 0;
+            }
+
+            distance = (uint32_t)(ip - candidate - 1u);
+            out[op++] = (uint8_t)(distance & 0xFFu);
+            out[op++] = (uint8_t)(((distance >> 8) << 4) | (match_len - LZ_MIN_MATCH));
+            out[flag_pos] |= (uint8_t)(1u << (item & 7u));
+
+            /* Remember the positions inside the match as well, repeats
+             * often start there.
+             */
+            for (uint32_t k = 1; (k < match_len) && ((ip + k + LZ_MIN_MATCH) <= in_len); k++)
+            {
+                state->head[lz_hash(&in[ip + k])] = (uint16_t)(ip + k);
+            }
+            ip += match_len;
+        }
+        else
+        {
+            if (op >= out_size)
+            {
+                return 0;
+            }
+            out[op++] = in[ip++];
+        }
+
+        item++;
+    }
+
+    return op;
+}
+
+/******************************************************************************
+ * Function Name: lz_decompress
+ ******************************************************************************
+ * Summary:
+ *  Restores data coded by lz_compress(). Malformed input is rejected rather
+ *  than read or written out of bounds.
+ *
+ * Parameters:
+ *  const uint8_t *in : Coded data
+ *  size_t in_len : Length of the coded data
+ *  uint8_t *out : Receives the original data
+ *  size_t out_size : Size of 'out'
+ *
+ * Return:
+ *  size_t : Length of the original data, or 0 if the input is malformed or
+ *           does not fit 'out'.
+ *
+ ******************************************************************************/
+size_t lz_decompress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    uint32_t flags = 0;
+    uint32_t item = 0;
+    uint32_t distance;
+    uint32_t length;
+
+    while (ip < in_len)
+    {
+        if (0u == (item & 7u))
+        {
+            flags = in[ip++];
+            if (ip == in_len)
+            {
+                break;
+            }
+        }
+
+        if (0u != (flags & (1u << (item & 7u))))
+        {
+            if ((ip + 2u) > in_len)
+            {
+                return 0;
+            }
+
+            distance = ((uint32_t)in[ip] | ((uint32_t)(in[ip + 1u] >> 4) << 8)) + 1u;
+            length = (uint32_t)(in[ip + 1u] & 0x0Fu) + LZ_MIN_MATCH;
+            ip += 2u;
+
+            if ((distance > op) || ((op + length) > out_size))
+            {
+                return 0;
+            }
+
+            /* Byte by byte, a match may overlap the data it produces. */
+            while (length-- > 0u)
+            {
+                out[op] = out[op - distance];
+                op++;
+            }
+        }
+        else
+        {
+            if (op >= out_size)
+            {
+                return 0;
+            }
+            out[op++] = in[ip++];
+        }
+
+        item++;
+    }
+
+    return op;
+}
+
+/* [] END OF FILE */
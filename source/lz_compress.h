@@ -0,0 +1,100 @@
+/******************************************************************************
+* File Name:   lz_compress.h
+*
+* Description: This file contains the declarations of the payload compressor,
+*              a small-window LZ77 coder with a fixed RAM budget for
+*              repetitive text and binary telemetry.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef LZ_COMPRESS_H_
+#define LZ_COMPRESS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* How far back, in bytes, a match may reach. At most 4096, the reach of the
+ * 12-bit offset in the coded stream. A larger window finds more matches in
+ * long payloads; the RAM use does not depend on it.
+ */
+#ifndef LZ_WINDOW_SIZE
+#define LZ_WINDOW_SIZE                      (1024u)
+#endif
+
+/* The match finder remembers the last position of 2^LZ_HASH_BITS three-byte
+ * prefixes, which costs 2 * 2^LZ_HASH_BITS bytes in lz_compress_state_t.
+ */
+#ifndef LZ_HASH_BITS
+#define LZ_HASH_BITS                        (8u)
+#endif
+
+/* Shortest and longest match the coded stream can express. */
+#define LZ_MIN_MATCH                        (3u)
+#define LZ_MAX_MATCH                        (LZ_MIN_MATCH + 15u)
+
+/* Largest input lz_compress() accepts. */
+#define LZ_MAX_INPUT_SIZE                   (0xFFFFu)
+
+/* Output size that holds the coded form of any 'n' input bytes: every byte
+ * a literal plus one flag byte per eight items.
+ */
+#define LZ_COMPRESS_BOUND(n)                ((n) + (((n) + 7u) / 8u))
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+/* Working memory of the compressor. Owned by the caller so that it can be
+ * static, on the stack, or shared by callers that do not run concurrently.
+ */
+typedef struct
+{
+    uint16_t head[1u << LZ_HASH_BITS];
+} lz_compress_state_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+size_t lz_compress(lz_compress_state_t *state, const uint8_t *in, size_t in_len,
+                   uint8_t *out, size_t out_size);
+size_t lz_decompress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_size);
+
+#endif /* LZ_COMPRESS_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,167 @@
+/******************************************************************************
+* File Name:   mailbox.c
+*
+* Description: This file contains the non-blocking hand offs used on the MQTT
+*              receive path, which must keep reading the network whatever the
+*              application tasks are doing.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "mailbox.h"
+
+/******************************************************************************
+ * Function Name: mailbox_post
+ ******************************************************************************
+ * Summary:
+ *  Stores 'value' in the mailbox, replacing a value that has not been taken.
+ *  Must only be called by the one producer of the mailbox.
+ *
+ * Parameters:
+ *  mailbox_t *mailbox : Mailbox to post to
+ *  uint32_t value : Value to post, anything but MAILBOX_EMPTY
+ *
+ * Return:
+ *  bool : True if an untaken value was replaced
+ *
+ ******************************************************************************/
+bool mailbox_post(mailbox_t *mailbox, uint32_t value)
+{
+    uint32_t previous = __atomic_exchange_n(&mailbox->slot, value, __ATOMIC_ACQ_REL);
+
+    if (MAILBOX_EMPTY != previous)
+    {
+        __atomic_fetch_add(&mailbox->coalesced, 1u, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: mailbox_take
+ ******************************************************************************
+ * Summary:
+ *  Takes the value from the mailbox, leaving it empty. Must only be called by
+ *  the one consumer of the mailbox.
+ *
+ * Parameters:
+ *  mailbox_t *mailbox : Mailbox to take from
+ *  uint32_t *value : Receives the value
+ *
+ * Return:
+ *  bool : True if there was a value
+ *
+ ******************************************************************************/
+bool mailbox_take(mailbox_t *mailbox, uint32_t *value)
+{
+    uint32_t taken;
+
+    /* Cheap check first, so an empty mailbox costs no exclusive access. */
+    if (MAILBOX_EMPTY == __atomic_load_n(&mailbox->slot, __ATOMIC_RELAXED))
+    {
+        return false;
+    }
+
+    taken = __atomic_exchange_n(&mailbox->slot, MAILBOX_EMPTY, __ATOMIC_ACQ_REL);
+    if (MAILBOX_EMPTY == taken)
+    {
+        return false;
+    }
+
+    *value = taken;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: queue_send_or_drop
+ ******************************************************************************
+ * Summary:
+ *  Sends 'item' to 'queue' without waiting. If the queue is full, either the
+ *  item or the oldest queued item is discarded according to 'policy', and
+ *  '*dropped' is incremented.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue to send to
+ *  const void *item : Item to send
+ *  void *scratch : Room for one item, used to discard the oldest one; may be
+ *                  NULL with QUEUE_DROP_NEWEST
+ *  queue_drop_policy_t policy : Item to give up when the queue is full
+ *  uint32_t *dropped : Drop counter, may be NULL
+ *
+ * Return:
+ *  bool : True if 'item' was queued
+ *
+ ******************************************************************************/
+bool queue_send_or_drop(QueueHandle_t queue, const void *item, void *scratch,
+                        queue_drop_policy_t policy, uint32_t *dropped)
+{
+    if (pdPASS == xQueueSend(queue, item, 0))
+    {
+        return true;
+    }
+
+    if ((QUEUE_DROP_OLDEST == policy) && (NULL != scratch))
+    {
+        /* The consumer may empty the queue in between, in which case nothing
+         * needs to be discarded.
+         */
+        if (pdPASS == xQueueReceive(queue, scratch, 0))
+        {
+            if (NULL != dropped)
+            {
+                __atomic_fetch_add(dropped, 1u, __ATOMIC_RELAXED);
+            }
+        }
+
+        /* Another producer may have taken the free slot, then 'item' itself
+         * is dropped.
+         */
+        if (pdPASS == xQueueSend(queue, item, 0))
+        {
+            return true;
+        }
+    }
+
+    if (NULL != dropped)
+    {
+        __atomic_fetch_add(dropped, 1u, __ATOMIC_RELAXED);
+    }
+
+    return false;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+/******************************************************************************
+* File Name:   mailbox.h
+*
+* Description: This file contains the declarations of the non-blocking hand
+*              offs used on the MQTT receive path: a latest-value mailbox for
+*              state that may be coalesced and a queue send with a drop policy
+*              for commands that may not.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Slot value of a mailbox that holds nothing; it cannot be posted. */
+#define MAILBOX_EMPTY                       (UINT32_MAX)
+
+/* Initializer for a mailbox_t. */
+#define MAILBOX_INIT                        { MAILBOX_EMPTY, 0u }
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Single value hand off from one producer to one consumer. A post replaces a
+ * value the consumer has not taken yet, so the consumer always sees the
+ * latest one. Neither side blocks or takes a lock.
+ */
+typedef struct mailbox
+{
+    uint32_t slot;                  /* Pending value or MAILBOX_EMPTY */
+    uint32_t coalesced;             /* Values replaced before they were taken */
+} mailbox_t;
+
+/* What queue_send_or_drop() gives up when the queue is full. */
+typedef enum
+{
+    QUEUE_DROP_NEWEST,              /* Discard the item being sent */
+    QUEUE_DROP_OLDEST               /* Discard the item at the front */
+} queue_drop_policy_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool mailbox_post(mailbox_t *mailbox, uint32_t value);
+bool mailbox_take(mailbox_t *mailbox, uint32_t *value);
+bool queue_send_or_drop(QueueHandle_t queue, const void *item, void *scratch,
+                        queue_drop_policy_t policy, uint32_t *dropped);
+
+#endif /* MAILBOX_H_ */
+
+/* [] END OF FILE */
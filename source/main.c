@@ -53,6 +53,18 @@
 #include "include/pal/pal_os_event.h"
 #include "include/pal/pal_i2c.h"
 #include "optiga_trust_helpers.h"
+#include "entropy_pool.h"
+#include "task_monitor.h"
+#include "app_log.h"
+#include "mqtt_client_config.h"
+#include "pkcs11_benchmark.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Stack size of the OPTIGA task, which also runs the certificate read. Check
+ * task_monitor_print_stacks() before changing it. */
+#define OPTIGA_CLIENT_TASK_STACK_SIZE   (1024 * 12)
 
 /******************************************************************************
 * Global Variables
@@ -69,7 +81,8 @@ extern void use_optiga_certificate(void);
  ******************************************************************************
  * Summary:
  *  A task to properly initialize the chip and use the certificate installed
- *  to the OPTIGA Secure Element. After this start the MQTT task
+ *  to the OPTIGA Secure Element. After this start the MQTT task and
+ *  delete itself.
  *
  * Parameters:
  *  void
@@ -81,15 +94,43 @@ extern void use_optiga_certificate(void);
 
 void optiga_client_task(void *pvParameters)
 {
-    char optiga_cert_pem[1200];
-    uint16_t optiga_cert_pem_size = 1200;
-
     printf("\x1b[2J\x1b[;H");
     optiga_trust_init();
-        /* This is the place where the certificate is initialized. This is a function
-     * which will allow to read it out and populate internal mbedtls settings wit it*/
-    read_certificate_from_optiga(0xe0e0, optiga_cert_pem, &optiga_cert_pem_size);
-    printf("Your certificate is:\n%s\n",optiga_cert_pem);
+
+    /* Seed the shared DRBG once, so that TLS, PKCS#11 and the MQTT client
+     * do not have to read the TRNG on every request.
+     */
+    if (CY_RSLT_SUCCESS != entropy_pool_init())
+    {
+        printf("Entropy pool initialization failed!\n");
+    }
+
+    /* Start draining the deferred log used on the MQTT paths. */
+    if (CY_RSLT_SUCCESS != app_log_init())
+    {
+        printf("Deferred log initialization failed!\n");
+    }
+
+    /* Watch the stack high-water marks so the task stacks can be sized from
+     * measured data. */
+    if (CY_RSLT_SUCCESS != task_monitor_init())
+    {
+        printf("Task monitor initialization failed!\n");
+    }
+
+#if ENABLE_PKCS11_BENCHMARK
+    /* Check and time the PKCS#11 module before TLS starts using it. */
+    if (CY_RSLT_SUCCESS != pkcs11_benchmark_run())
+    {
+        printf("PKCS#11 checks failed!\n");
+    }
+#endif
+
+    /* Show the device certificate. It is read as DER and converted to PEM one
+     * line at a time, TLS itself loads it as DER through PKCS#11. */
+    printf("Your certificate is:\n");
+    print_certificate_from_optiga(0xe0e0);
+    printf("\n");
 
     /* \x1b[2J\x1b[;H - ANSI ESC sequence to clear screen. */
     printf("===============================================================\n");
@@ -100,7 +141,10 @@ void optiga_client_task(void *pvParameters)
     xTaskCreate(mqtt_client_task, "MQTT Client task", MQTT_CLIENT_TASK_STACK_SIZE,
                 NULL, MQTT_CLIENT_TASK_PRIORITY, NULL);
 
-    while(1);
+    /* Nothing is left to do here. Delete the task instead of spinning, so
+     * that the priority 1 service tasks (deferred log, entropy reseed,
+     * keep-alive) get the CPU and the 12 KB stack is returned. */
+    vTaskDelete(NULL);
 }
 
 #ifdef ENABLE_SECURE_SOCKETS_LOGS
@@ -178,7 +222,7 @@ int main()
 
     /* Create an OPTIGA task to make sure everything related to
      * the OPTIGA stack will be called from the scheduler */
-    xTaskCreate(optiga_client_task, "OPTIGA", 1024 * 12, NULL, 2, NULL);
+    xTaskCreate(optiga_client_task, "OPTIGA", OPTIGA_CLIENT_TASK_STACK_SIZE, NULL, 2, NULL);
 
     /* Start the FreeRTOS scheduler. */
     vTaskStartScheduler();
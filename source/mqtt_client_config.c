@@ -44,6 +44,9 @@
 #include <stdio.h>
 #include "mqtt_client_config.h"
 #include "cy_mqtt_api.h"
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+#include "keep_alive.h"
+#endif
 
 /******************************************************************************
 * Global Variables
@@ -145,7 +148,12 @@ cy_mqtt_connect_info_t connection_info =
     .password = NULL,
     .password_len = 0,
     .clean_session = true,
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+    /* coreMQTT pings at the learned interval; this is only the backstop. */
+    .keep_alive_sec = KEEP_ALIVE_MAX_SECONDS,
+#else
     .keep_alive_sec = MQTT_KEEP_ALIVE_SECONDS,
+#endif
 #if ENABLE_LWT_MESSAGE
     .will_info = &will_msg_info
 #else
@@ -0,0 +1,604 @@
+/******************************************************************************
+* File Name:   mqtt_publish_async.c
+*
+* Description: This file contains the asynchronous MQTT publish service.
+*              Publishes are queued without blocking the caller and handed to
+*              MQTT_PUBLISH_WINDOW worker tasks, so up to that many publishes
+*              wait for their acknowledgement at the same time instead of one
+*              per broker round trip. Each publish has its own deadline and is
+*              retried until it succeeds, runs out of retries or times out.
+*              Payloads larger than the MQTT network buffer are published with
+*              mqtt_publish_stream(), which pulls them from the producer.
+*              Payloads encoded at run time are built in buffers from a fixed
+*              pool rather than on the heap.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "core_mqtt_config.h"
+#include "mqtt_client_config.h"
+#include "cy_tls_ext.h"
+#include "mqtt_transport.h"
+#include "mqtt_publish_async.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (MQTT_PUBLISH_WINDOW == 0u) || (MQTT_PUBLISH_WINDOW > MQTT_STATE_ARRAY_MAX_COUNT)
+#error "MQTT_PUBLISH_WINDOW must be between 1 and MQTT_STATE_ARRAY_MAX_COUNT"
+#endif
+
+/* PUBLISH packet type with QoS 0, and the retain flag. */
+#define MQTT_PACKET_TYPE_PUBLISH            (0x30u)
+#define MQTT_PUBLISH_FLAG_RETAIN            (0x01u)
+
+/* Largest value of the remaining length field. */
+#define MQTT_MAX_REMAINING_LENGTH           (268435455u)
+
+/* Packet type bits of the first byte of an MQTT packet. */
+#define MQTT_PACKET_TYPE_MASK               (0xF0u)
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+typedef struct
+{
+    cy_mqtt_publish_info_t      info;
+    mqtt_publish_complete_cb_t  callback;
+    void                        *arg;
+    TickType_t                  submitted;
+    TickType_t                  timeout;
+#if ENABLE_LATENCY_HISTOGRAM
+    latency_trace_t             trace;
+#endif
+} mqtt_publish_request_t;
+
+static cy_mqtt_t publish_handle = NULL;
+static QueueHandle_t publish_queue = NULL;
+static mqtt_publish_async_stats_t publish_stats;
+
+/* Payload buffer pool. The queue holds the free buffers. */
+static uint8_t publish_buffers[MQTT_PUBLISH_BUFFER_COUNT][MQTT_PUBLISH_BUFFER_SIZE];
+static QueueHandle_t publish_buffer_queue = NULL;
+
+#if ENABLE_LATENCY_HISTOGRAM
+/* Worker tasks and the trace of the request each one is publishing, for the
+ * TLS write checkpoint taken in mqtt_publish_packet_written().
+ */
+static TaskHandle_t publish_workers[MQTT_PUBLISH_WINDOW];
+static latency_trace_t *publish_worker_traces[MQTT_PUBLISH_WINDOW];
+
+/******************************************************************************
+ * Function Name: mqtt_publish_packet_written
+ ******************************************************************************
+ * Summary:
+ *  MQTT transport packet hook. Runs in the task that wrote the packet, so a PUBLISH
+ *  written by a worker belongs to the request that worker is publishing.
+ *  The first write is the checkpoint; retries count towards the ACK stage.
+ *
+ * Parameters:
+ *  uint8_t header : First byte of the packet
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_publish_packet_written(uint8_t header)
+{
+    TaskHandle_t task;
+
+    if ((header & MQTT_PACKET_TYPE_MASK) != MQTT_PACKET_TYPE_PUBLISH)
+    {
+        return;
+    }
+
+    task = xTaskGetCurrentTaskHandle();
+    for (uint32_t i = 0; i < MQTT_PUBLISH_WINDOW; i++)
+    {
+        if ((publish_workers[i] == task) && (NULL != publish_worker_traces[i]))
+        {
+            if (0u == publish_worker_traces[i]->written)
+            {
+                publish_worker_traces[i]->written = latency_now();
+            }
+            break;
+        }
+    }
+}
+#endif /* #if ENABLE_LATENCY_HISTOGRAM */
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async_expired
+ ******************************************************************************
+ * Summary:
+ *  Checks whether the deadline of a request has passed.
+ *
+ * Parameters:
+ *  const mqtt_publish_request_t *request : Request to check
+ *  TickType_t *remaining : Ticks left until the deadline (may be NULL)
+ *
+ * Return:
+ *  bool : true if the request ran out of time.
+ *
+ ******************************************************************************/
+static bool mqtt_publish_async_expired(const mqtt_publish_request_t *request, TickType_t *remaining)
+{
+    TickType_t elapsed = xTaskGetTickCount() - request->submitted;
+
+    if (elapsed >= request->timeout)
+    {
+        return true;
+    }
+
+    if (NULL != remaining)
+    {
+        *remaining = request->timeout - elapsed;
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async_send
+ ******************************************************************************
+ * Summary:
+ *  Publishes a request with retries. Every cy_mqtt_publish() call sends a
+ *  new message with a packet identifier of its own, so a retry is not a
+ *  redelivery the broker could match and drop. It is sent without the DUP
+ *  flag, and a QoS 1 or 2 message whose first attempt reached the broker
+ *  before failing locally (e.g. its PUBACK timed out) is delivered twice.
+ *
+ * Parameters:
+ *  mqtt_publish_request_t *request : Request to publish
+ *  uint32_t *attempts : Number of cy_mqtt_publish() calls made
+ *
+ * Return:
+ *  cy_rslt_t : Result of the last attempt or MQTT_PUBLISH_ASYNC_RSLT_TIMEOUT.
+ *
+ ******************************************************************************/
+static cy_rslt_t mqtt_publish_async_send(mqtt_publish_request_t *request, uint32_t *attempts)
+{
+    cy_rslt_t result = MQTT_PUBLISH_ASYNC_RSLT_TIMEOUT;
+    TickType_t remaining = 0;
+
+    *attempts = 0;
+
+    while (!mqtt_publish_async_expired(request, &remaining))
+    {
+#if defined(PRINT_TLS_SEND_STATS)
+        cy_tls_send_stats_t stats_before, stats_after;
+        cy_tls_get_send_stats(&stats_before);
+#endif
+
+        (*attempts)++;
+        result = cy_mqtt_publish(publish_handle, &request->info);
+
+#if defined(PRINT_TLS_SEND_STATS)
+        /* Cost of this publish on the wire, to compare with and without
+         * MQTT_TRANSPORT_COMBINE_BUFFER_SIZE. Exact only with a window of 1.
+         */
+        cy_tls_get_send_stats(&stats_after);
+        printf("  Publisher: %lu writes, %lu TLS records, %lu bytes on the wire\n\n",
+               (unsigned long)(stats_after.app_writes - stats_before.app_writes),
+               (unsigned long)(stats_after.records - stats_before.records),
+               (unsigned long)(stats_after.wire_bytes - stats_before.wire_bytes));
+#endif
+
+        if ((CY_RSLT_SUCCESS == result) || (*attempts > MQTT_PUBLISH_ASYNC_RETRY_LIMIT) ||
+            mqtt_publish_async_expired(request, &remaining))
+        {
+            break;
+        }
+
+        taskENTER_CRITICAL();
+        publish_stats.retries++;
+        taskEXIT_CRITICAL();
+
+        vTaskDelay((remaining < pdMS_TO_TICKS(MQTT_PUBLISH_ASYNC_RETRY_MS)) ?
+                   remaining : pdMS_TO_TICKS(MQTT_PUBLISH_ASYNC_RETRY_MS));
+    }
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_worker
+ ******************************************************************************
+ * Summary:
+ *  Worker task holding one slot of the publish window. It takes the next
+ *  request, publishes it and reports the result.
+ *
+ * Parameters:
+ *  void *pvParameters : Index of the slot in the window
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_publish_worker(void *pvParameters)
+{
+    mqtt_publish_request_t request;
+    cy_rslt_t result;
+    uint32_t attempts;
+    uint32_t latency_ms;
+#if ENABLE_LATENCY_HISTOGRAM
+    uint32_t index = (uint32_t) (uintptr_t) pvParameters;
+#else
+    (void) pvParameters;
+#endif
+
+    while (true)
+    {
+        if (pdTRUE != xQueueReceive(publish_queue, &request, portMAX_DELAY))
+        {
+            continue;
+        }
+
+#if ENABLE_LATENCY_HISTOGRAM
+        publish_worker_traces[index] = &request.trace;
+        result = mqtt_publish_async_send(&request, &attempts);
+        publish_worker_traces[index] = NULL;
+        if (CY_RSLT_SUCCESS == result)
+        {
+            latency_trace_complete(&request.trace, latency_now());
+        }
+#else
+        result = mqtt_publish_async_send(&request, &attempts);
+#endif
+        latency_ms = (uint32_t) ((xTaskGetTickCount() - request.submitted) * portTICK_PERIOD_MS);
+
+        taskENTER_CRITICAL();
+        if (CY_RSLT_SUCCESS == result)
+        {
+            publish_stats.completed++;
+        }
+        else
+        {
+            publish_stats.failed++;
+        }
+        publish_stats.in_flight--;
+        if (latency_ms > publish_stats.max_latency_ms)
+        {
+            publish_stats.max_latency_ms = latency_ms;
+        }
+        taskEXIT_CRITICAL();
+
+        if (NULL != request.callback)
+        {
+            request.callback(result, attempts, request.arg);
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async_init
+ ******************************************************************************
+ * Summary:
+ *  Creates the request queue and the MQTT_PUBLISH_WINDOW worker tasks. The
+ *  handle stays valid across reconnections, so this is called once.
+ *
+ * Parameters:
+ *  cy_mqtt_t mqtt_handle : Handle of the MQTT connection to publish on
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_publish_async_init(cy_mqtt_t mqtt_handle)
+{
+    char name[configMAX_TASK_NAME_LEN];
+
+    publish_handle = mqtt_handle;
+
+    if (NULL != publish_queue)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    publish_queue = xQueueCreate(MQTT_PUBLISH_QUEUE_LENGTH, sizeof(mqtt_publish_request_t));
+    publish_buffer_queue = xQueueCreate(MQTT_PUBLISH_BUFFER_COUNT, sizeof(uint8_t *));
+    if ((NULL == publish_queue) || (NULL == publish_buffer_queue))
+    {
+        printf("MQTT publish: failed to create the request queue!\n");
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    for (uint32_t i = 0; i < MQTT_PUBLISH_BUFFER_COUNT; i++)
+    {
+        mqtt_publish_buffer_free(publish_buffers[i]);
+    }
+
+#if ENABLE_LATENCY_HISTOGRAM
+    mqtt_transport_set_packet_hook(mqtt_publish_packet_written);
+#endif
+
+    for (uint32_t i = 0; i < MQTT_PUBLISH_WINDOW; i++)
+    {
+        snprintf(name, sizeof(name), "MQTT publish %lu", (unsigned long) i);
+#if ENABLE_LATENCY_HISTOGRAM
+        if (pdPASS != xTaskCreate(mqtt_publish_worker, name, MQTT_PUBLISH_WORKER_STACK_SIZE,
+                                  (void *) (uintptr_t) i, MQTT_PUBLISH_WORKER_PRIORITY, &publish_workers[i]))
+#else
+        if (pdPASS != xTaskCreate(mqtt_publish_worker, name, MQTT_PUBLISH_WORKER_STACK_SIZE,
+                                  NULL, MQTT_PUBLISH_WORKER_PRIORITY, NULL))
+#endif
+        {
+            printf("MQTT publish: failed to create worker %lu!\n", (unsigned long) i);
+            return ~CY_RSLT_SUCCESS;
+        }
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async
+ ******************************************************************************
+ * Summary:
+ *  Queues a publish and returns without waiting for it. The topic and payload
+ *  are not copied and must stay valid until the callback runs.
+ *
+ * Parameters:
+ *  const cy_mqtt_publish_info_t *publish_info : Message to publish
+ *  uint32_t timeout_ms : Deadline from now, including retries, 0 for
+ *                        MQTT_PUBLISH_ASYNC_TIMEOUT_MS
+ *  mqtt_publish_complete_cb_t callback : Completion callback (may be NULL)
+ *  void *arg : Argument passed to 'callback'
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if queued, else a non-zero value when the
+ *              service is not initialized or the queue is full.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_publish_async(const cy_mqtt_publish_info_t *publish_info, uint32_t timeout_ms,
+                             mqtt_publish_complete_cb_t callback, void *arg)
+{
+    return mqtt_publish_async_traced(publish_info, timeout_ms, callback, arg, NULL);
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async_traced
+ ******************************************************************************
+ * Summary:
+ *  Same as mqtt_publish_async(), for a publish caused by an event that is
+ *  traced. The TLS write checkpoint is added to a copy of 'trace', which is
+ *  recorded in the latency histograms when the publish succeeds. Without
+ *  ENABLE_LATENCY_HISTOGRAM the trace is ignored.
+ *
+ * Parameters:
+ *  const cy_mqtt_publish_info_t *publish_info : Message to publish
+ *  uint32_t timeout_ms : As for mqtt_publish_async()
+ *  mqtt_publish_complete_cb_t callback : Completion callback (may be NULL)
+ *  void *arg : Argument passed to 'callback'
+ *  const latency_trace_t *trace : Checkpoints so far (may be NULL)
+ *
+ * Return:
+ *  cy_rslt_t : As for mqtt_publish_async()
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_publish_async_traced(const cy_mqtt_publish_info_t *publish_info, uint32_t timeout_ms,
+                                    mqtt_publish_complete_cb_t callback, void *arg,
+                                    const latency_trace_t *trace)
+{
+    mqtt_publish_request_t request;
+
+    if (NULL == publish_queue)
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    request.info = *publish_info;
+    request.callback = callback;
+    request.arg = arg;
+    request.submitted = xTaskGetTickCount();
+    request.timeout = pdMS_TO_TICKS((0u != timeout_ms) ? timeout_ms : MQTT_PUBLISH_ASYNC_TIMEOUT_MS);
+#if ENABLE_LATENCY_HISTOGRAM
+    if (NULL != trace)
+    {
+        request.trace = *trace;
+        request.trace.written = 0;
+    }
+    else
+    {
+        request.trace.event = 0;
+    }
+#else
+    (void) trace;
+#endif
+
+    /* Count the request before a worker can complete it. */
+    taskENTER_CRITICAL();
+    publish_stats.submitted++;
+    publish_stats.in_flight++;
+    taskEXIT_CRITICAL();
+
+    if (pdTRUE != xQueueSend(publish_queue, &request, 0))
+    {
+        taskENTER_CRITICAL();
+        publish_stats.submitted--;
+        publish_stats.in_flight--;
+        taskEXIT_CRITICAL();
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_async_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the publish counters, for example to compute the throughput over
+ *  a measurement run.
+ *
+ * Parameters:
+ *  mqtt_publish_async_stats_t *stats : Receives the counters
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_publish_async_get_stats(mqtt_publish_async_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = publish_stats;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_buffer_alloc
+ ******************************************************************************
+ * Summary:
+ *  Takes a payload buffer of MQTT_PUBLISH_BUFFER_SIZE bytes from the pool,
+ *  without blocking. Encode the message into it, publish it with
+ *  mqtt_publish_async() and return it with mqtt_publish_buffer_free() from
+ *  the completion callback.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint8_t * : The buffer, or NULL if all are in use.
+ *
+ ******************************************************************************/
+uint8_t *mqtt_publish_buffer_alloc(void)
+{
+    uint8_t *buffer = NULL;
+
+    if ((NULL == publish_buffer_queue) ||
+        (pdTRUE != xQueueReceive(publish_buffer_queue, &buffer, 0)))
+    {
+        return NULL;
+    }
+
+    return buffer;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_buffer_free
+ ******************************************************************************
+ * Summary:
+ *  Returns a buffer taken with mqtt_publish_buffer_alloc() to the pool.
+ *
+ * Parameters:
+ *  uint8_t *buffer : Buffer to return, may be NULL
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_publish_buffer_free(uint8_t *buffer)
+{
+    if ((NULL != buffer) && (NULL != publish_buffer_queue))
+    {
+        /* There is room for every buffer of the pool, this cannot block. */
+        xQueueSend(publish_buffer_queue, &buffer, 0);
+    }
+}
+
+/******************************************************************************
+ * Function Name: mqtt_publish_stream
+ ******************************************************************************
+ * Summary:
+ *  Publishes a payload of 'payload_length' bytes at QoS 0 without holding it
+ *  in RAM. The PUBLISH header is sent with the full length, then the payload
+ *  is pulled from the producer in chunks that go straight to the TLS layer,
+ *  so it may be larger than MQTT_NETWORK_BUFFER_SIZE. The call blocks until
+ *  the last byte is written; other publishes wait meanwhile. It goes out on
+ *  the connection given to mqtt_publish_async_init().
+ *
+ *  QoS 1 and 2 need a packet identifier and acknowledgement tracking from
+ *  the MQTT library, which only takes payloads it holds in full.
+ *
+ * Parameters:
+ *  const char *topic : Topic to publish to
+ *  uint16_t topic_len : Length of the topic
+ *  bool retain : Whether the broker retains the message
+ *  uint32_t payload_length : Number of bytes 'pull' provides
+ *  mqtt_transport_pull_t pull : Producer of the payload
+ *  void *arg : Passed to 'pull'
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS once the whole packet is written, else a
+ *              non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_publish_stream(const char *topic, uint16_t topic_len, bool retain,
+                              uint32_t payload_length, mqtt_transport_pull_t pull, void *arg)
+{
+    /* Fixed header, remaining length, topic length and topic. */
+    uint8_t header[1u + 4u + 2u + MQTT_PUBLISH_STREAM_TOPIC_MAX_LEN];
+    uint32_t header_length = 0;
+    uint32_t remaining_length;
+
+    if ((NULL == topic) || (0u == topic_len) || (topic_len > MQTT_PUBLISH_STREAM_TOPIC_MAX_LEN) ||
+        (payload_length > (MQTT_MAX_REMAINING_LENGTH - 2u - topic_len)))
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    remaining_length = 2u + topic_len + payload_length;
+
+    header[header_length++] = MQTT_PACKET_TYPE_PUBLISH | (retain ? MQTT_PUBLISH_FLAG_RETAIN : 0u);
+    do
+    {
+        header[header_length] = (uint8_t)(remaining_length & 0x7Fu);
+        remaining_length >>= 7;
+        if (0u != remaining_length)
+        {
+            header[header_length] |= 0x80u;
+        }
+        header_length++;
+    } while (0u != remaining_length);
+
+    header[header_length++] = (uint8_t)(topic_len >> 8);
+    header[header_length++] = (uint8_t)(topic_len & 0xFFu);
+    memcpy(&header[header_length], topic, topic_len);
+    header_length += topic_len;
+
+    return mqtt_transport_send_stream(publish_handle, header, header_length, payload_length, pull, arg);
+}
+
+/* [] END OF FILE */
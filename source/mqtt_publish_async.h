@@ -0,0 +1,153 @@
+/******************************************************************************
+* File Name:   mqtt_publish_async.h
+*
+* Description: This file contains the declarations of the asynchronous MQTT
+*              publish service, which keeps a window of publishes in flight
+*              and reports each one through a completion callback.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef MQTT_PUBLISH_ASYNC_H_
+#define MQTT_PUBLISH_ASYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy_result.h"
+#include "cy_mqtt_api.h"
+#include "mqtt_transport.h"
+#include "latency_histogram.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of publishes in flight at a time. Each one is driven by its own
+ * worker task with a 4 KB stack. Must not exceed MQTT_STATE_ARRAY_MAX_COUNT
+ * in core_mqtt_config.h. A window above 1 only helps if cy_mqtt_publish()
+ * releases the MQTT library lock while it waits for the PUBACK, otherwise
+ * the workers take turns. Compare the msgs_per_s of the publish benchmark
+ * (ENABLE_PUBLISH_BENCHMARK) at 1 and 2 before raising it.
+ */
+#ifndef MQTT_PUBLISH_WINDOW
+#define MQTT_PUBLISH_WINDOW                 (1u)
+#endif
+
+/* Number of publishes that can wait for a free slot in the window. */
+#ifndef MQTT_PUBLISH_QUEUE_LENGTH
+#define MQTT_PUBLISH_QUEUE_LENGTH           (8u)
+#endif
+
+/* Time in milliseconds a publish may take from submission until the PUBACK,
+ * including retries, when the caller does not give one.
+ */
+#ifndef MQTT_PUBLISH_ASYNC_TIMEOUT_MS
+#define MQTT_PUBLISH_ASYNC_TIMEOUT_MS       (15000u)
+#endif
+
+/* The maximum number of times each PUBLISH will be retried. */
+#ifndef MQTT_PUBLISH_ASYNC_RETRY_LIMIT
+#define MQTT_PUBLISH_ASYNC_RETRY_LIMIT      (10u)
+#endif
+
+/* A failed PUBLISH is retried after this time (in milliseconds). */
+#ifndef MQTT_PUBLISH_ASYNC_RETRY_MS
+#define MQTT_PUBLISH_ASYNC_RETRY_MS         (1000u)
+#endif
+
+/* Reported to the completion callback when a publish ran out of time. */
+#define MQTT_PUBLISH_ASYNC_RSLT_TIMEOUT     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x100)
+
+/* Payload buffers for messages encoded at run time, see
+ * mqtt_publish_buffer_alloc(). A buffer is held from encoding until the
+ * completion callback, so one per window slot plus a few queued is enough.
+ */
+#ifndef MQTT_PUBLISH_BUFFER_COUNT
+#define MQTT_PUBLISH_BUFFER_COUNT           (MQTT_PUBLISH_WINDOW + 2u)
+#endif
+
+#ifndef MQTT_PUBLISH_BUFFER_SIZE
+#define MQTT_PUBLISH_BUFFER_SIZE            (64u)
+#endif
+
+/* Longest topic mqtt_publish_stream() accepts. The PUBLISH header is built
+ * on the stack of the caller.
+ */
+#ifndef MQTT_PUBLISH_STREAM_TOPIC_MAX_LEN
+#define MQTT_PUBLISH_STREAM_TOPIC_MAX_LEN   (64u)
+#endif
+
+/* Task parameters for the publish workers. */
+#define MQTT_PUBLISH_WORKER_PRIORITY        (2)
+#define MQTT_PUBLISH_WORKER_STACK_SIZE      (1024 * 1)
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+/* Called in a worker task when a publish completed: for QoS 1 and 2 after the
+ * acknowledgement, for QoS 0 after it was sent. 'result' is CY_RSLT_SUCCESS,
+ * the last error of cy_mqtt_publish() or MQTT_PUBLISH_ASYNC_RSLT_TIMEOUT.
+ * The callback must not block for long, it holds a slot of the window.
+ */
+typedef void (*mqtt_publish_complete_cb_t)(cy_rslt_t result, uint32_t attempts, void *arg);
+
+typedef struct
+{
+    uint32_t submitted;
+    uint32_t completed;         /* Publishes that succeeded */
+    uint32_t failed;            /* Publishes that failed or timed out */
+    uint32_t retries;
+    uint32_t in_flight;
+    uint32_t max_latency_ms;    /* Longest submission to completion time */
+} mqtt_publish_async_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t mqtt_publish_async_init(cy_mqtt_t mqtt_handle);
+cy_rslt_t mqtt_publish_async(const cy_mqtt_publish_info_t *publish_info, uint32_t timeout_ms,
+                             mqtt_publish_complete_cb_t callback, void *arg);
+cy_rslt_t mqtt_publish_async_traced(const cy_mqtt_publish_info_t *publish_info, uint32_t timeout_ms,
+                                    mqtt_publish_complete_cb_t callback, void *arg,
+                                    const latency_trace_t *trace);
+void mqtt_publish_async_get_stats(mqtt_publish_async_stats_t *stats);
+uint8_t *mqtt_publish_buffer_alloc(void);
+void mqtt_publish_buffer_free(uint8_t *buffer);
+cy_rslt_t mqtt_publish_stream(const char *topic, uint16_t topic_len, bool retain,
+                              uint32_t payload_length, mqtt_transport_pull_t pull, void *arg);
+
+#endif /* MQTT_PUBLISH_ASYNC_H_ */
+
+/* [] END OF FILE */
@@ -66,7 +66,19 @@
 #include "cy_wcm.h"
 
 #include "cy_mqtt_api.h"
-#include "clock.h"
+#include "cy_tls_ext.h"
+#include "cy_secure_sockets.h"
+#include "mqtt_transport.h"
+#include "entropy_pool.h"
+#include "heap_usage.h"
+#include "app_log.h"
+#include "mailbox.h"
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+#include "keep_alive.h"
+#endif
+#if ENABLE_HANDSHAKE_BENCHMARK
+#include "handshake_benchmark.h"
+#endif
 
 /* LwIP header files */
 #include "lwip/netif.h"
@@ -82,6 +94,16 @@
 /* Time in milliseconds to wait before creating the publisher task. */
 #define TASK_CREATION_DELAY_MS           (2000u)
 
+#if ENABLE_SINGLE_TASK_REACTOR
+#if (configUSE_QUEUE_SETS != 1)
+#error "ENABLE_SINGLE_TASK_REACTOR needs configUSE_QUEUE_SETS set to 1 in FreeRTOSConfig.h"
+#endif
+
+/* Every queue of the reactor can be full at the same time. */
+#define REACTOR_EVENT_SET_LENGTH         (MQTT_TASK_QUEUE_LENGTH + SUBSCRIBER_TASK_QUEUE_LENGTH + \
+                                          PUBLISHER_TASK_QUEUE_LENGTH)
+#endif /* ENABLE_SINGLE_TASK_REACTOR */
+
 /* Flag Masks for tracking which cleanup functions must be called. */
 #define WCM_INITIALIZED                  (1lu << 0)
 #define WIFI_CONNECTED                   (1lu << 1)
@@ -133,6 +155,13 @@ uint32_t status_flag;
  */
 uint8_t *mqtt_network_buffer = NULL;
 
+#if ENABLE_SINGLE_TASK_REACTOR
+/* Queue set of the MQTT, subscriber and publisher queues, all of which are
+ * served by this task.
+ */
+static QueueSetHandle_t reactor_event_set = NULL;
+#endif
+
 /******************************************************************************
 * Function Prototypes
 *******************************************************************************/
@@ -142,7 +171,17 @@ static cy_rslt_t mqtt_connect(void);
 
 void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *user_data);
 static void cleanup(void);
-void print_heap_usage(char *msg);
+static void send_to_subscriber(subscriber_cmd_t cmd);
+static void send_to_publisher(publisher_cmd_t cmd);
+static cy_rslt_t tls_wait_socket(void *caller_context, bool want_write, uint32_t timeout_ms);
+
+#if ENABLE_SINGLE_TASK_REACTOR
+static BaseType_t reactor_wait(mqtt_task_cmd_t *mqtt_status);
+#endif
+
+#if ENABLE_HANDSHAKE_BENCHMARK
+static cy_rslt_t run_handshake_benchmark(void);
+#endif
 
 #if GENERATE_UNIQUE_CLIENT_ID
 static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier);
@@ -166,12 +205,8 @@ static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier)
  ******************************************************************************/
 void mqtt_client_task(void *pvParameters)
 {
-    /* Structures that store the data to be sent/received to/from various
-     * message queues.
-     */
+    /* Structure that stores the data received from the message queue. */
     mqtt_task_cmd_t mqtt_status;
-    subscriber_data_t subscriber_q_data;
-    publisher_data_t publisher_q_data;
 
     /* Configure the Wi-Fi interface as a Wi-Fi STA (i.e. Client). */
     cy_wcm_config_t config = {.interface = CY_WCM_INTERFACE_TYPE_STA};
@@ -182,6 +217,12 @@ void mqtt_client_task(void *pvParameters)
     /* Create a message queue to communicate with other tasks and callbacks. */
     mqtt_task_q = xQueueCreate(MQTT_TASK_QUEUE_LENGTH, sizeof(mqtt_task_cmd_t));
 
+#if ENABLE_SINGLE_TASK_REACTOR
+    /* The queue must be empty when it joins the set, so join right away. */
+    reactor_event_set = xQueueCreateSet(REACTOR_EVENT_SET_LENGTH);
+    xQueueAddToSet(mqtt_task_q, reactor_event_set);
+#endif
+
     /* Initialize the Wi-Fi Connection Manager and jump to the cleanup block 
      * upon failure.
      */
@@ -203,6 +244,13 @@ void mqtt_client_task(void *pvParameters)
         goto exit_cleanup;
     }
 
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+    if (CY_RSLT_SUCCESS != keep_alive_init())
+    {
+        goto exit_cleanup;
+    }
+#endif
+
     /* Set-up the MQTT client and connect to the MQTT broker. Jump to the 
      * cleanup block if any of the operations fail.
      */
@@ -211,6 +259,23 @@ void mqtt_client_task(void *pvParameters)
         goto exit_cleanup;
     }
 
+#if ENABLE_HANDSHAKE_BENCHMARK
+    /* Measure the reconnect cost before the application starts publishing. */
+    if (CY_RSLT_SUCCESS != run_handshake_benchmark())
+    {
+        goto exit_cleanup;
+    }
+#endif
+
+#if ENABLE_SINGLE_TASK_REACTOR
+    /* The subscriber and publisher run in this task, see reactor_wait(). The
+     * subscribe completes before the publisher is set up.
+     */
+    subscriber_task_init(reactor_event_set);
+    publisher_task_init(reactor_event_set);
+
+    print_heap_usage("mqtt_client_task: subscriber & publisher started in the reactor");
+#else
     /* Create the subscriber task and cleanup if the operation fails. */
     if (pdPASS != xTaskCreate(subscriber_task, "Subscriber task", SUBSCRIBER_TASK_STACK_SIZE,
                               NULL, SUBSCRIBER_TASK_PRIORITY, &subscriber_task_handle))
@@ -231,11 +296,19 @@ void mqtt_client_task(void *pvParameters)
     }
 
     print_heap_usage("mqtt_client_task: subscriber & publisher tasks created");
+#endif /* ENABLE_SINGLE_TASK_REACTOR */
 
     while (true)
     {
+#if ENABLE_SINGLE_TASK_REACTOR
+        /* Serve the subscriber and publisher commands until one for this
+         * task arrives.
+         */
+        if (pdTRUE == reactor_wait(&mqtt_status))
+#else
         /* Wait for results of MQTT operations from other tasks and callbacks. */
         if (pdTRUE == xQueueReceive(mqtt_task_q, &mqtt_status, portMAX_DELAY))
+#endif
         {
             /* In this code example, the disconnection from the MQTT Broker or 
              * the Wi-Fi network is handled by the case 'HANDLE_DISCONNECTION'. 
@@ -262,8 +335,7 @@ void mqtt_client_task(void *pvParameters)
                 case HANDLE_DISCONNECTION:
                 {
                     /* Deinit the publisher before initiating reconnections. */
-                    publisher_q_data.cmd = PUBLISHER_DEINIT;
-                    xQueueSend(publisher_task_q, &publisher_q_data, portMAX_DELAY);
+                    send_to_publisher(PUBLISHER_DEINIT);
 
                     /* Although the connection with the MQTT Broker is lost, 
                      * call the MQTT disconnect API for cleanup of threads and 
@@ -291,12 +363,10 @@ void mqtt_client_task(void *pvParameters)
                     }
 
                     /* Initiate MQTT subscribe post the reconnection. */
-                    subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
-                    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+                    send_to_subscriber(SUBSCRIBE_TO_TOPIC);
 
                     /* Initialize Publisher post the reconnection. */
-                    publisher_q_data.cmd = PUBLISHER_INIT;
-                    xQueueSend(publisher_task_q, &publisher_q_data, portMAX_DELAY);
+                    send_to_publisher(PUBLISHER_INIT);
                     break;
                 }
 
@@ -371,6 +441,10 @@ static cy_rslt_t wifi_connect(void)
                  * successful Wi-Fi connection, print the assigned IP address.
                  */
                 status_flag |= WIFI_CONNECTED;
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+                /* The path to the broker may now go through another NAT. */
+                keep_alive_reset();
+#endif
                 if (ip_address.version == CY_WCM_IP_VER_V4)
                 {
                     printf("IPv4 Address Assigned: %s\n\n", ip4addr_ntoa((const ip4_addr_t *) &ip_address.ip.v4));
@@ -415,6 +489,17 @@ static cy_rslt_t mqtt_init(void)
     /* Variable to indicate status of various operations. */
     cy_rslt_t result = CY_RSLT_SUCCESS;
 
+    /* Let the TLS layer sleep on the socket instead of polling it. */
+    cy_tls_set_wait_callback(tls_wait_socket);
+
+    /* Set up the MQTT transport before the library can open a connection. */
+    result = mqtt_transport_init();
+    if (CY_RSLT_SUCCESS != result)
+    {
+        printf("MQTT transport initialization failed!\n\n");
+        return result;
+    }
+
     /* Initialize the MQTT library. */
     result = cy_mqtt_init();
     CHECK_RESULT(result, LIBS_INITIALIZED, "MQTT library initialization failed!\n\n");
@@ -445,13 +530,39 @@ static cy_rslt_t mqtt_init(void)
     return result;
 }
 
+/******************************************************************************
+ * Function Name: tls_wait_socket
+ ******************************************************************************
+ * Summary:
+ *  Wait callback for the TLS layer. The TLS contexts are created by the
+ *  secure sockets library with the socket handle as their caller context, so
+ *  waiting for the connection to become ready is a poll on that socket.
+ *
+ * Parameters:
+ *  void *caller_context : Secure sockets handle of the connection.
+ *  bool want_write : true to wait until writable, false until readable.
+ *  uint32_t timeout_ms : Time to wait in milliseconds, 0 for no limit.
+ *
+ * Return:
+ *  cy_rslt_t : Result of cy_socket_poll().
+ *
+ ******************************************************************************/
+static cy_rslt_t tls_wait_socket(void *caller_context, bool want_write, uint32_t timeout_ms)
+{
+    uint32_t rwflags = want_write ? CY_SOCKET_POLL_WRITE : CY_SOCKET_POLL_READ;
+
+    return cy_socket_poll((cy_socket_t)caller_context, &rwflags,
+                          (timeout_ms == 0) ? CY_SOCKET_NEVER_TIMEOUT : timeout_ms);
+}
+
 /******************************************************************************
  * Function Name: mqtt_connect
  ******************************************************************************
  * Summary:
  *  Function that initiates MQTT connect operation. The connection is retried
  *  a maximum of 'MAX_MQTT_CONN_RETRIES' times with interval of 
- *  'MQTT_CONN_RETRY_INTERVAL_MS' milliseconds.
+ *  'MQTT_CONN_RETRY_INTERVAL_MS' milliseconds plus a random jitter of up to
+ *  'MQTT_CONN_RETRY_JITTER_MS' milliseconds.
  *
  * Parameters:
  *  void
@@ -469,6 +580,12 @@ static cy_rslt_t mqtt_connect(void)
     /* MQTT client identifier string. */
     char mqtt_client_identifier[(MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1)] = MQTT_CLIENT_IDENTIFIER;
 
+    /* Delay before the next connection attempt, including random jitter. */
+    uint32_t retry_delay_ms;
+#if (MQTT_CONN_RETRY_JITTER_MS > 0)
+    uint32_t jitter = 0;
+#endif /* MQTT_CONN_RETRY_JITTER_MS */
+
     /* Configure the user credentials as a part of MQTT Connect packet */
     if (strlen(MQTT_USERNAME) > 0)
     {
@@ -511,8 +628,16 @@ static cy_rslt_t mqtt_connect(void)
             }
         }
 
-        /* Establish the MQTT connection. */
+        /* Establish the MQTT connection. The TLS connection is set up in this
+         * task, so the fragment length request applies to it alone.
+         */
+#if (MQTT_TLS_MAX_FRAG_LEN_CODE > 0)
+        cy_tls_set_task_mfl_code(MQTT_TLS_MAX_FRAG_LEN_CODE);
+#endif
         result = cy_mqtt_connect(mqtt_connection, &connection_info);
+#if (MQTT_TLS_MAX_FRAG_LEN_CODE > 0)
+        cy_tls_set_task_mfl_code(0);
+#endif
 
         if (result == CY_RSLT_SUCCESS)
         {
@@ -522,12 +647,23 @@ static cy_rslt_t mqtt_connect(void)
              * MQTT connection, and return the result to the calling function.
              */
             status_flag |= MQTT_CONNECTION_SUCCESS;
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+            keep_alive_connected(mqtt_connection);
+#endif
             return result;
         }
 
+        retry_delay_ms = MQTT_CONN_RETRY_INTERVAL_MS;
+#if (MQTT_CONN_RETRY_JITTER_MS > 0)
+        if (CY_RSLT_SUCCESS == entropy_pool_get_uint32(&jitter))
+        {
+            retry_delay_ms += jitter % (MQTT_CONN_RETRY_JITTER_MS + 1u);
+        }
+#endif /* MQTT_CONN_RETRY_JITTER_MS */
+
         printf("MQTT connection failed with error code 0x%0X. Retrying in %d ms. Retries left: %d\n", 
-               (int)result, MQTT_CONN_RETRY_INTERVAL_MS, (int)(MAX_MQTT_CONN_RETRIES - retry_count - 1));
-        vTaskDelay(pdMS_TO_TICKS(MQTT_CONN_RETRY_INTERVAL_MS));
+               (int)result, (int)retry_delay_ms, (int)(MAX_MQTT_CONN_RETRIES - retry_count - 1));
+        vTaskDelay(pdMS_TO_TICKS(retry_delay_ms));
     }
 
     printf("\nExceeded maximum MQTT connection attempts\n");
@@ -561,6 +697,8 @@ void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *use
 {
     cy_mqtt_publish_info_t *received_msg;
     mqtt_task_cmd_t mqtt_task_cmd;
+    mqtt_task_cmd_t dropped_cmd;
+    uint32_t dropped = 0;
 
     (void) mqtt_handle;
     (void) user_data;
@@ -572,17 +710,32 @@ void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *use
             /* Clear the status flag bit to indicate MQTT disconnection. */
             status_flag &= ~(MQTT_CONNECTION_SUCCESS);
 
+#if ENABLE_ADAPTIVE_KEEP_ALIVE
+            /* The keep-alive task may have reported the loss already. */
+            if (!keep_alive_disconnected())
+            {
+                break;
+            }
+#endif
+
             /* MQTT connection with the MQTT broker is broken as the client
              * is unable to communicate with the broker. Set the appropriate
              * command to be sent to the MQTT task.
              */
-            printf("\nUnexpectedly disconnected from MQTT broker!\n");
+            APP_LOG("\nUnexpectedly disconnected from MQTT broker!\n");
             mqtt_task_cmd = HANDLE_DISCONNECTION;
 
             /* Send the message to the MQTT client task to handle the 
-             * disconnection. 
+             * disconnection. This runs on the MQTT receive path, which must
+             * not block; if the queue is full, a pending failure report is
+             * less important than the disconnection and is dropped instead.
              */
-            xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+            queue_send_or_drop(mqtt_task_q, &mqtt_task_cmd, &dropped_cmd,
+                               QUEUE_DROP_OLDEST, &dropped);
+            if (dropped != 0)
+            {
+                APP_LOG("MQTT task queue full, a command was dropped!\n");
+            }
             break;
         }
 
@@ -600,7 +753,7 @@ void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *use
         default :
         {
             /* Unknown MQTT event */
-            printf("\nUnknown Event received from MQTT callback!\n");
+            APP_LOG("\nUnknown Event received from MQTT callback!\n");
             break;
         }
     }
@@ -612,7 +765,8 @@ void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *use
  ******************************************************************************
  * Summary:
  *  Function that generates unique client identifier for the MQTT client by
- *  appending a timestamp to a common prefix 'MQTT_CLIENT_IDENTIFIER'.
+ *  appending a random number from the entropy pool to a common prefix 
+ *  'MQTT_CLIENT_IDENTIFIER'.
  *
  * Parameters:
  *  char *mqtt_client_identifier : Pointer to the string that stores the 
@@ -626,12 +780,16 @@ void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *use
 static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier)
 {
     cy_rslt_t status = CY_RSLT_SUCCESS;
+    uint32_t random_suffix = 0;
+
+    status = entropy_pool_get_uint32(&random_suffix);
 
     /* Check for errors from snprintf. */
-    if (0 > snprintf(mqtt_client_identifier,
-                     (MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1),
-                     MQTT_CLIENT_IDENTIFIER "%lu",
-                     (long unsigned int)Clock_GetTimeMs()))
+    if ((CY_RSLT_SUCCESS == status) &&
+        (0 > snprintf(mqtt_client_identifier,
+                      (MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1),
+                      MQTT_CLIENT_IDENTIFIER "%lu",
+                      (long unsigned int)random_suffix)))
     {
         status = ~CY_RSLT_SUCCESS;
     }
@@ -640,6 +798,147 @@ static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier)
 }
 #endif /* GENERATE_UNIQUE_CLIENT_ID */
 
+#if ENABLE_HANDSHAKE_BENCHMARK
+/******************************************************************************
+ * Function Name: run_handshake_benchmark
+ ******************************************************************************
+ * Summary:
+ *  Disconnects from and reconnects to the MQTT broker
+ *  HANDSHAKE_BENCHMARK_ITERATIONS times and prints the cost of every
+ *  connection, see handshake_benchmark.h. Set CY_TLS_CIPHERSUITES or
+ *  CY_TLS_CURVES in the Makefile DEFINES to compare TLS parameters.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if the client is connected at the end, else
+ *              the error of the failed reconnection.
+ *
+ ******************************************************************************/
+static cy_rslt_t run_handshake_benchmark(void)
+{
+    handshake_benchmark_sample_t sample;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    printf("Running the reconnect benchmark...\n\n");
+
+    for (uint32_t i = 0; (i < HANDSHAKE_BENCHMARK_ITERATIONS) && (CY_RSLT_SUCCESS == result); i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(HANDSHAKE_BENCHMARK_INTERVAL_MS));
+        cy_mqtt_disconnect(mqtt_connection);
+
+        handshake_benchmark_begin(&sample);
+        result = mqtt_connect();
+        handshake_benchmark_end(&sample, i, result);
+    }
+
+    handshake_benchmark_report();
+
+    return result;
+}
+#endif /* ENABLE_HANDSHAKE_BENCHMARK */
+
+/******************************************************************************
+ * Function Name: send_to_subscriber
+ ******************************************************************************
+ * Summary:
+ *  Hands a command to the subscriber. With ENABLE_SINGLE_TASK_REACTOR the
+ *  subscriber runs in this task, so the command is handled right away instead
+ *  of being queued to itself.
+ *
+ * Parameters:
+ *  subscriber_cmd_t cmd : command for the subscriber
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void send_to_subscriber(subscriber_cmd_t cmd)
+{
+    subscriber_data_t subscriber_q_data = { .cmd = cmd, .data = 0 };
+
+#if ENABLE_SINGLE_TASK_REACTOR
+    subscriber_handle_command(&subscriber_q_data);
+#else
+    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: send_to_publisher
+ ******************************************************************************
+ * Summary:
+ *  Hands a command to the publisher, either directly with
+ *  ENABLE_SINGLE_TASK_REACTOR or through the publisher task queue.
+ *
+ * Parameters:
+ *  publisher_cmd_t cmd : command for the publisher
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void send_to_publisher(publisher_cmd_t cmd)
+{
+    publisher_data_t publisher_q_data = { .cmd = cmd, .data = NULL, .timestamp = 0 };
+
+#if ENABLE_SINGLE_TASK_REACTOR
+    publisher_handle_command(&publisher_q_data);
+#else
+    xQueueSend(publisher_task_q, &publisher_q_data, portMAX_DELAY);
+#endif
+}
+
+#if ENABLE_SINGLE_TASK_REACTOR
+/******************************************************************************
+ * Function Name: reactor_wait
+ ******************************************************************************
+ * Summary:
+ *  Blocks on the queue set and dispatches subscriber and publisher commands
+ *  in this task until a command for the MQTT client task arrives. The button
+ *  ISR, the MQTT event callback and the publish completions keep posting to
+ *  their usual queues, so only the consumer side changes.
+ *
+ * Parameters:
+ *  mqtt_task_cmd_t *mqtt_status : receives the MQTT client task command
+ *
+ * Return:
+ *  BaseType_t : pdTRUE when a command was stored in mqtt_status
+ *
+ ******************************************************************************/
+static BaseType_t reactor_wait(mqtt_task_cmd_t *mqtt_status)
+{
+    subscriber_data_t subscriber_q_data;
+    publisher_data_t publisher_q_data;
+    QueueSetMemberHandle_t member;
+
+    while (true)
+    {
+        member = xQueueSelectFromSet(reactor_event_set, portMAX_DELAY);
+
+        if (member == mqtt_task_q)
+        {
+            return xQueueReceive(mqtt_task_q, mqtt_status, 0);
+        }
+        else if (member == subscriber_task_q)
+        {
+            if (pdTRUE == xQueueReceive(subscriber_task_q, &subscriber_q_data, 0))
+            {
+                subscriber_handle_command(&subscriber_q_data);
+            }
+        }
+        else if (member == publisher_task_q)
+        {
+            if (pdTRUE == xQueueReceive(publisher_task_q, &publisher_q_data, 0))
+            {
+                publisher_handle_command(&publisher_q_data);
+            }
+        }
+    }
+}
+#endif /* ENABLE_SINGLE_TASK_REACTOR */
+
 /******************************************************************************
  * Function Name: cleanup
  ******************************************************************************
@@ -676,6 +975,7 @@ static void cleanup(void)
     if (status_flag & LIBS_INITIALIZED)
     {
         cy_mqtt_deinit();
+        mqtt_transport_deinit();
     }
     /* Disconnect from Wi-Fi AP. */
     if (status_flag & WIFI_CONNECTED)
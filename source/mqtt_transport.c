@@ -0,0 +1,1056 @@
+/******************************************************************************
+* File Name:   mqtt_transport.c
+*
+* Description: This file contains the MQTT transport. The MQTT library sends
+*              through cy_awsport_network_send() of its secure sockets port;
+*              the linker redirects those calls here (see the Makefile), so
+*              MQTT packet boundaries are known above the TLS layer, which
+*              stays protocol-agnostic.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "cyabs_rtos.h"
+#include "cy_tcpip_port_secure_sockets.h"
+
+#include "mqtt_transport.h"
+
+#if defined(MQTT_TRANSPORT_WRAP) && MQTT_TRANSPORT_WRAP
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+typedef struct mqtt_transport_connection
+{
+    /* Network context of the connection, NULL while the slot is free. */
+    NetworkContext_t            *network;
+
+    /* The user_data the MQTT library passed when creating the network
+     * context, which is its cy_mqtt_t handle, and whether it is connected.
+     */
+    cy_mqtt_t                   owner;
+    bool                        connected;
+
+    /* Bytes of the current MQTT packet still to be written, and the task
+     * writing it. The semaphore is taken from the first byte of a packet to
+     * the last and can be given back by any task when the packet is dropped.
+     * The mutex serialises single writes and guards these fields.
+     */
+    uint32_t                    packet_remaining;
+    uint8_t                     packet_header;
+    cy_thread_t                 packet_owner;
+    cy_semaphore_t              packet_sem;
+    cy_mutex_t                  packet_mutex;
+
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+    /* Pieces of the current packet waiting to be written in one go. */
+    uint8_t                     combine_buf[MQTT_TRANSPORT_COMBINE_BUFFER_SIZE];
+    uint32_t                    combine_len;
+#endif
+
+    /* When data last went out and came in, for keep-alive. */
+    cy_time_t                   last_sent_time;
+    cy_time_t                   last_received_time;
+} mqtt_transport_connection_t;
+
+static mqtt_transport_connection_t connections[MQTT_TRANSPORT_MAX_CONNECTIONS];
+
+/* Guards the 'network', 'owner' and 'connected' fields of the slots. */
+static cy_mutex_t connections_mutex;
+
+/* Held by mqtt_transport_send_stream() for a whole packet, so that a
+ * connection is not deleted under it.
+ */
+static cy_mutex_t stream_mutex;
+
+static mqtt_transport_packet_hook_t packet_hook = NULL;
+static bool transport_initialized = false;
+
+/* The functions of the secure sockets port, reached through the linker. */
+cy_rslt_t __real_cy_awsport_network_create(NetworkContext_t *network_context, cy_awsport_server_info_t *server_info,
+                                           cy_awsport_ssl_credentials_t *ssl_credentials,
+                                           cy_awsport_disconnect_callback_t disconn_cb, void *user_data);
+cy_rslt_t __real_cy_awsport_network_connect(NetworkContext_t *network_context, uint32_t sendtimeout, uint32_t recvtimeout);
+cy_rslt_t __real_cy_awsport_network_delete(NetworkContext_t *network_context);
+int32_t __real_cy_awsport_network_send(NetworkContext_t *network_context, const void *buffer, size_t bytes_to_send);
+int32_t __real_cy_awsport_network_receive(NetworkContext_t *network_context, void *buffer, size_t bytes_to_recv);
+
+/******************************************************************************
+ * Function Name: mqtt_transport_find
+ ******************************************************************************
+ * Summary:
+ *  Looks up the slot that tracks a network context.
+ *
+ * Parameters:
+ *  const NetworkContext_t *network : Network context to look for, or NULL
+ *                                    for a free slot
+ *
+ * Return:
+ *  mqtt_transport_connection_t * : The slot, or NULL if there is none.
+ *
+ ******************************************************************************/
+static mqtt_transport_connection_t *mqtt_transport_find(const NetworkContext_t *network)
+{
+    mqtt_transport_connection_t *connection = NULL;
+
+    cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for (uint32_t i = 0; i < MQTT_TRANSPORT_MAX_CONNECTIONS; i++)
+    {
+        if (connections[i].network == network)
+        {
+            connection = &connections[i];
+            break;
+        }
+    }
+    cy_rtos_set_mutex(&connections_mutex);
+
+    return connection;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_find_connected
+ ******************************************************************************
+ * Summary:
+ *  Looks up the connected slot of an MQTT handle. The caller holds
+ *  connections_mutex.
+ *
+ * Parameters:
+ *  cy_mqtt_t mqtt_handle : Handle the MQTT library created the connection for
+ *
+ * Return:
+ *  mqtt_transport_connection_t * : The slot, or NULL if the handle has no
+ *                                  tracked connection.
+ *
+ ******************************************************************************/
+static mqtt_transport_connection_t *mqtt_transport_find_connected(cy_mqtt_t mqtt_handle)
+{
+    for (uint32_t i = 0; i < MQTT_TRANSPORT_MAX_CONNECTIONS; i++)
+    {
+        if ((NULL != connections[i].network) && connections[i].connected &&
+            (connections[i].owner == mqtt_handle))
+        {
+            return &connections[i];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_packet_length
+ ******************************************************************************
+ * Summary:
+ *  Decodes the fixed header at the start of a write.
+ *
+ * Parameters:
+ *  const uint8_t *data : Start of the write
+ *  uint32_t length : Bytes at 'data'
+ *
+ * Return:
+ *  int32_t : Total length of the MQTT packet as given by its fixed header, 0
+ *            if the header is not complete yet, or -1 if 'data' does not
+ *            start with a valid fixed header.
+ *
+ ******************************************************************************/
+static int32_t mqtt_transport_packet_length(const uint8_t *data, uint32_t length)
+{
+    uint32_t remaining = 0;
+    uint32_t multiplier = 1;
+    uint32_t i;
+
+    /* Packet type 0 is reserved. */
+    if ((length > 0) && ((data[0] >> 4) == 0))
+    {
+        return -1;
+    }
+
+    /* The remaining length is encoded in at most four bytes. */
+    for (i = 1; (i < length) && (i <= 4); i++)
+    {
+        remaining += (uint32_t) (data[i] & 0x7F) * multiplier;
+        if ((data[i] & 0x80) == 0)
+        {
+            return (int32_t) (1 + i + remaining);
+        }
+        multiplier *= 128;
+    }
+
+    return (i > 4) ? -1 : 0;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_write
+ ******************************************************************************
+ * Summary:
+ *  Writes 'length' bytes through the secure sockets port, which encrypts
+ *  each call as one TLS record.
+ *
+ * Parameters:
+ *  NetworkContext_t *network : Connection to write to
+ *  const uint8_t *data : Bytes to write
+ *  uint32_t length : Number of bytes
+ *
+ * Return:
+ *  int32_t : Bytes written, fewer if the port timed out, or a negative value
+ *            if the connection failed before any byte was written.
+ *
+ ******************************************************************************/
+static int32_t mqtt_transport_write(NetworkContext_t *network, const uint8_t *data, uint32_t length)
+{
+    uint32_t written = 0;
+    int32_t ret;
+
+    while (written < length)
+    {
+        ret = __real_cy_awsport_network_send(network, data + written, length - written);
+        if (ret <= 0)
+        {
+            return (written > 0) ? (int32_t) written : ret;
+        }
+        written += (uint32_t) ret;
+    }
+
+    return (int32_t) written;
+}
+
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+/******************************************************************************
+ * Function Name: mqtt_transport_flush
+ ******************************************************************************
+ * Summary:
+ *  Writes out the combining buffer. Whatever is not written stays in the
+ *  buffer, in order.
+ *
+ * Parameters:
+ *  mqtt_transport_connection_t *connection : Connection to flush
+ *
+ * Return:
+ *  int32_t : Bytes still in the buffer, or a negative value if the
+ *            connection failed.
+ *
+ ******************************************************************************/
+static int32_t mqtt_transport_flush(mqtt_transport_connection_t *connection)
+{
+    int32_t ret;
+
+    if (connection->combine_len == 0)
+    {
+        return 0;
+    }
+
+    ret = mqtt_transport_write(connection->network, connection->combine_buf, connection->combine_len);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    memmove(connection->combine_buf, connection->combine_buf + ret, connection->combine_len - (uint32_t) ret);
+    connection->combine_len -= (uint32_t) ret;
+
+    return (int32_t) connection->combine_len;
+}
+#endif /* MQTT_TRANSPORT_COMBINE_BUFFER_SIZE */
+
+/******************************************************************************
+ * Function Name: mqtt_transport_end_packet
+ ******************************************************************************
+ * Summary:
+ *  Ends the packet in progress, after its last byte or because the
+ *  connection failed and the rest will never follow, and lets the next
+ *  writer in. Called with packet_mutex held.
+ *
+ * Parameters:
+ *  mqtt_transport_connection_t *connection : Connection of the packet
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_transport_end_packet(mqtt_transport_connection_t *connection)
+{
+    connection->packet_remaining = 0;
+    connection->packet_owner = NULL;
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+    connection->combine_len = 0;
+#endif
+    cy_rtos_set_semaphore(&connection->packet_sem, false);
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_drop_packet
+ ******************************************************************************
+ * Summary:
+ *  Drops a packet left open on a connection, by the calling task only if
+ *  'owner' is not NULL.
+ *
+ * Parameters:
+ *  mqtt_transport_connection_t *connection : Connection of the packet
+ *  cy_thread_t owner : Task that must own the packet, NULL for any
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void mqtt_transport_drop_packet(mqtt_transport_connection_t *connection, cy_thread_t owner)
+{
+    if (CY_RSLT_SUCCESS == cy_rtos_get_mutex(&connection->packet_mutex, MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS))
+    {
+        if ((connection->packet_remaining > 0) && ((NULL == owner) || (connection->packet_owner == owner)))
+        {
+            mqtt_transport_end_packet(connection);
+        }
+        cy_rtos_set_mutex(&connection->packet_mutex);
+    }
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_send_packet
+ ******************************************************************************
+ * Summary:
+ *  coreMQTT hands over the fixed header, topic, packet identifier and
+ *  payload of a PUBLISH as separate writes, and mqtt_transport_send_stream()
+ *  hands over a large payload in chunks. The fixed header in the first write
+ *  gives the length of the packet, and the connection belongs to the writer
+ *  until all of it has been written, so packets from different tasks never
+ *  interleave. Other writers wait at most MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS
+ *  for it. A packet that fits the combining buffer is collected and written
+ *  as a single TLS record, a larger one is written through.
+ *
+ *  A write that times out part-way leaves the packet open with the bytes not
+ *  yet written, so the caller can send the rest. Only a failed connection
+ *  drops the packet.
+ *
+ * Parameters:
+ *  mqtt_transport_connection_t *connection : Connection to write to
+ *  const uint8_t *data : Bytes to write
+ *  uint32_t length : Number of bytes
+ *
+ * Return:
+ *  int32_t : As for cy_awsport_network_send(): the bytes written, 0 if
+ *            none could be written yet, or a negative value on error.
+ *
+ ******************************************************************************/
+static int32_t mqtt_transport_send_packet(mqtt_transport_connection_t *connection, const uint8_t *data, uint32_t length)
+{
+    int32_t packet_length;
+    int32_t ret;
+    int32_t error = 0;
+    uint32_t sent = 0;
+    cy_thread_t self = NULL;
+    bool packet_start = false;
+    bool release_packet = false;
+
+    cy_rtos_get_thread_handle(&self);
+
+    if (CY_RSLT_SUCCESS != cy_rtos_get_mutex(&connection->packet_mutex, MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS))
+    {
+        return 0;
+    }
+
+    if ((connection->packet_remaining == 0) || (connection->packet_owner != self))
+    {
+        /* Not the rest of our own packet: wait until no packet is open. */
+        cy_rtos_set_mutex(&connection->packet_mutex);
+        if (CY_RSLT_SUCCESS != cy_rtos_get_semaphore(&connection->packet_sem, MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS, false))
+        {
+            return 0;
+        }
+        if (CY_RSLT_SUCCESS != cy_rtos_get_mutex(&connection->packet_mutex, MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS))
+        {
+            cy_rtos_set_semaphore(&connection->packet_sem, false);
+            return 0;
+        }
+
+        packet_length = mqtt_transport_packet_length(data, length);
+        if (packet_length > 0)
+        {
+            /* Keep the semaphore until the last byte of this packet. */
+            connection->packet_remaining = (uint32_t) packet_length;
+            connection->packet_header = data[0];
+            connection->packet_owner = self;
+            packet_start = true;
+        }
+        else
+        {
+            release_packet = true;
+        }
+    }
+
+    if (connection->packet_remaining == 0)
+    {
+        /* Not the start of an MQTT packet, write it as it is. */
+        ret = mqtt_transport_write(connection->network, data, length);
+        if (ret < 0)
+        {
+            error = ret;
+        }
+        else
+        {
+            sent = (uint32_t) ret;
+        }
+    }
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+    else if ((length <= connection->packet_remaining) &&
+             ((connection->combine_len + connection->packet_remaining) <= MQTT_TRANSPORT_COMBINE_BUFFER_SIZE) &&
+             ((connection->combine_len > 0) || (length < connection->packet_remaining)))
+    {
+        /* The rest of the packet fits the buffer. A complete packet in one
+         * write needs no copy and takes the branch below.
+         */
+        memcpy(connection->combine_buf + connection->combine_len, data, length);
+        connection->combine_len += length;
+        sent = length;
+
+        if (length == connection->packet_remaining)
+        {
+            ret = mqtt_transport_flush(connection);
+            if (ret < 0)
+            {
+                error = ret;
+            }
+            if (connection->combine_len > 0)
+            {
+                /* Earlier pieces were reported as written and stay in the
+                 * buffer. Hand back the unwritten tail of this one, so the
+                 * caller sends it again.
+                 */
+                uint32_t unwritten = (connection->combine_len < length) ? connection->combine_len : length;
+                connection->combine_len -= unwritten;
+                sent = length - unwritten;
+            }
+        }
+    }
+#endif /* MQTT_TRANSPORT_COMBINE_BUFFER_SIZE */
+    else
+    {
+        ret = 0;
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+        ret = mqtt_transport_flush(connection);
+#endif
+        if (ret < 0)
+        {
+            error = ret;
+        }
+        else if (ret == 0)
+        {
+            ret = mqtt_transport_write(connection->network, data, length);
+            if (ret < 0)
+            {
+                error = ret;
+            }
+            else
+            {
+                sent = (uint32_t) ret;
+            }
+        }
+    }
+
+    if (connection->packet_remaining > 0)
+    {
+        if (error < 0)
+        {
+            /* The connection failed, the rest of the packet will never follow. */
+            mqtt_transport_end_packet(connection);
+        }
+        else if (sent >= connection->packet_remaining)
+        {
+            mqtt_transport_end_packet(connection);
+            if (NULL != packet_hook)
+            {
+                packet_hook(connection->packet_header);
+            }
+        }
+        else
+        {
+            connection->packet_remaining -= sent;
+            if (packet_start && (sent == 0))
+            {
+                /* Nothing of the packet went out, so nothing needs to follow. */
+                mqtt_transport_end_packet(connection);
+            }
+        }
+    }
+    else if (release_packet)
+    {
+        cy_rtos_set_semaphore(&connection->packet_sem, false);
+    }
+
+    if (sent > 0)
+    {
+        cy_rtos_get_time(&connection->last_sent_time);
+    }
+
+    cy_rtos_set_mutex(&connection->packet_mutex);
+
+    return (sent > 0) ? (int32_t) sent : error;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_send_all
+ ******************************************************************************
+ * Summary:
+ *  Sends all of 'data' as part of the packet the calling task is writing,
+ *  sending the rest again after a write that timed out part-way. Gives up
+ *  once a write makes no progress.
+ *
+ * Parameters:
+ *  mqtt_transport_connection_t *connection : Connection to write to
+ *  const uint8_t *data : Bytes to write
+ *  uint32_t length : Number of bytes
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS, MQTT_TRANSPORT_RSLT_TIMEOUT or
+ *              MQTT_TRANSPORT_RSLT_ERROR.
+ *
+ ******************************************************************************/
+static cy_rslt_t mqtt_transport_send_all(mqtt_transport_connection_t *connection, const uint8_t *data, uint32_t length)
+{
+    int32_t ret;
+
+    while (length > 0)
+    {
+        ret = mqtt_transport_send_packet(connection, data, length);
+        if (ret <= 0)
+        {
+            return (ret == 0) ? MQTT_TRANSPORT_RSLT_TIMEOUT : MQTT_TRANSPORT_RSLT_ERROR;
+        }
+        data += ret;
+        length -= (uint32_t) ret;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: __wrap_cy_awsport_network_create
+ ******************************************************************************
+ * Summary:
+ *  Creates the network context in the secure sockets port and starts
+ *  tracking it.
+ *
+ ******************************************************************************/
+cy_rslt_t __wrap_cy_awsport_network_create(NetworkContext_t *network_context, cy_awsport_server_info_t *server_info,
+                                           cy_awsport_ssl_credentials_t *ssl_credentials,
+                                           cy_awsport_disconnect_callback_t disconn_cb, void *user_data)
+{
+    mqtt_transport_connection_t *connection;
+    cy_rslt_t result;
+
+    result = __real_cy_awsport_network_create(network_context, server_info, ssl_credentials, disconn_cb, user_data);
+    if ((CY_RSLT_SUCCESS != result) || !transport_initialized)
+    {
+        return result;
+    }
+
+    if (NULL != mqtt_transport_find(network_context))
+    {
+        /* Created again without being deleted, still tracked. */
+        return result;
+    }
+
+    cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for (uint32_t i = 0; i < MQTT_TRANSPORT_MAX_CONNECTIONS; i++)
+    {
+        connection = &connections[i];
+        if (NULL == connection->network)
+        {
+            connection->network = network_context;
+            connection->owner = (cy_mqtt_t) user_data;
+            connection->connected = false;
+            connection->packet_remaining = 0;
+            connection->packet_owner = NULL;
+#if (MQTT_TRANSPORT_COMBINE_BUFFER_SIZE > 0)
+            connection->combine_len = 0;
+#endif
+            break;
+        }
+    }
+    cy_rtos_set_mutex(&connections_mutex);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: __wrap_cy_awsport_network_connect
+ ******************************************************************************
+ * Summary:
+ *  Connects through the secure sockets port and opens the connection to
+ *  mqtt_transport_send_stream() for its MQTT handle.
+ *
+ ******************************************************************************/
+cy_rslt_t __wrap_cy_awsport_network_connect(NetworkContext_t *network_context, uint32_t sendtimeout, uint32_t recvtimeout)
+{
+    mqtt_transport_connection_t *connection;
+    cy_rslt_t result;
+
+    result = __real_cy_awsport_network_connect(network_context, sendtimeout, recvtimeout);
+    if ((CY_RSLT_SUCCESS != result) || !transport_initialized)
+    {
+        return result;
+    }
+
+    connection = mqtt_transport_find(network_context);
+    if (NULL != connection)
+    {
+        cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+        cy_rtos_get_time(&connection->last_sent_time);
+        connection->last_received_time = connection->last_sent_time;
+        connection->connected = true;
+        cy_rtos_set_mutex(&connections_mutex);
+    }
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: __wrap_cy_awsport_network_delete
+ ******************************************************************************
+ * Summary:
+ *  Stops tracking a network context, once a stream still writing to it has
+ *  finished, and deletes it in the secure sockets port.
+ *
+ ******************************************************************************/
+cy_rslt_t __wrap_cy_awsport_network_delete(NetworkContext_t *network_context)
+{
+    mqtt_transport_connection_t *connection = NULL;
+
+    if (transport_initialized && (NULL != network_context))
+    {
+        connection = mqtt_transport_find(network_context);
+    }
+
+    if (NULL != connection)
+    {
+        /* Wait for a stream that is still writing to this connection. Its
+         * writes are bounded by the socket timeout.
+         */
+        cy_rtos_get_mutex(&stream_mutex, CY_RTOS_NEVER_TIMEOUT);
+        cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+        connection->connected = false;
+        cy_rtos_set_mutex(&connections_mutex);
+        cy_rtos_set_mutex(&stream_mutex);
+
+        /* Drop a packet left open by a writer that gave up on it. */
+        mqtt_transport_drop_packet(connection, NULL);
+
+        cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+        connection->network = NULL;
+        cy_rtos_set_mutex(&connections_mutex);
+    }
+
+    return __real_cy_awsport_network_delete(network_context);
+}
+
+/******************************************************************************
+ * Function Name: __wrap_cy_awsport_network_send
+ ******************************************************************************
+ * Summary:
+ *  Send function of the MQTT library. Writes to a tracked connection follow
+ *  MQTT packet boundaries, see mqtt_transport_send_packet().
+ *
+ ******************************************************************************/
+int32_t __wrap_cy_awsport_network_send(NetworkContext_t *network_context, const void *buffer, size_t bytes_to_send)
+{
+    mqtt_transport_connection_t *connection = NULL;
+
+    if (transport_initialized && (NULL != network_context) && (NULL != buffer) && (bytes_to_send > 0))
+    {
+        connection = mqtt_transport_find(network_context);
+    }
+
+    if (NULL == connection)
+    {
+        return __real_cy_awsport_network_send(network_context, buffer, bytes_to_send);
+    }
+
+    return mqtt_transport_send_packet(connection, buffer, (uint32_t) bytes_to_send);
+}
+
+/******************************************************************************
+ * Function Name: __wrap_cy_awsport_network_receive
+ ******************************************************************************
+ * Summary:
+ *  Receive function of the MQTT library. Notes the time data last arrived.
+ *
+ ******************************************************************************/
+int32_t __wrap_cy_awsport_network_receive(NetworkContext_t *network_context, void *buffer, size_t bytes_to_recv)
+{
+    mqtt_transport_connection_t *connection;
+    int32_t ret;
+
+    ret = __real_cy_awsport_network_receive(network_context, buffer, bytes_to_recv);
+    if ((ret > 0) && transport_initialized && (NULL != network_context))
+    {
+        connection = mqtt_transport_find(network_context);
+        if (NULL != connection)
+        {
+            cy_rtos_get_time(&connection->last_received_time);
+        }
+    }
+
+    return ret;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_init
+ ******************************************************************************
+ * Summary:
+ *  Creates the locks of the transport. Call before the first connection.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else the RTOS error.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_transport_init(void)
+{
+    cy_rslt_t result;
+    uint32_t created = 0;
+
+    if (transport_initialized)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = cy_rtos_init_mutex(&connections_mutex);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        return result;
+    }
+    result = cy_rtos_init_mutex(&stream_mutex);
+    if (CY_RSLT_SUCCESS != result)
+    {
+        cy_rtos_deinit_mutex(&connections_mutex);
+        return result;
+    }
+
+    for (; created < MQTT_TRANSPORT_MAX_CONNECTIONS; created++)
+    {
+        memset(&connections[created], 0, sizeof(connections[created]));
+        result = cy_rtos_init_mutex(&connections[created].packet_mutex);
+        if (CY_RSLT_SUCCESS != result)
+        {
+            break;
+        }
+        result = cy_rtos_init_semaphore(&connections[created].packet_sem, 1, 1);
+        if (CY_RSLT_SUCCESS != result)
+        {
+            cy_rtos_deinit_mutex(&connections[created].packet_mutex);
+            break;
+        }
+    }
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        while (created > 0)
+        {
+            created--;
+            cy_rtos_deinit_semaphore(&connections[created].packet_sem);
+            cy_rtos_deinit_mutex(&connections[created].packet_mutex);
+        }
+        cy_rtos_deinit_mutex(&stream_mutex);
+        cy_rtos_deinit_mutex(&connections_mutex);
+        return result;
+    }
+
+    transport_initialized = true;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_deinit
+ ******************************************************************************
+ * Summary:
+ *  Releases the locks of the transport. Call once the MQTT library is
+ *  deinitialized and no connection is left.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_transport_deinit(void)
+{
+    if (!transport_initialized)
+    {
+        return;
+    }
+
+    transport_initialized = false;
+
+    for (uint32_t i = 0; i < MQTT_TRANSPORT_MAX_CONNECTIONS; i++)
+    {
+        cy_rtos_deinit_semaphore(&connections[i].packet_sem);
+        cy_rtos_deinit_mutex(&connections[i].packet_mutex);
+        connections[i].network = NULL;
+        connections[i].connected = false;
+    }
+
+    cy_rtos_deinit_mutex(&stream_mutex);
+    cy_rtos_deinit_mutex(&connections_mutex);
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_set_packet_hook
+ ******************************************************************************
+ * Summary:
+ *  Sets the function called after each MQTT packet is written.
+ *
+ * Parameters:
+ *  mqtt_transport_packet_hook_t hook : The function, NULL for none
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_transport_set_packet_hook(mqtt_transport_packet_hook_t hook)
+{
+    packet_hook = hook;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_send_stream
+ ******************************************************************************
+ * Summary:
+ *  Sends one MQTT packet on the connection of 'mqtt_handle'. 'header' holds everything up to the payload, its fixed header giving the full
+ *  length of the packet. The payload is then pulled from 'pull' until
+ *  'payload_length' bytes have been sent. No other task writes to the
+ *  connection in the meantime, so the packet arrives in one piece.
+ *
+ *  If 'pull' returns 0 early the rest of the payload is padded with zeros,
+ *  so the broker still sees a well formed packet, and an error is returned.
+ *  A packet without payload may pass NULL for 'pull'.
+ *
+ * Parameters:
+ *  cy_mqtt_t mqtt_handle : MQTT handle whose connection to write to
+ *  const void *header : Fixed and variable header of the packet
+ *  uint32_t header_length : Number of bytes at 'header'
+ *  uint32_t payload_length : Number of payload bytes to pull
+ *  mqtt_transport_pull_t pull : Producer of the payload
+ *  void *arg : Passed to 'pull'
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS once the whole packet is written, else an
+ *              MQTT_TRANSPORT_RSLT_* error.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_transport_send_stream(cy_mqtt_t mqtt_handle, const void *header, uint32_t header_length,
+                                     uint32_t payload_length, mqtt_transport_pull_t pull, void *arg)
+{
+    static const uint8_t padding[32];
+    mqtt_transport_connection_t *connection;
+    const void *chunk;
+    uint32_t chunk_length;
+    cy_thread_t self = NULL;
+    cy_rslt_t result;
+
+    if ((NULL == header) || ((NULL == pull) && (payload_length > 0)) ||
+        (mqtt_transport_packet_length(header, header_length) != (int32_t) (header_length + payload_length)))
+    {
+        return MQTT_TRANSPORT_RSLT_ERROR;
+    }
+
+    if (!transport_initialized)
+    {
+        return MQTT_TRANSPORT_RSLT_NOT_CONNECTED;
+    }
+
+    /* Keep the connection from being deleted meanwhile. */
+    if (CY_RSLT_SUCCESS != cy_rtos_get_mutex(&stream_mutex, MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS))
+    {
+        return MQTT_TRANSPORT_RSLT_TIMEOUT;
+    }
+
+    cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+    connection = mqtt_transport_find_connected(mqtt_handle);
+    cy_rtos_set_mutex(&connections_mutex);
+
+    if (NULL == connection)
+    {
+        cy_rtos_set_mutex(&stream_mutex);
+        return MQTT_TRANSPORT_RSLT_NOT_CONNECTED;
+    }
+
+    /* Whatever the header says is the length of the packet, and that many
+     * bytes go out before any other writer gets the connection.
+     */
+    result = mqtt_transport_send_all(connection, header, header_length);
+
+    while ((CY_RSLT_SUCCESS == result) && (payload_length > 0))
+    {
+        chunk = NULL;
+        chunk_length = pull(arg, &chunk);
+        if ((0 == chunk_length) || (NULL == chunk))
+        {
+            break;
+        }
+        if (chunk_length > payload_length)
+        {
+            chunk_length = payload_length;
+        }
+
+        result = mqtt_transport_send_all(connection, chunk, chunk_length);
+        payload_length -= chunk_length;
+    }
+
+    if ((CY_RSLT_SUCCESS == result) && (payload_length > 0))
+    {
+        /* The producer ran dry. The broker still expects the promised
+         * length, so pad it out to keep the connection in step and report
+         * the error.
+         */
+        while ((CY_RSLT_SUCCESS == result) && (payload_length > 0))
+        {
+            chunk_length = (payload_length < sizeof(padding)) ? payload_length : sizeof(padding);
+            result = mqtt_transport_send_all(connection, padding, chunk_length);
+            payload_length -= chunk_length;
+        }
+        result = MQTT_TRANSPORT_RSLT_ERROR;
+    }
+
+    if (CY_RSLT_SUCCESS != result)
+    {
+        /* The packet is given up part-way, so the connection is out of step
+         * with the broker. Drop it rather than hold off the other writers
+         * until the connection is closed.
+         */
+        cy_rtos_get_thread_handle(&self);
+        mqtt_transport_drop_packet(connection, self);
+    }
+
+    cy_rtos_set_mutex(&stream_mutex);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_transport_get_activity
+ ******************************************************************************
+ * Summary:
+ *  Reports when data was last sent and last received on the connection of
+ *  'mqtt_handle', as cy_rtos_get_time() values. Any packet in either
+ *  direction shows the path through the network is still open.
+ *
+ * Parameters:
+ *  cy_mqtt_t mqtt_handle : MQTT handle whose connection to report on
+ *  uint32_t *last_sent : Receives the time of the last successful send
+ *  uint32_t *last_received : Receives the time of the last successful receive
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS, or MQTT_TRANSPORT_RSLT_NOT_CONNECTED if there
+ *              is no such connection.
+ *
+ ******************************************************************************/
+cy_rslt_t mqtt_transport_get_activity(cy_mqtt_t mqtt_handle, uint32_t *last_sent, uint32_t *last_received)
+{
+    mqtt_transport_connection_t *connection;
+    cy_rslt_t result = MQTT_TRANSPORT_RSLT_NOT_CONNECTED;
+
+    if ((NULL == last_sent) || (NULL == last_received))
+    {
+        return MQTT_TRANSPORT_RSLT_ERROR;
+    }
+
+    if (!transport_initialized)
+    {
+        return result;
+    }
+
+    cy_rtos_get_mutex(&connections_mutex, CY_RTOS_NEVER_TIMEOUT);
+    connection = mqtt_transport_find_connected(mqtt_handle);
+    if (NULL != connection)
+    {
+        *last_sent = connection->last_sent_time;
+        *last_received = connection->last_received_time;
+        result = CY_RSLT_SUCCESS;
+    }
+    cy_rtos_set_mutex(&connections_mutex);
+
+    return result;
+}
+
+#else /* MQTT_TRANSPORT_WRAP */
+
+/* Without the linker wrapping the MQTT library writes straight to its port,
+ * unseen by this module, so packets cannot be kept in one piece.
+ */
+cy_rslt_t mqtt_transport_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+void mqtt_transport_deinit(void)
+{
+}
+
+void mqtt_transport_set_packet_hook(mqtt_transport_packet_hook_t hook)
+{
+    (void) hook;
+}
+
+cy_rslt_t mqtt_transport_send_stream(cy_mqtt_t mqtt_handle, const void *header, uint32_t header_length,
+                                     uint32_t payload_length, mqtt_transport_pull_t pull, void *arg)
+{
+    (void) mqtt_handle;
+    (void) header;
+    (void) header_length;
+    (void) payload_length;
+    (void) pull;
+    (void) arg;
+
+    return MQTT_TRANSPORT_RSLT_UNSUPPORTED;
+}
+
+cy_rslt_t mqtt_transport_get_activity(cy_mqtt_t mqtt_handle, uint32_t *last_sent, uint32_t *last_received)
+{
+    (void) mqtt_handle;
+    (void) last_sent;
+    (void) last_received;
+
+    return MQTT_TRANSPORT_RSLT_UNSUPPORTED;
+}
+
+#endif /* MQTT_TRANSPORT_WRAP */
+
+/* [] END OF FILE */
@@ -0,0 +1,113 @@
+/******************************************************************************
+* File Name:   mqtt_transport.h
+*
+* Description: This file contains the declarations of the MQTT transport,
+*              which sits between the MQTT library and its secure sockets
+*              port. It keeps the pieces of an MQTT packet together on the
+*              way to the TLS layer and streams payloads too large to buffer.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef MQTT_TRANSPORT_H_
+#define MQTT_TRANSPORT_H_
+
+#include <stdint.h>
+#include "cy_result.h"
+#include "cy_mqtt_api.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Size in bytes of the per-connection buffer in which the separate writes the
+ * MQTT library issues for one packet are collected, so that the TLS layer
+ * encrypts them as a single record. Packets larger than this are written
+ * through. Set to 0 to write every piece as it comes, e.g. to compare the
+ * records per publish with and without combining.
+ */
+#ifndef MQTT_TRANSPORT_COMBINE_BUFFER_SIZE
+#define MQTT_TRANSPORT_COMBINE_BUFFER_SIZE  (512u)
+#endif
+
+/* Number of MQTT connections tracked at a time. Further connections work,
+ * but without combining, streaming or activity times. Each tracked
+ * connection is addressed by the cy_mqtt_t handle it was created for.
+ */
+#ifndef MQTT_TRANSPORT_MAX_CONNECTIONS
+#define MQTT_TRANSPORT_MAX_CONNECTIONS      (1u)
+#endif
+
+/* Longest time in milliseconds a writer waits for the packet of another task
+ * to complete before its write returns with nothing sent.
+ */
+#ifndef MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS
+#define MQTT_TRANSPORT_PACKET_LOCK_TIMEOUT_MS   (5000u)
+#endif
+
+/* Results of the MQTT transport API. */
+#define MQTT_TRANSPORT_RSLT_NOT_CONNECTED   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x110)
+#define MQTT_TRANSPORT_RSLT_TIMEOUT         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x111)
+#define MQTT_TRANSPORT_RSLT_ERROR           CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x112)
+#define MQTT_TRANSPORT_RSLT_UNSUPPORTED     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MIDDLEWARE_BASE, 0x113)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Supplies the next part of a streamed payload. Sets '*chunk' to the data and
+ * returns its length, or returns 0 if there is no more data. The data must
+ * stay valid until the next call.
+ */
+typedef uint32_t (*mqtt_transport_pull_t)(void *arg, const void **chunk);
+
+/* Called in the writing task once the last byte of an MQTT packet has been
+ * written, with the first byte of its fixed header. The connection is held
+ * during the call, so it must return quickly.
+ */
+typedef void (*mqtt_transport_packet_hook_t)(uint8_t header);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t mqtt_transport_init(void);
+void mqtt_transport_deinit(void);
+void mqtt_transport_set_packet_hook(mqtt_transport_packet_hook_t hook);
+cy_rslt_t mqtt_transport_send_stream(cy_mqtt_t mqtt_handle, const void *header, uint32_t header_length,
+                                     uint32_t payload_length, mqtt_transport_pull_t pull, void *arg);
+cy_rslt_t mqtt_transport_get_activity(cy_mqtt_t mqtt_handle, uint32_t *last_sent, uint32_t *last_received);
+
+#endif /* MQTT_TRANSPORT_H_ */
+
+/* [] END OF FILE */
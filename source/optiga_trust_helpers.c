@@ -42,6 +42,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
 #include "include/optiga_util.h"
 #include "include/common/optiga_lib_logger.h"
 #include "include/pal/pal_os_event.h"
@@ -51,6 +53,45 @@
 #include "mbedtls/base64.h"
 #include "optiga_trust_helpers.h"
 
+/* A certificate may be prefixed with a TLS identity header, tag 0xC0 */
+#define OPTIGA_TLS_IDENTITY_TAG         (0xC0)
+#define OPTIGA_TLS_IDENTITY_HEADER_LEN  (9)
+
+#define PEM_BEGIN_CERTIFICATE           "-----BEGIN CERTIFICATE-----\n"
+#define PEM_END_CERTIFICATE             "-----END CERTIFICATE-----\n"
+
+/* PEM lines are 64 characters, i.e. 48 bytes of DER */
+#define PEM_LINE_LENGTH                 (64)
+#define PEM_DER_BYTES_PER_LINE          (PEM_LINE_LENGTH / 4 * 3)
+
+#define DER_TAG_SEQUENCE                (0x30)
+
+/* Certificates are read from the data object in chunks of this size, so RAM
+ * use does not depend on the certificate size. A multiple of
+ * PEM_DER_BYTES_PER_LINE, so every chunk but the last gives whole PEM lines.
+ */
+#define OPTIGA_READ_CHUNK_SIZE          (PEM_DER_BYTES_PER_LINE * 3)
+
+/* Called for every certificate found in a data object */
+typedef optiga_lib_status_t (*certificate_handler_t)(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                                     uint16_t length, void * context);
+
+/* Destination of PEM output, the console if 'buffer' is NULL */
+typedef struct
+{
+    char *  buffer;
+    size_t  size;
+    size_t  used;
+} pem_output_t;
+
+/* Destination of a DER certificate */
+typedef struct
+{
+    uint8_t *   buffer;
+    uint16_t    size;
+    uint16_t    length;
+} der_output_t;
+
 /**
  * Callback when optiga_util_xxxx operation is completed asynchronously
  */
@@ -60,168 +101,331 @@ static void optiga_util_callback(void * context, optiga_lib_status_t return_stat
     optiga_lib_status = return_status;
 }
 
-void read_certificate_from_optiga(uint16_t optiga_oid, char * cert_pem, uint16_t * cert_pem_length)
+/**
+ * Reads 'length' bytes at 'offset' of a data object. On return 'length' holds
+ * the number of bytes read, which is less at the end of the object.
+ */
+static optiga_lib_status_t read_data_at(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                        uint8_t * buffer, uint16_t * length)
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1200];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
     optiga_lib_status_t return_status;
 
-    optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1024];
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
-    
-    do
+    optiga_lib_status = OPTIGA_LIB_BUSY;
+    return_status = optiga_util_read_data(me_util, oid, offset, buffer, length);
+    if (OPTIGA_LIB_SUCCESS != return_status)
     {
-        //Create an instance of optiga_util to read the certificate from OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
-        if(!me_util)
+        return return_status;
+    }
+
+    while (optiga_lib_status == OPTIGA_LIB_BUSY)
+    {
+        pal_os_timer_delay_in_milliseconds(1);
+    }
+
+    return optiga_lib_status;
+}
+
+/**
+ * Returns the length, header included, of the DER SEQUENCE starting at 'der',
+ * or 0 if 'der' does not start with a SEQUENCE of a supported length.
+ */
+static uint32_t der_sequence_length(const uint8_t * der, uint16_t available)
+{
+    if ((available < 2) || (der[0] != DER_TAG_SEQUENCE))
+    {
+        return 0;
+    }
+    if (der[1] < 0x80)
+    {
+        return 2 + der[1];
+    }
+    if ((der[1] == 0x81) && (available >= 3))
+    {
+        return 3 + der[2];
+    }
+    if ((der[1] == 0x82) && (available >= 4))
+    {
+        return 4 + (((uint32_t)der[2] << 8) | der[3]);
+    }
+    return 0;
+}
+
+/**
+ * Walks the certificates in a data object without buffering it. The object
+ * holds either one or more concatenated DER certificates or a TLS identity
+ * (tag 0xC0), i.e. a TLS certificate_list. Only the few header bytes in front
+ * of each certificate are read here; 'handler' gets the offset and length of
+ * each certificate and reads what it needs. Stops after 'max_certificates'.
+ */
+static optiga_lib_status_t for_each_certificate(optiga_util_t * me_util, uint16_t oid, uint16_t max_certificates,
+                                                certificate_handler_t handler, void * context)
+{
+    uint8_t header[OPTIGA_TLS_IDENTITY_HEADER_LEN];
+    uint16_t header_length = sizeof(header);
+    uint32_t offset = 0;
+    uint32_t end = UINT16_MAX;
+    uint32_t cert_length;
+    uint16_t found = 0;
+    bool tls_identity = false;
+    optiga_lib_status_t return_status;
+
+    return_status = read_data_at(me_util, oid, 0, header, &header_length);
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return return_status;
+    }
+
+    if ((header_length == OPTIGA_TLS_IDENTITY_HEADER_LEN) && (header[0] == OPTIGA_TLS_IDENTITY_TAG))
+    {
+        // Tag, 2 byte length, 3 byte certificate_list length, then every
+        // certificate preceded by its 3 byte length
+        tls_identity = true;
+        end = 3 + (((uint32_t)header[1] << 8) | header[2]);
+        offset = 6;
+    }
+
+    while ((offset < end) && (found < max_certificates))
+    {
+        header_length = tls_identity ? 3 : 4;
+        if (OPTIGA_LIB_SUCCESS != read_data_at(me_util, oid, (uint16_t)offset, header, &header_length))
         {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            // Read past the used size: no more certificates
             break;
         }
-        optiga_lib_status = OPTIGA_LIB_BUSY;
-        return_status = optiga_util_read_data(me_util, optiga_oid, 0, ifx_cert_hex, &ifx_cert_hex_len);
-        if (OPTIGA_LIB_SUCCESS != return_status)
+
+        if (tls_identity)
         {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            if (header_length < 3)
+            {
+                break;
+            }
+            cert_length = ((uint32_t)header[0] << 16) | ((uint32_t)header[1] << 8) | header[2];
+            offset += 3;
         }
-            
-        while (optiga_lib_status == OPTIGA_LIB_BUSY);
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+        else
+        {
+            // Anything but a SEQUENCE is padding behind the last certificate
+            cert_length = der_sequence_length(header, header_length);
+        }
+
+        if ((cert_length == 0) || ((offset + cert_length) > UINT16_MAX))
         {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
-        
-        //convert to PEM format
-        // If the first byte is TLS Identity Tag, than we need to skip 9 first bytes
-        offset_to_read = ifx_cert_hex[0] == 0xc0? 9: 0;
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-                              ifx_cert_hex + offset_to_read, ifx_cert_hex_len - offset_to_read);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-       
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
+
+        return_status = handler(me_util, oid, (uint16_t)offset, (uint16_t)cert_length, context);
+        if (OPTIGA_LIB_SUCCESS != return_status)
         {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
+            return return_status;
         }
 
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
+        found++;
+        offset += cert_length;
+    }
 
-        *cert_pem_length = offset_to_write + 27;
-   
-    } while(0);
+    return (found > 0) ? OPTIGA_LIB_SUCCESS : OPTIGA_UTIL_ERROR;
+}
 
-    //me_util instance to be destroyed 
-    if (me_util)
+/**
+ * Appends text to a PEM output: the caller's buffer, kept NUL terminated, or
+ * the console if there is no buffer.
+ */
+static bool pem_write(pem_output_t * pem, const char * text, size_t length)
+{
+    if (pem->buffer == NULL)
     {
-        optiga_util_destroy(me_util);
+        printf("%.*s", (int)length, text);
+        return true;
     }
+
+    if ((pem->used + length + 1) > pem->size)
+    {
+        return false;
+    }
+
+    memcpy(pem->buffer + pem->used, text, length);
+    pem->used += length;
+    pem->buffer[pem->used] = '\0';
+    return true;
 }
 
-void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+/**
+ * Base64 encodes DER into 64 column PEM lines. 'length' must be a multiple of
+ * PEM_DER_BYTES_PER_LINE except for the last piece of a certificate.
+ */
+static bool pem_write_lines(pem_output_t * pem, const uint8_t * der, uint16_t length)
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1200];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
-    optiga_lib_status_t return_status;
-
-    optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1300];
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
+    unsigned char line[PEM_LINE_LENGTH + 1];
+    size_t written = 0;
+    uint16_t offset_to_read;
+    uint16_t size_to_encode;
 
-    do
+    for (offset_to_read = 0; offset_to_read < length; offset_to_read += size_to_encode)
     {
-        //Create an instance of optiga_util to read the certificate from OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
-        if(!me_util)
+        size_to_encode = length - offset_to_read;
+        if (size_to_encode > PEM_DER_BYTES_PER_LINE)
         {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            size_to_encode = PEM_DER_BYTES_PER_LINE;
         }
-        optiga_lib_status = OPTIGA_LIB_BUSY;   
-        return_status = optiga_util_read_data(me_util, oid, 0, ifx_cert_hex, &ifx_cert_hex_len);
-        if (OPTIGA_LIB_SUCCESS != return_status)
+
+        mbedtls_base64_encode(line, sizeof(line), &written, der + offset_to_read, size_to_encode);
+        line[written++] = '\n';
+        if (!pem_write(pem, (const char *)line, written))
         {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api for trust anchor returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            return false;
         }
-            
-        while (optiga_lib_status == OPTIGA_LIB_BUSY)
+    }
+    return true;
+}
+
+/**
+ * certificate_handler_t: streams a certificate out as PEM, reading it from the
+ * data object in chunks of OPTIGA_READ_CHUNK_SIZE.
+ */
+static optiga_lib_status_t stream_certificate_pem(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                                  uint16_t length, void * context)
+{
+    pem_output_t * pem = (pem_output_t *)context;
+    uint8_t chunk[OPTIGA_READ_CHUNK_SIZE];
+    uint16_t chunk_length;
+    uint16_t done;
+    optiga_lib_status_t return_status;
+
+    if (!pem_write(pem, PEM_BEGIN_CERTIFICATE, sizeof(PEM_BEGIN_CERTIFICATE) - 1))
+    {
+        return OPTIGA_UTIL_ERROR;
+    }
+
+    for (done = 0; done < length; done += chunk_length)
+    {
+        chunk_length = length - done;
+        if (chunk_length > sizeof(chunk))
         {
-            pal_os_timer_delay_in_milliseconds(30);
+            chunk_length = sizeof(chunk);
         }
-        
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+
+        return_status = read_data_at(me_util, oid, offset + done, chunk, &chunk_length);
+        if ((OPTIGA_LIB_SUCCESS != return_status) || (chunk_length == 0))
         {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed for reading trust anchor",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            return OPTIGA_UTIL_ERROR;
         }
 
-        //ESP_LOG_BUFFER_HEX("OPTIGA Certificate", ifx_cert_hex, ifx_cert_hex_len);
-        
-        //convert to PEM format
-       // printf("read ifx cer\r\n");
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-        //in case of TLS chain format of ceritificate
-        //                    ifx_cert_hex + 9, ifx_cert_hex_len - 9);
-                              ifx_cert_hex, ifx_cert_hex_len);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-        
-        //TBD: Verify the given cert_pem length against the ifx_cert_b64_len after conversion
-        
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
+        if (!pem_write_lines(pem, chunk, chunk_length))
         {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
+            return OPTIGA_UTIL_ERROR;
         }
+    }
 
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
+    if (!pem_write(pem, PEM_END_CERTIFICATE, sizeof(PEM_END_CERTIFICATE) - 1))
+    {
+        return OPTIGA_UTIL_ERROR;
+    }
+    return OPTIGA_LIB_SUCCESS;
+}
 
-        *cert_pem_length = offset_to_write + 27;
-       /* for(int i=0; i<1200; i++)
-        {
-            printf("%c", cert_pem[i]);
-        }*/       
-    } while(0);
+/**
+ * certificate_handler_t: copies a certificate into the caller's buffer.
+ */
+static optiga_lib_status_t copy_certificate(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                            uint16_t length, void * context)
+{
+    der_output_t * der = (der_output_t *)context;
 
-    //me_util instance to be destroyed 
-    if (me_util)
+    if (length > der->size)
     {
-        optiga_util_destroy(me_util);
+        optiga_lib_print_message("certificate does not fit the buffer",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return OPTIGA_UTIL_ERROR;
     }
+
+    der->length = length;
+    return read_data_at(me_util, oid, offset, der->buffer, &der->length);
+}
+
+/**
+ * Runs for_each_certificate() on a fresh optiga_util instance.
+ */
+static optiga_lib_status_t walk_certificates(uint16_t oid, uint16_t max_certificates,
+                                             certificate_handler_t handler, void * context)
+{
+    optiga_lib_status_t return_status = OPTIGA_UTIL_ERROR;
+    optiga_util_t * me_util = NULL;
+
+    //Create an instance of optiga_util to read the certificate from OPTIGA.
+    me_util = optiga_util_create(0, optiga_util_callback, NULL);
+    if(!me_util)
+    {
+        optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return return_status;
+    }
+
+    return_status = for_each_certificate(me_util, oid, max_certificates, handler, context);
+
+    //me_util instance to be destroyed
+    optiga_util_destroy(me_util);
+
+    return return_status;
+}
+
+optiga_lib_status_t read_certificate_der_from_optiga(uint16_t optiga_oid, uint8_t * cert_der, uint16_t * cert_der_length)
+{
+    der_output_t der = { cert_der, *cert_der_length, 0 };
+    optiga_lib_status_t return_status;
+
+    return_status = walk_certificates(optiga_oid, 1, copy_certificate, &der);
+    *cert_der_length = (OPTIGA_LIB_SUCCESS == return_status) ? der.length : 0;
+
+    return return_status;
+}
+
+int cert_der_to_pem(const uint8_t * cert_der, uint16_t cert_der_length, char * cert_pem, uint16_t * cert_pem_length)
+{
+    pem_output_t pem = { cert_pem, *cert_pem_length, 0 };
+
+    if (!pem_write(&pem, PEM_BEGIN_CERTIFICATE, sizeof(PEM_BEGIN_CERTIFICATE) - 1) ||
+        !pem_write_lines(&pem, cert_der, cert_der_length) ||
+        !pem_write(&pem, PEM_END_CERTIFICATE, sizeof(PEM_END_CERTIFICATE) - 1))
+    {
+        return -1;
+    }
+
+    *cert_pem_length = pem.used + 1;
+    return 0;
+}
+
+void print_certificate_pem(const uint8_t * cert_der, uint16_t cert_der_length)
+{
+    pem_output_t pem = { NULL, 0, 0 };
+
+    pem_write(&pem, PEM_BEGIN_CERTIFICATE, sizeof(PEM_BEGIN_CERTIFICATE) - 1);
+    pem_write_lines(&pem, cert_der, cert_der_length);
+    pem_write(&pem, PEM_END_CERTIFICATE, sizeof(PEM_END_CERTIFICATE) - 1);
+}
+
+void print_certificate_from_optiga(uint16_t optiga_oid)
+{
+    pem_output_t pem = { NULL, 0, 0 };
+
+    walk_certificates(optiga_oid, UINT16_MAX, stream_certificate_pem, &pem);
+}
+
+void read_certificate_from_optiga(uint16_t optiga_oid, char * cert_pem, uint16_t * cert_pem_length)
+{
+    pem_output_t pem = { cert_pem, *cert_pem_length, 0 };
+
+    if (OPTIGA_LIB_SUCCESS != walk_certificates(optiga_oid, UINT16_MAX, stream_certificate_pem, &pem))
+    {
+        *cert_pem_length = 0;
+        return;
+    }
+
+    *cert_pem_length = pem.used + 1;
+}
+
+void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+{
+    read_certificate_from_optiga(oid, cert_pem, cert_pem_length);
 }
 
 void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
@@ -42,7 +42,29 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include "include/optiga_util.h"
 
+/* A data object may hold one or more concatenated DER certificates or a TLS
+ * identity (tag 0xC0) with a certificate chain. The functions below read it
+ * in place, in chunks, so their RAM use does not grow with the chain. */
+
+/* Reads the first DER certificate stored in 'optiga_oid'. On entry
+ * 'cert_der_length' is the size of 'cert_der', on return the length of the
+ * certificate. */
+optiga_lib_status_t read_certificate_der_from_optiga(uint16_t optiga_oid, uint8_t * cert_der, uint16_t * cert_der_length);
+
+/* PEM encodes a DER certificate for display. On entry 'cert_pem_length' is the
+ * size of 'cert_pem'. Returns 0 on success, -1 if the buffer is too small. */
+int cert_der_to_pem(const uint8_t * cert_der, uint16_t cert_der_length, char * cert_pem, uint16_t * cert_pem_length);
+
+/* Prints a DER certificate as PEM, one line at a time. */
+void print_certificate_pem(const uint8_t * cert_der, uint16_t cert_der_length);
+
+/* Prints the certificates in 'optiga_oid' as PEM, streamed chunk by chunk. */
+void print_certificate_from_optiga(uint16_t optiga_oid);
+
+/* Read the certificates in an object as PEM. On entry 'cert_pem_length' is the
+ * size of 'cert_pem'; it is set to 0 on failure. */
 void read_certificate_from_optiga(uint16_t optiga_oid, char * cert_pem, uint16_t * cert_pem_length);
 
 void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length);
@@ -0,0 +1,430 @@
+/******************************************************************************
+* File Name:   pkcs11_benchmark.c
+*
+* Description: This file contains the PKCS#11 self check and microbenchmark.
+*              It runs the find, attribute, sign and random flows that TLS
+*              uses, checks the results against the Cryptoki rules and prints
+*              calls per second and I2C transfers per call as JSON lines.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+
+/* Configuration file for MQTT client */
+#include "mqtt_client_config.h"
+
+#include "core_pkcs11_config.h"
+#include "core_pkcs11.h"
+#include "pkcs11_optiga_trustm.h"
+#include "pal_psoc_i2c_mapping.h"
+#include "latency_histogram.h"
+#include "pkcs11_benchmark.h"
+
+#if ENABLE_PKCS11_BENCHMARK
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Length of the digest that is signed, a SHA-256 hash. */
+#define PKCS11_BENCHMARK_DIGEST_LENGTH          (32u)
+
+/******************************************************************************
+* Data structure and enumeration
+******************************************************************************/
+/* Timed entry points, in the order they are run. */
+typedef enum
+{
+    PKCS11_OP_INITIALIZE,
+    PKCS11_OP_FIND_OBJECT,
+    PKCS11_OP_ATTRIBUTE_SIZE,
+    PKCS11_OP_ATTRIBUTE_DATA,
+    PKCS11_OP_SIGN,
+    PKCS11_OP_GENERATE_RANDOM,
+    PKCS11_OP_COUNT
+} pkcs11_op_t;
+
+typedef struct
+{
+    uint32_t calls;
+    uint32_t failures;
+    uint64_t ticks;
+    uint32_t i2c_transfers;
+} pkcs11_op_stats_t;
+
+/* Counters at the start of a call. */
+typedef struct
+{
+    uint32_t        start;
+    pal_i2c_stats_t i2c;
+} pkcs11_sample_t;
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+static const char *const pkcs11_op_names[PKCS11_OP_COUNT] =
+{
+    "C_Initialize", "find_object", "C_GetAttributeValue_size",
+    "C_GetAttributeValue_data", "C_Sign", "C_GenerateRandom"
+};
+
+static pkcs11_op_stats_t pkcs11_ops[PKCS11_OP_COUNT];
+static uint32_t pkcs11_checks_failed;
+
+/* Receives the device certificate and the signatures. */
+static uint8_t pkcs11_buffer[PKCS11_BENCHMARK_BUFFER_SIZE];
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void pkcs11_op_begin(pkcs11_sample_t *sample);
+static void pkcs11_op_end(pkcs11_op_t op, const pkcs11_sample_t *sample, CK_RV rv);
+static void pkcs11_check(const char *name, bool pass);
+static void pkcs11_print_ops(void);
+
+/******************************************************************************
+ * Function Name: pkcs11_op_begin
+ ******************************************************************************
+ * Summary:
+ *  Takes the counters before a timed call.
+ *
+ * Parameters:
+ *  pkcs11_sample_t *sample : Receives the counters
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void pkcs11_op_begin(pkcs11_sample_t *sample)
+{
+    pal_i2c_get_stats(&sample->i2c);
+    sample->start = latency_now();
+}
+
+/******************************************************************************
+ * Function Name: pkcs11_op_end
+ ******************************************************************************
+ * Summary:
+ *  Adds the time and the I2C transfers of a call to the stats of 'op'.
+ *
+ * Parameters:
+ *  pkcs11_op_t op : Entry point that was called
+ *  const pkcs11_sample_t *sample : Counters before the call
+ *  CK_RV rv : Result of the call
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void pkcs11_op_end(pkcs11_op_t op, const pkcs11_sample_t *sample, CK_RV rv)
+{
+    uint32_t end = latency_now();
+    pal_i2c_stats_t i2c;
+
+    pal_i2c_get_stats(&i2c);
+
+    pkcs11_ops[op].calls++;
+    pkcs11_ops[op].ticks += end - sample->start;
+    pkcs11_ops[op].i2c_transfers += (i2c.writes - sample->i2c.writes) + (i2c.reads - sample->i2c.reads);
+    if (CKR_OK != rv)
+    {
+        pkcs11_ops[op].failures++;
+    }
+}
+
+/******************************************************************************
+ * Function Name: pkcs11_check
+ ******************************************************************************
+ * Summary:
+ *  Prints the outcome of one conformance check as a JSON line.
+ *
+ * Parameters:
+ *  const char *name : What was checked
+ *  bool pass : Whether the module behaved as Cryptoki requires
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void pkcs11_check(const char *name, bool pass)
+{
+    if (!pass)
+    {
+        pkcs11_checks_failed++;
+    }
+
+    printf("{\"check\":\"pkcs11\",\"name\":\"%s\",\"pass\":%s}\n", name, pass ? "true" : "false");
+}
+
+/******************************************************************************
+ * Function Name: pkcs11_print_ops
+ ******************************************************************************
+ * Summary:
+ *  Prints the calls per second and the I2C transfers per call of every
+ *  timed entry point as JSON lines.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void pkcs11_print_ops(void)
+{
+    for (uint32_t op = 0; op < PKCS11_OP_COUNT; op++)
+    {
+        const pkcs11_op_stats_t *stats = &pkcs11_ops[op];
+        uint32_t us_per_call = 0;
+        uint32_t calls_per_s_x100 = 0;
+
+        if (0u != stats->calls)
+        {
+            us_per_call = (uint32_t) (latency_ticks_to_us(stats->ticks) / stats->calls);
+            calls_per_s_x100 = (0u == us_per_call) ? 0u : (100000000u / us_per_call);
+        }
+
+        printf("{\"benchmark\":\"pkcs11\",\"op\":\"%s\",\"calls\":%lu,\"failures\":%lu,"
+               "\"us_per_call\":%lu,\"calls_per_s\":%lu.%02lu,\"i2c_per_call\":%lu}\n",
+               pkcs11_op_names[op], (unsigned long) stats->calls, (unsigned long) stats->failures,
+               (unsigned long) us_per_call,
+               (unsigned long) (calls_per_s_x100 / 100u), (unsigned long) (calls_per_s_x100 % 100u),
+               (unsigned long) ((0u == stats->calls) ? 0u : (stats->i2c_transfers / stats->calls)));
+    }
+}
+
+/******************************************************************************
+ * Function Name: pkcs11_benchmark_run
+ ******************************************************************************
+ * Summary:
+ *  Runs the PKCS#11 flows of the TLS client against the module and the
+ *  secure element: initialization, the object lookup by label, the size and
+ *  data queries of the device certificate, the signature with the device key
+ *  and random generation. Each is checked against the Cryptoki rules once
+ *  and then timed PKCS11_BENCHMARK_ITERATIONS times. C_Initialize is only
+ *  timed once, as the module must stay initialized for TLS.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if every check passed
+ *
+ ******************************************************************************/
+cy_rslt_t pkcs11_benchmark_run(void)
+{
+    CK_FUNCTION_LIST_PTR functions = NULL;
+    CK_SESSION_HANDLE session = CK_INVALID_HANDLE;
+    CK_OBJECT_HANDLE key = CK_INVALID_HANDLE;
+    CK_OBJECT_HANDLE cert = CK_INVALID_HANDLE;
+    CK_OBJECT_HANDLE missing = CK_INVALID_HANDLE;
+    CK_KEY_TYPE key_type = (CK_KEY_TYPE) ~0;
+    CK_MECHANISM mechanism = { 0 };
+    CK_ATTRIBUTE attribute;
+    CK_ULONG cert_length = 0;
+    CK_ULONG length;
+    CK_BYTE digest[PKCS11_BENCHMARK_DIGEST_LENGTH];
+    CK_BYTE random_a[PKCS11_BENCHMARK_DIGEST_LENGTH];
+    CK_BYTE random_b[PKCS11_BENCHMARK_DIGEST_LENGTH];
+    bool random_varies = false;
+    pkcs11_sample_t sample;
+    CK_RV rv;
+    uint32_t i;
+
+    memset(random_a, 0, sizeof(random_a));
+    memset(pkcs11_ops, 0, sizeof(pkcs11_ops));
+    pkcs11_checks_failed = 0;
+
+    printf("Running the PKCS#11 checks and benchmark...\n\n");
+
+    rv = C_GetFunctionList(&functions);
+    pkcs11_check("C_GetFunctionList", (CKR_OK == rv) && (NULL != functions));
+    if (NULL == functions)
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    /* Initialization */
+    pkcs11_op_begin(&sample);
+    rv = functions->C_Initialize(NULL);
+    pkcs11_op_end(PKCS11_OP_INITIALIZE, &sample,
+                  (CKR_CRYPTOKI_ALREADY_INITIALIZED == rv) ? CKR_OK : rv);
+    pkcs11_check("C_Initialize", (CKR_OK == rv) || (CKR_CRYPTOKI_ALREADY_INITIALIZED == rv));
+    pkcs11_check("C_Initialize again is refused",
+                 CKR_CRYPTOKI_ALREADY_INITIALIZED == functions->C_Initialize(NULL));
+
+    rv = xInitializePkcs11Session(&session);
+    pkcs11_check("open session", (CKR_OK == rv) && (CK_INVALID_HANDLE != session));
+    if (CK_INVALID_HANDLE == session)
+    {
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    rv = functions->C_Login(session, CKU_USER, (CK_UTF8CHAR_PTR) configPKCS11_DEFAULT_USER_PIN,
+                            sizeof(configPKCS11_DEFAULT_USER_PIN) - 1);
+    pkcs11_check("C_Login", (CKR_OK == rv) || (CKR_USER_ALREADY_LOGGED_IN == rv));
+
+    /* Object lookup by label */
+    for (i = 0; i < PKCS11_BENCHMARK_ITERATIONS; i++)
+    {
+        pkcs11_op_begin(&sample);
+        rv = xFindObjectWithLabelAndClass(session, LABEL_DEVICE_PRIVATE_KEY_FOR_TLS,
+                                          sizeof(LABEL_DEVICE_PRIVATE_KEY_FOR_TLS) - 1,
+                                          CKO_PRIVATE_KEY, &key);
+        pkcs11_op_end(PKCS11_OP_FIND_OBJECT, &sample,
+                      (CK_INVALID_HANDLE == key) ? CKR_OBJECT_HANDLE_INVALID : rv);
+    }
+    pkcs11_check("find device key", CK_INVALID_HANDLE != key);
+
+    rv = xFindObjectWithLabelAndClass(session, LABEL_DEVICE_CERTIFICATE_FOR_TLS,
+                                      sizeof(LABEL_DEVICE_CERTIFICATE_FOR_TLS) - 1,
+                                      CKO_CERTIFICATE, &cert);
+    pkcs11_check("find device certificate", (CKR_OK == rv) && (CK_INVALID_HANDLE != cert));
+
+    (void) xFindObjectWithLabelAndClass(session, "no such object", sizeof("no such object") - 1,
+                                        CKO_CERTIFICATE, &missing);
+    pkcs11_check("unknown label is not found", CK_INVALID_HANDLE == missing);
+
+    /* Certificate size and data queries */
+    for (i = 0; i < PKCS11_BENCHMARK_ITERATIONS; i++)
+    {
+        attribute.type = CKA_VALUE;
+        attribute.pValue = NULL;
+        attribute.ulValueLen = 0;
+
+        pkcs11_op_begin(&sample);
+        rv = functions->C_GetAttributeValue(session, cert, &attribute, 1);
+        pkcs11_op_end(PKCS11_OP_ATTRIBUTE_SIZE, &sample, rv);
+        cert_length = attribute.ulValueLen;
+    }
+    pkcs11_check("certificate size query", (CKR_OK == rv) && (0u != cert_length) &&
+                                           (cert_length <= sizeof(pkcs11_buffer)));
+
+    if ((0u != cert_length) && (cert_length <= sizeof(pkcs11_buffer)))
+    {
+        for (i = 0; i < PKCS11_BENCHMARK_ITERATIONS; i++)
+        {
+            attribute.type = CKA_VALUE;
+            attribute.pValue = pkcs11_buffer;
+            attribute.ulValueLen = cert_length;
+
+            pkcs11_op_begin(&sample);
+            rv = functions->C_GetAttributeValue(session, cert, &attribute, 1);
+            pkcs11_op_end(PKCS11_OP_ATTRIBUTE_DATA, &sample, rv);
+        }
+        pkcs11_check("certificate data query", (CKR_OK == rv) && (cert_length == attribute.ulValueLen) &&
+                                               (0x30 == pkcs11_buffer[0]));
+
+        attribute.pValue = pkcs11_buffer;
+        attribute.ulValueLen = cert_length - 1u;
+        rv = functions->C_GetAttributeValue(session, cert, &attribute, 1);
+        pkcs11_check("short buffer is refused", CKR_BUFFER_TOO_SMALL == rv);
+    }
+
+    /* Signature with the device key */
+    attribute.type = CKA_KEY_TYPE;
+    attribute.pValue = &key_type;
+    attribute.ulValueLen = sizeof(key_type);
+    rv = functions->C_GetAttributeValue(session, key, &attribute, 1);
+    pkcs11_check("device key type", (CKR_OK == rv) && ((CKK_EC == key_type) || (CKK_RSA == key_type)));
+
+    for (i = 0; i < sizeof(digest); i++)
+    {
+        digest[i] = (CK_BYTE) i;
+    }
+    mechanism.mechanism = (CKK_RSA == key_type) ? CKM_RSA_PKCS : CKM_ECDSA;
+
+    length = 0;
+    rv = functions->C_SignInit(session, &mechanism, key);
+    if (CKR_OK == rv)
+    {
+        rv = functions->C_Sign(session, digest, sizeof(digest), NULL, &length);
+    }
+    pkcs11_check("signature length query", (CKR_OK == rv) && (0u != length) &&
+                                           (length <= sizeof(pkcs11_buffer)));
+    if (CKR_OK == rv)
+    {
+        length = sizeof(pkcs11_buffer);
+        rv = functions->C_Sign(session, digest, sizeof(digest), pkcs11_buffer, &length);
+    }
+    pkcs11_check("sign after length query", CKR_OK == rv);
+
+    for (i = 0; i < PKCS11_BENCHMARK_ITERATIONS; i++)
+    {
+        length = sizeof(pkcs11_buffer);
+
+        pkcs11_op_begin(&sample);
+        rv = functions->C_SignInit(session, &mechanism, key);
+        if (CKR_OK == rv)
+        {
+            rv = functions->C_Sign(session, digest, sizeof(digest), pkcs11_buffer, &length);
+        }
+        pkcs11_op_end(PKCS11_OP_SIGN, &sample, rv);
+    }
+
+    /* Random generation */
+    for (i = 0; i < PKCS11_BENCHMARK_ITERATIONS; i++)
+    {
+        memcpy(random_b, random_a, sizeof(random_a));
+
+        pkcs11_op_begin(&sample);
+        rv = functions->C_GenerateRandom(session, random_a, sizeof(random_a));
+        pkcs11_op_end(PKCS11_OP_GENERATE_RANDOM, &sample, rv);
+    }
+    /* The output must vary within a call and from one call to the next. */
+    for (i = 1; i < sizeof(random_a); i++)
+    {
+        random_varies = random_varies || (random_a[i] != random_a[0]);
+    }
+    pkcs11_check("C_GenerateRandom", (CKR_OK == rv) && random_varies &&
+                                     (0 != memcmp(random_a, random_b, sizeof(random_a))));
+
+    (void) functions->C_CloseSession(session);
+
+    pkcs11_print_ops();
+    printf("{\"check\":\"pkcs11_summary\",\"failed\":%lu}\n\n", (unsigned long) pkcs11_checks_failed);
+
+    return (0u == pkcs11_checks_failed) ? CY_RSLT_SUCCESS : ~CY_RSLT_SUCCESS;
+}
+
+#endif /* ENABLE_PKCS11_BENCHMARK */
+
+/* [] END OF FILE */
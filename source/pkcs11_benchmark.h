@@ -0,0 +1,70 @@
+/******************************************************************************
+* File Name:   pkcs11_benchmark.h
+*
+* Description: This file contains the declarations of the PKCS#11 self check
+*              and microbenchmark, which exercises the Cryptoki entry points
+*              of the OPTIGA(TM) Trust M module used by TLS.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef PKCS11_BENCHMARK_H_
+#define PKCS11_BENCHMARK_H_
+
+#include <stdint.h>
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of timed calls of each entry point. */
+#ifndef PKCS11_BENCHMARK_ITERATIONS
+#define PKCS11_BENCHMARK_ITERATIONS             (20u)
+#endif
+
+/* Size of the buffer the device certificate is read into. */
+#ifndef PKCS11_BENCHMARK_BUFFER_SIZE
+#define PKCS11_BENCHMARK_BUFFER_SIZE            (2048u)
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t pkcs11_benchmark_run(void);
+
+#endif /* PKCS11_BENCHMARK_H_ */
+
+/* [] END OF FILE */
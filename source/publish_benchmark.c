@@ -0,0 +1,406 @@
+/******************************************************************************
+* File Name:   publish_benchmark.c
+*
+* Description: This file contains the publish benchmark. Each configured run
+*              submits its messages through mqtt_publish_async_traced() on
+*              MQTT_BENCHMARK_TOPIC and prints one JSON line with the results.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Configuration file for MQTT client */
+#include "mqtt_client_config.h"
+
+#include "mqtt_publish_async.h"
+#include "mqtt_transport.h"
+#include "cy_tls_ext.h"
+#include "latency_histogram.h"
+#include "task_monitor.h"
+#include "heap_usage.h"
+#include "publish_benchmark.h"
+
+#if ENABLE_PUBLISH_BENCHMARK
+
+#if !ENABLE_LATENCY_HISTOGRAM
+#error "ENABLE_PUBLISH_BENCHMARK needs ENABLE_LATENCY_HISTOGRAM"
+#endif
+
+#if (PUBLISH_BENCHMARK_DRAIN_TIMEOUT_MS <= MQTT_PUBLISH_ASYNC_TIMEOUT_MS)
+#error "PUBLISH_BENCHMARK_DRAIN_TIMEOUT_MS must exceed MQTT_PUBLISH_ASYNC_TIMEOUT_MS"
+#endif
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+static const publish_benchmark_run_t benchmark_runs[] =
+{
+    PUBLISH_BENCHMARK_RUNS
+};
+
+/* Payload of every message; only the first payload_size bytes are sent. */
+static uint8_t benchmark_payload[PUBLISH_BENCHMARK_PAYLOAD_MAX];
+
+/* Completions of the current run, counted by the publish workers. */
+static uint32_t benchmark_completed;
+static uint32_t benchmark_failed;
+static uint32_t benchmark_expected;
+
+static TaskHandle_t benchmark_task_handle = NULL;
+
+/* Run time counters at one instant: all tasks and the idle task. */
+typedef struct
+{
+    uint32_t total;
+    uint32_t idle;
+} benchmark_cpu_snapshot_t;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void benchmark_task(void *pvParameters);
+static void benchmark_publish_complete(cy_rslt_t result, uint32_t attempts, void *arg);
+static void benchmark_run(uint32_t index, const publish_benchmark_run_t *run);
+static void benchmark_cpu_snapshot(benchmark_cpu_snapshot_t *snapshot);
+
+/******************************************************************************
+ * Function Name: publish_benchmark_start
+ ******************************************************************************
+ * Summary:
+ *  Starts the benchmark task, once per boot. mqtt_publish_async_init() must
+ *  have been called.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS, or an error if the task could not be created
+ *
+ ******************************************************************************/
+cy_rslt_t publish_benchmark_start(void)
+{
+    if (NULL != benchmark_task_handle)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (pdPASS != xTaskCreate(benchmark_task, "Benchmark task", PUBLISH_BENCHMARK_TASK_STACK_SIZE,
+                              NULL, PUBLISH_BENCHMARK_TASK_PRIORITY, &benchmark_task_handle))
+    {
+        benchmark_task_handle = NULL;
+        return ~CY_RSLT_SUCCESS;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: benchmark_task
+ ******************************************************************************
+ * Summary:
+ *  Performs every run in PUBLISH_BENCHMARK_RUNS once, then deletes itself.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void benchmark_task(void *pvParameters)
+{
+    /* To avoid compiler warnings */
+    (void) pvParameters;
+
+    for (uint32_t i = 0; i < sizeof(benchmark_payload); i++)
+    {
+        benchmark_payload[i] = (uint8_t) ('a' + (i % 26u));
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(PUBLISH_BENCHMARK_START_DELAY_MS));
+
+    for (uint32_t i = 0; i < (sizeof(benchmark_runs) / sizeof(benchmark_runs[0])); i++)
+    {
+        benchmark_run(i, &benchmark_runs[i]);
+    }
+
+    printf("Publish benchmark complete\n\n");
+    vTaskDelete(NULL);
+}
+
+/******************************************************************************
+ * Function Name: benchmark_publish_complete
+ ******************************************************************************
+ * Summary:
+ *  Completion callback of the benchmark publishes. Wakes the benchmark task
+ *  when the last message of the run has completed.
+ *
+ * Parameters:
+ *  cy_rslt_t result : Result of the publish
+ *  uint32_t attempts : Number of PUBLISH attempts (unused)
+ *  void *arg : Unused
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void benchmark_publish_complete(cy_rslt_t result, uint32_t attempts, void *arg)
+{
+    uint32_t done;
+
+    (void) attempts;
+    (void) arg;
+
+    if (CY_RSLT_SUCCESS == result)
+    {
+        __atomic_fetch_add(&benchmark_completed, 1u, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_fetch_add(&benchmark_failed, 1u, __ATOMIC_RELAXED);
+    }
+
+    done = __atomic_load_n(&benchmark_completed, __ATOMIC_RELAXED) +
+           __atomic_load_n(&benchmark_failed, __ATOMIC_RELAXED);
+    if (done == __atomic_load_n(&benchmark_expected, __ATOMIC_RELAXED))
+    {
+        xTaskNotifyGive(benchmark_task_handle);
+    }
+}
+
+/******************************************************************************
+ * Function Name: benchmark_cpu_snapshot
+ ******************************************************************************
+ * Summary:
+ *  Reads the run time counters of the scheduler. Two snapshots give the CPU
+ *  use in between, independent of the task monitor window.
+ *
+ * Parameters:
+ *  benchmark_cpu_snapshot_t *snapshot : Receives the counters, all zero if
+ *                                       they could not be read
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void benchmark_cpu_snapshot(benchmark_cpu_snapshot_t *snapshot)
+{
+    TaskStatus_t *status;
+    UBaseType_t task_count;
+
+    snapshot->total = 0;
+    snapshot->idle = 0;
+
+    /* Leave room for tasks created between the two calls. */
+    task_count = uxTaskGetNumberOfTasks() + 2u;
+    status = pvPortMalloc(task_count * sizeof(TaskStatus_t));
+    if (NULL == status)
+    {
+        return;
+    }
+
+    task_count = uxTaskGetSystemState(status, task_count, &snapshot->total);
+
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        if (0 == strcmp(status[i].pcTaskName, configIDLE_TASK_NAME))
+        {
+            snapshot->idle = status[i].ulRunTimeCounter;
+            break;
+        }
+    }
+
+    vPortFree(status);
+}
+
+/******************************************************************************
+ * Function Name: benchmark_run
+ ******************************************************************************
+ * Summary:
+ *  Submits the messages of one run in batches at the configured rate, waits
+ *  for them to complete and prints the results as one JSON line. A message
+ *  the publish queue cannot take is retried a tick later; these stalls are
+ *  reported, as they mean the run asked for more than the window delivers.
+ *  The heap peak is the highest RTOS heap in use during the run; CPU use and
+ *  latencies are taken from the low power timer, so time in deep sleep counts
+ *  as idle.
+ *
+ * Parameters:
+ *  uint32_t index : Position of the run in PUBLISH_BENCHMARK_RUNS
+ *  const publish_benchmark_run_t *run : Run to perform
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void benchmark_run(uint32_t index, const publish_benchmark_run_t *run)
+{
+    cy_mqtt_publish_info_t info =
+    {
+        .qos = (cy_mqtt_qos_t) run->qos,
+        .topic = MQTT_BENCHMARK_TOPIC,
+        .topic_len = (sizeof(MQTT_BENCHMARK_TOPIC) - 1),
+        .retain = false,
+        .dup = false,
+        .payload = (const char *) benchmark_payload,
+        .payload_len = (run->payload_size < PUBLISH_BENCHMARK_PAYLOAD_MAX) ?
+                       run->payload_size : PUBLISH_BENCHMARK_PAYLOAD_MAX
+    };
+    uint32_t batch_size = (0u != run->batch_size) ? run->batch_size : 1u;
+    TickType_t batch_period = (0u != run->rate_hz) ?
+                              pdMS_TO_TICKS((batch_size * 1000u) / run->rate_hz) : 0u;
+    latency_trace_t trace = { 0 };
+    latency_histogram_t histogram;
+    heap_usage_stats_t heap;
+    cy_tls_send_stats_t tls_start;
+    cy_tls_send_stats_t tls_end;
+    benchmark_cpu_snapshot_t cpu_start;
+    benchmark_cpu_snapshot_t cpu_end;
+    uint32_t sent = 0;
+    uint32_t stalls = 0;
+    uint32_t cpu_permille;
+    uint32_t cpu_elapsed;
+    uint32_t cpu_idle;
+    uint32_t window_ms;
+    uint32_t duration_ms;
+    uint32_t rate_x100;
+    uint32_t records_x100;
+    uint32_t wire_bytes;
+    TickType_t start;
+    TickType_t wake;
+
+    __atomic_store_n(&benchmark_completed, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&benchmark_failed, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&benchmark_expected, run->message_count, __ATOMIC_RELAXED);
+    (void) ulTaskNotifyTake(pdTRUE, 0);
+
+    latency_reset();
+    cy_tls_get_send_stats(&tls_start);
+    benchmark_cpu_snapshot(&cpu_start);
+    heap_usage_reset_peak();
+    start = xTaskGetTickCount();
+    wake = start;
+
+    while (sent < run->message_count)
+    {
+        for (uint32_t i = 0; (i < batch_size) && (sent < run->message_count); i++)
+        {
+            /* The whole path is submission to completion, no queue stage. */
+            trace.event = latency_now();
+            trace.dequeued = trace.event;
+
+            while (CY_RSLT_SUCCESS != mqtt_publish_async_traced(&info, 0, benchmark_publish_complete,
+                                                                NULL, &trace))
+            {
+                stalls++;
+                vTaskDelay(1);
+                trace.event = latency_now();
+                trace.dequeued = trace.event;
+            }
+            sent++;
+        }
+
+        if (0u != batch_period)
+        {
+            vTaskDelayUntil(&wake, batch_period);
+        }
+    }
+
+    /* The drain timeout is longer than the publish timeout, so no completion
+     * of this run can be counted in the next one.
+     */
+    if (0u != run->message_count)
+    {
+        (void) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PUBLISH_BENCHMARK_DRAIN_TIMEOUT_MS));
+    }
+
+    duration_ms = (uint32_t) ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS);
+    /* Before the snapshot, whose buffer would count towards the peak. */
+    heap_usage_get_stats(&heap);
+    benchmark_cpu_snapshot(&cpu_end);
+    cy_tls_get_send_stats(&tls_end);
+    cpu_elapsed = cpu_end.total - cpu_start.total;
+    cpu_idle = cpu_end.idle - cpu_start.idle;
+    if (cpu_idle > cpu_elapsed)
+    {
+        cpu_idle = cpu_elapsed;
+    }
+    cpu_permille = (0u == cpu_elapsed) ? 0u :
+                   1000u - (uint32_t) (((uint64_t) cpu_idle * 1000u) / cpu_elapsed);
+    window_ms = (uint32_t) (((uint64_t) cpu_elapsed * 1000u) / TASK_MONITOR_RUNTIME_COUNTER_HZ);
+    latency_get_histogram(LATENCY_STAGE_TOTAL, &histogram);
+
+    rate_x100 = (0u == duration_ms) ? 0u :
+                (uint32_t) (((uint64_t) __atomic_load_n(&benchmark_completed, __ATOMIC_RELAXED) * 100000u) / duration_ms);
+
+    /* TLS records and bytes on the wire per message sent, to compare runs with
+     * and without MQTT_TRANSPORT_COMBINE_BUFFER_SIZE. They include whatever
+     * else was sent meanwhile, such as the PUBRELs of QoS 2 or a PINGREQ.
+     */
+    records_x100 = (0u == sent) ? 0u :
+                   (uint32_t) (((uint64_t) (tls_end.records - tls_start.records) * 100u) / sent);
+    wire_bytes = (0u == sent) ? 0u : ((tls_end.wire_bytes - tls_start.wire_bytes) / sent);
+
+    printf("{\"benchmark\":\"publish\",\"run\":%lu,\"window\":%u,\"qos\":%u,\"payload\":%u,\"batch\":%lu,"
+           "\"rate_hz\":%lu,\"sent\":%lu,\"completed\":%lu,\"failed\":%lu,\"stalls\":%lu,"
+           "\"duration_ms\":%lu,\"msgs_per_s\":%lu.%02lu,\"p50_us\":%lu,\"p99_us\":%lu,"
+           "\"p999_us\":%lu,\"max_us\":%lu,\"cpu_permille\":%lu,\"cpu_window_ms\":%lu,"
+           "\"combine_buffer\":%u,\"records_per_msg\":%lu.%02lu,\"wire_bytes_per_msg\":%lu,"
+           "\"heap_peak\":%lu}\n",
+           (unsigned long) index, (unsigned int) MQTT_PUBLISH_WINDOW, (unsigned int) run->qos, (unsigned int) info.payload_len,
+           (unsigned long) batch_size, (unsigned long) run->rate_hz, (unsigned long) sent,
+           (unsigned long) __atomic_load_n(&benchmark_completed, __ATOMIC_RELAXED),
+           (unsigned long) __atomic_load_n(&benchmark_failed, __ATOMIC_RELAXED),
+           (unsigned long) stalls, (unsigned long) duration_ms,
+           (unsigned long) (rate_x100 / 100u), (unsigned long) (rate_x100 % 100u),
+           (unsigned long) latency_percentile_us(&histogram, 500u),
+           (unsigned long) latency_percentile_us(&histogram, 990u),
+           (unsigned long) latency_percentile_us(&histogram, 999u),
+           (unsigned long) histogram.max_us, (unsigned long) cpu_permille,
+           (unsigned long) window_ms, (unsigned int) MQTT_TRANSPORT_COMBINE_BUFFER_SIZE,
+           (unsigned long) (records_x100 / 100u), (unsigned long) (records_x100 % 100u),
+           (unsigned long) wire_bytes, (unsigned long) heap.peak);
+}
+
+#endif /* ENABLE_PUBLISH_BENCHMARK */
+
+/* [] END OF FILE */
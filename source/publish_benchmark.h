@@ -0,0 +1,115 @@
+/******************************************************************************
+* File Name:   publish_benchmark.h
+*
+* Description: This file contains the declarations of the publish benchmark,
+*              which drives the asynchronous publisher at configured rates,
+*              QoS levels, payload and batch sizes and reports throughput,
+*              latency, CPU use and heap peak of every run.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef PUBLISH_BENCHMARK_H_
+#define PUBLISH_BENCHMARK_H_
+
+#include <stdint.h>
+#include "cy_result.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Runs of the benchmark, as publish_benchmark_run_t initializers:
+ * { qos, payload_size, batch_size, rate_hz, message_count }. A rate of 0
+ * submits as fast as the publish window and queue accept messages.
+ */
+#ifndef PUBLISH_BENCHMARK_RUNS
+#define PUBLISH_BENCHMARK_RUNS                  \
+    { 0u,   16u, 1u, 10u, 100u },               \
+    { 1u,   16u, 1u, 10u, 100u },               \
+    { 2u,   16u, 1u, 10u, 100u },               \
+    { 1u,   16u, 1u,  0u, 200u },               \
+    { 1u,  256u, 4u,  0u, 200u },               \
+    { 1u, 1024u, 4u,  0u, 200u }
+#endif
+
+/* Largest payload_size of a run. The payload is one static buffer shared by
+ * all messages.
+ */
+#ifndef PUBLISH_BENCHMARK_PAYLOAD_MAX
+#define PUBLISH_BENCHMARK_PAYLOAD_MAX           (1024u)
+#endif
+
+/* Time in milliseconds a run may take beyond its schedule for the last
+ * messages to complete.
+ */
+#ifndef PUBLISH_BENCHMARK_DRAIN_TIMEOUT_MS
+#define PUBLISH_BENCHMARK_DRAIN_TIMEOUT_MS      (30000u)
+#endif
+
+/* Time in milliseconds to wait before the first run, so that the connection
+ * and the subscription have settled.
+ */
+#ifndef PUBLISH_BENCHMARK_START_DELAY_MS
+#define PUBLISH_BENCHMARK_START_DELAY_MS        (5000u)
+#endif
+
+/* Task parameters for the benchmark task. It runs level with the publish
+ * workers: it blocks while they send, and below them the tasks at the same
+ * level would keep it from submitting at the configured rate.
+ */
+#define PUBLISH_BENCHMARK_TASK_PRIORITY         (2)
+#define PUBLISH_BENCHMARK_TASK_STACK_SIZE       (1024 * 1)
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+typedef struct
+{
+    uint8_t  qos;               /* 0, 1 or 2 */
+    uint16_t payload_size;      /* Bytes, at most PUBLISH_BENCHMARK_PAYLOAD_MAX */
+    uint16_t batch_size;        /* Messages submitted back to back */
+    uint32_t rate_hz;           /* Messages per second, 0 for unpaced */
+    uint32_t message_count;
+} publish_benchmark_run_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t publish_benchmark_start(void);
+
+#endif /* PUBLISH_BENCHMARK_H_ */
+
+/* [] END OF FILE */
@@ -44,8 +44,8 @@
 *******************************************************************************/
 
 
-#include "cyhal.h"
-#include "cybsp.h"
+#include <stdio.h>
+#include <string.h>
 #include "FreeRTOS.h"
 
 /* Task header files */
@@ -58,34 +58,40 @@
 
 /* Middleware libraries */
 #include "cy_mqtt_api.h"
-#include "cy_retarget_io.h"
+#include "task_monitor.h"
+#include "mqtt_publish_async.h"
+#include "app_log.h"
+#include "lz_compress.h"
+#include "latency_histogram.h"
+#include "mailbox.h"
+#include "board_io.h"
+#include "publish_benchmark.h"
 
 /******************************************************************************
 * Macros
 ******************************************************************************/
-/* Interrupt priority for User Button Input. */
-#define USER_BTN_INTR_PRIORITY          (3)
-
-/* The maximum number of times each PUBLISH in this example will be retried. */
-#define PUBLISH_RETRY_LIMIT             (10)
-
-/* A PUBLISH message is retried if no response is received within this 
- * time (in milliseconds).
- */
-#define PUBLISH_RETRY_MS                (1000)
-
-/* Queue length of a message queue that is used to communicate with the 
- * publisher task.
- */
-#define PUBLISHER_TASK_QUEUE_LENGTH     (3u)
+#if ENABLE_CBOR_PAYLOAD && (MQTT_PUBLISH_BUFFER_SIZE < DEVICE_STATE_RECORD_MAX_SIZE)
+#error "MQTT_PUBLISH_BUFFER_SIZE is too small for the device state record"
+#endif
 
 /******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 static void publisher_init(void);
 static void publisher_deinit(void);
-static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event);
-void print_heap_usage(char *msg);
+static void isr_button_press(void);
+static void publish_complete(cy_rslt_t result, uint32_t attempts, void *arg);
+#if ENABLE_CBOR_PAYLOAD
+static void publish_device_state_record(const char *message, const latency_trace_t *trace);
+#endif
+#if ENABLE_DIAGNOSTICS_PUBLISH
+static void publish_diagnostics(void);
+static void diagnostics_window_complete(void *arg);
+#endif
+#if ENABLE_PAYLOAD_COMPRESSION && ENABLE_DIAGNOSTICS_PUBLISH
+static void compress_payload(cy_mqtt_publish_info_t *info, const char *compressed_topic,
+                             uint8_t *buffer, size_t size);
+#endif
 
 /******************************************************************************
 * Global Variables
@@ -106,13 +112,6 @@ cy_mqtt_publish_info_t publish_info =
     .dup = false
 };
 
-/* Structure that stores the callback data for the GPIO interrupt event. */
-cyhal_gpio_callback_data_t cb_data =
-{
-    .callback = isr_button_press,
-    .callback_arg = NULL
-};
-
 /******************************************************************************
  * Function Name: publisher_task
  ******************************************************************************
@@ -131,73 +130,262 @@ cyhal_gpio_callback_data_t cb_data =
  ******************************************************************************/
 void publisher_task(void *pvParameters)
 {
-    /* Status variable */
-    cy_rslt_t result;
-
     publisher_data_t publisher_q_data;
 
-    /* Command to the MQTT client task */
-    mqtt_task_cmd_t mqtt_task_cmd;
-
     /* To avoid compiler warnings */
     (void) pvParameters;
 
-    /* Initialize and set-up the user button GPIO. */
-    publisher_init();
-
-    /* Create a message queue to communicate with other tasks and callbacks. */
-    publisher_task_q = xQueueCreate(PUBLISHER_TASK_QUEUE_LENGTH, sizeof(publisher_data_t));
+    publisher_task_init(NULL);
 
     while (true)
     {
         /* Wait for commands from other tasks and callbacks. */
         if (pdTRUE == xQueueReceive(publisher_task_q, &publisher_q_data, portMAX_DELAY))
         {
-            switch(publisher_q_data.cmd)
+            publisher_handle_command(&publisher_q_data);
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_task_init
+ ******************************************************************************
+ * Summary:
+ *  Starts the publish window and sets up the command queue and the user
+ *  button GPIO. Called by the publisher task, or by the reactor in the MQTT
+ *  client task when ENABLE_SINGLE_TASK_REACTOR is set.
+ *
+ * Parameters:
+ *  QueueSetHandle_t event_set : Queue set to add the command queue to, NULL
+ *                               if the queue is read directly
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publisher_task_init(QueueSetHandle_t event_set)
+{
+    /* Start the publish window. The publishes complete in its worker tasks,
+     * so this task is free for the next button press right away.
+     */
+    if (CY_RSLT_SUCCESS != mqtt_publish_async_init(mqtt_connection))
+    {
+        printf("  Publisher: Failed to start the publish workers!\n\n");
+    }
+
+    /* Create a message queue to communicate with other tasks and callbacks
+     * before the button interrupt that sends to it is enabled.
+     */
+    publisher_task_q = xQueueCreate(PUBLISHER_TASK_QUEUE_LENGTH, sizeof(publisher_data_t));
+
+#if (configUSE_QUEUE_SETS == 1)
+    if (NULL != event_set)
+    {
+        xQueueAddToSet(publisher_task_q, event_set);
+    }
+#else
+    (void) event_set;
+#endif
+
+    /* Initialize and set-up the user button GPIO. */
+    publisher_init();
+
+#if ENABLE_DIAGNOSTICS_PUBLISH
+    /* Publish the task monitor summary after every monitor interval. */
+    task_monitor_set_window_callback(diagnostics_window_complete, NULL);
+#endif
+
+#if ENABLE_PUBLISH_BENCHMARK
+    /* The benchmark shares the publish window with the button presses. */
+    if (CY_RSLT_SUCCESS != publish_benchmark_start())
+    {
+        printf("  Publisher: Failed to start the publish benchmark!\n\n");
+    }
+#endif
+}
+
+/******************************************************************************
+ * Function Name: publisher_handle_command
+ ******************************************************************************
+ * Summary:
+ *  Carries out one command from the publisher queue: the user button init
+ *  and deinit operations and the MQTT publish operations.
+ *
+ * Parameters:
+ *  const publisher_data_t *publisher_q_data : Command to carry out
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publisher_handle_command(const publisher_data_t *publisher_q_data)
+{
+#if !ENABLE_CBOR_PAYLOAD
+    /* Status variable */
+    cy_rslt_t result;
+#endif
+
+    /* Checkpoints of the button press being published. */
+    latency_trace_t trace;
+
+    switch(publisher_q_data->cmd)
+    {
+        case PUBLISHER_INIT:
+        {
+            /* Initialize and set-up the user button GPIO. */
+            publisher_init();
+            break;
+        }
+
+        case PUBLISHER_DEINIT:
+        {
+            /* Deinit the user button GPIO and corresponding interrupt. */
+            publisher_deinit();
+            break;
+        }
+
+        case PUBLISH_MQTT_MSG:
+        {
+            trace.event = publisher_q_data->timestamp;
+            trace.dequeued = (0u != trace.event) ? latency_now() : 0u;
+            trace.written = 0;
+
+#if ENABLE_CBOR_PAYLOAD
+            publish_device_state_record(publisher_q_data->data, &trace);
+#else
+            /* Publish the data received over the message queue. The
+             * payload is a literal, so it outlives the publish.
+             */
+            publish_info.payload = publisher_q_data->data;
+            publish_info.payload_len = strlen(publish_info.payload);
+
+            /* Both strings are literals, so the log can be deferred. */
+            APP_LOG("  Publisher: Publishing '%s' on the topic '%s'\n\n",
+                    publish_info.payload, publish_info.topic);
+
+            result = mqtt_publish_async_traced(&publish_info, 0, publish_complete,
+                                               (void *) publisher_q_data->data, &trace);
+            if (result != CY_RSLT_SUCCESS)
             {
-                case PUBLISHER_INIT:
-                {
-                    /* Initialize and set-up the user button GPIO. */
-                    publisher_init();
-                    break;
-                }
-
-                case PUBLISHER_DEINIT:
-                {
-                    /* Deinit the user button GPIO and corresponding interrupt. */
-                    publisher_deinit();
-                    break;
-                }
-
-                case PUBLISH_MQTT_MSG:
-                {
-                    /* Publish the data received over the message queue. */
-                    publish_info.payload = publisher_q_data.data;
-                    publish_info.payload_len = strlen(publish_info.payload);
-
-                    printf("  Publisher: Publishing '%s' on the topic '%s'\n\n",
-                           (char *) publish_info.payload, publish_info.topic);
-
-                    result = cy_mqtt_publish(mqtt_connection, &publish_info);
-
-                    if (result != CY_RSLT_SUCCESS)
-                    {
-                        printf("  Publisher: MQTT Publish failed with error 0x%0X.\n\n", (int)result);
-
-                        /* Communicate the publish failure with the the MQTT 
-                         * client task.
-                         */
-                        mqtt_task_cmd = HANDLE_MQTT_PUBLISH_FAILURE;
-                        xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
-                    }
-
-                    print_heap_usage("publisher_task: After publishing an MQTT message");
-                    break;
-                }
+                /* The window and its queue are full. */
+                publish_complete(result, 0, (void *) publisher_q_data->data);
             }
+#endif
+
+#if ENABLE_LATENCY_HISTOGRAM && defined(PRINT_LATENCY_HISTOGRAM)
+            /* Up to the previous press; this one is still in flight. */
+            latency_print();
+#endif
+            break;
+        }
+
+#if ENABLE_DIAGNOSTICS_PUBLISH
+        case PUBLISH_DIAGNOSTICS:
+        {
+            publish_diagnostics();
+            break;
         }
+#endif
+
+        default:
+            break;
+    }
+}
+
+/******************************************************************************
+ * Function Name: publish_complete
+ ******************************************************************************
+ * Summary:
+ *  Completion callback of the asynchronous publish. Runs in a publish worker
+ *  task, or in the caller if the publish could not be queued, and reports
+ *  failures to the MQTT client task.
+ *
+ * Parameters:
+ *  cy_rslt_t result : Result of the publish
+ *  uint32_t attempts : Number of publish attempts made
+ *  void *arg : Payload of the message; with ENABLE_CBOR_PAYLOAD the pool
+ *              buffer holding it
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_complete(cy_rslt_t result, uint32_t attempts, void *arg)
+{
+    /* Command to the MQTT client task */
+    mqtt_task_cmd_t mqtt_task_cmd;
+
+#if ENABLE_CBOR_PAYLOAD
+    mqtt_publish_buffer_free((uint8_t *) arg);
+#endif
+
+    if (result != CY_RSLT_SUCCESS)
+    {
+#if ENABLE_CBOR_PAYLOAD
+        APP_LOG("  Publisher: MQTT Publish of the device state record failed with error 0x%0X after %u attempts.\n\n",
+                (int)result, attempts);
+#else
+        APP_LOG("  Publisher: MQTT Publish of '%s' failed with error 0x%0X after %u attempts.\n\n",
+                arg, (int)result, attempts);
+#endif
+
+        /* Communicate the publish failure with the the MQTT client task. */
+        mqtt_task_cmd = HANDLE_MQTT_PUBLISH_FAILURE;
+#if ENABLE_SINGLE_TASK_REACTOR
+        /* This may run in the reactor, which is also the reader of the queue. */
+        queue_send_or_drop(mqtt_task_q, &mqtt_task_cmd, NULL, QUEUE_DROP_NEWEST, NULL);
+#else
+        xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+#endif
+    }
+}
+
+#if ENABLE_CBOR_PAYLOAD
+/******************************************************************************
+ * Function Name: publish_device_state_record
+ ******************************************************************************
+ * Summary:
+ *  Publishes the device state requested by 'message' as a CBOR record. The
+ *  record is encoded straight into a buffer from the publish pool, which
+ *  publish_complete() returns to the pool.
+ *
+ * Parameters:
+ *  const char *message : MQTT_DEVICE_ON_MESSAGE or MQTT_DEVICE_OFF_MESSAGE
+ *  const latency_trace_t *trace : Checkpoints of the button press
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_device_state_record(const char *message, const latency_trace_t *trace)
+{
+    device_state_record_t record;
+    uint8_t *buffer;
+    cy_rslt_t result = ~CY_RSLT_SUCCESS;
+
+    record.state = (0 == strcmp(message, MQTT_DEVICE_ON_MESSAGE)) ? DEVICE_ON_STATE : DEVICE_OFF_STATE;
+    record.uptime_ms = (uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    buffer = mqtt_publish_buffer_alloc();
+    if (NULL != buffer)
+    {
+        publish_info.payload = (const char *) buffer;
+        publish_info.payload_len = device_state_record_encode(&record, buffer, MQTT_PUBLISH_BUFFER_SIZE);
+
+        /* Both strings are literals, so the log can be deferred. */
+        APP_LOG("  Publisher: Publishing the '%s' record on the topic '%s'\n\n",
+                message, publish_info.topic);
+
+        result = mqtt_publish_async_traced(&publish_info, 0, publish_complete, buffer, trace);
+    }
+
+    if (result != CY_RSLT_SUCCESS)
+    {
+        /* No buffer, or the window and its queue are full. */
+        publish_complete(result, 0, buffer);
     }
 }
+#endif /* #if ENABLE_CBOR_PAYLOAD */
 
 /******************************************************************************
  * Function Name: publisher_init
@@ -215,12 +403,8 @@ void publisher_task(void *pvParameters)
  ******************************************************************************/
 static void publisher_init(void)
 {
-    /* Initialize the user button GPIO and register interrupt on falling edge. */
-    cyhal_gpio_init(CYBSP_USER_BTN, CYHAL_GPIO_DIR_INPUT,
-                    CYHAL_GPIO_DRIVE_PULLUP, CYBSP_BTN_OFF);
-    cyhal_gpio_register_callback(CYBSP_USER_BTN, &cb_data);
-    cyhal_gpio_enable_event(CYBSP_USER_BTN, CYHAL_GPIO_IRQ_FALL,
-                            USER_BTN_INTR_PRIORITY, true);
+    /* Initialize the user button and publish on every press. */
+    board_button_enable(isr_button_press);
     
     printf("Press the user button (SW2) to publish \"%s\"/\"%s\" on the topic '%s'...\n\n", 
            MQTT_DEVICE_ON_MESSAGE, MQTT_DEVICE_OFF_MESSAGE, publish_info.topic);
@@ -242,42 +426,41 @@ static void publisher_init(void)
  ******************************************************************************/
 static void publisher_deinit(void)
 {
-    /* Deregister the ISR and disable the interrupt on the user button. */
-    cyhal_gpio_register_callback(CYBSP_USER_BTN, &cb_data);
-    cyhal_gpio_enable_event(CYBSP_USER_BTN, CYHAL_GPIO_IRQ_FALL,
-                            USER_BTN_INTR_PRIORITY, false);
-    cyhal_gpio_free(CYBSP_USER_BTN);
+    /* Disable the interrupt on the user button. */
+    board_button_disable();
 }
 
 /******************************************************************************
  * Function Name: isr_button_press
  ******************************************************************************
  * Summary:
- *  GPIO interrupt service routine. This function detects button
- *  presses and sends the publish command along with the data to be published 
+ *  User button handler, called from the GPIO interrupt. This function detects
+ *  button presses and sends the publish command along with the data to be published 
  *  to the publisher task over a message queue. Based on the current device 
  *  state, the publish data is set so that the device state gets toggled.
  *
  * Parameters:
- *  void *callback_arg : pointer to variable passed to the ISR (unused)
- *  cyhal_gpio_event_t event : GPIO event type (unused)
+ *  void
  *
  * Return:
  *  void
  *
  ******************************************************************************/
-static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event)
+static void isr_button_press(void)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     publisher_data_t publisher_q_data;
 
-    /* To avoid compiler warnings */
-    (void) callback_arg;
-    (void) event;
-
     /* Assign the publish command to be sent to the publisher task. */
     publisher_q_data.cmd = PUBLISH_MQTT_MSG;
 
+    /* Start of the button to PUBACK latency. */
+#if ENABLE_LATENCY_HISTOGRAM
+    publisher_q_data.timestamp = latency_now();
+#else
+    publisher_q_data.timestamp = 0;
+#endif
+
     /* Assign the publish message payload so that the device state toggles. */
     if (current_device_state == DEVICE_ON_STATE)
     {
@@ -293,4 +476,161 @@ static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event)
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+#if ENABLE_DIAGNOSTICS_PUBLISH
+/******************************************************************************
+ * Function Name: publish_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the binary task monitor summary on MQTT_DIAG_TOPIC with QoS 0.
+ *  A lost summary is simply replaced by the next one, so failures are only
+ *  reported and not handed to the MQTT client task.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_diagnostics(void)
+{
+    static uint8_t summary[TASK_MONITOR_SUMMARY_MAX_SIZE];
+#if ENABLE_LATENCY_HISTOGRAM
+    static uint8_t latency_summary[LATENCY_SUMMARY_MAX_SIZE];
+#endif
+#if ENABLE_PAYLOAD_COMPRESSION
+    static uint8_t compressed[TASK_MONITOR_SUMMARY_MAX_SIZE];
+#endif
+    cy_mqtt_publish_info_t diag_info =
+    {
+        .qos = CY_MQTT_QOS0,
+        .topic = MQTT_DIAG_TOPIC,
+        .topic_len = (sizeof(MQTT_DIAG_TOPIC) - 1),
+        .retain = false,
+        .dup = false
+    };
+    cy_rslt_t result;
+
+    diag_info.payload = (const char *) summary;
+    diag_info.payload_len = task_monitor_encode_summary(summary, sizeof(summary));
+    if (0 == diag_info.payload_len)
+    {
+        return;
+    }
+
+#if ENABLE_PAYLOAD_COMPRESSION
+    compress_payload(&diag_info, MQTT_DIAG_TOPIC MQTT_COMPRESSED_TOPIC_SUFFIX,
+                     compressed, sizeof(compressed));
+#endif
+
+    result = cy_mqtt_publish(mqtt_connection, &diag_info);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("  Publisher: Diagnostics publish failed with error 0x%0X.\n\n", (int)result);
+    }
+
+#if ENABLE_LATENCY_HISTOGRAM
+    /* Same QoS 0 info, so reuse it for the latency histograms. */
+    diag_info.topic = MQTT_LATENCY_TOPIC;
+    diag_info.topic_len = sizeof(MQTT_LATENCY_TOPIC) - 1;
+    diag_info.payload = (const char *) latency_summary;
+    diag_info.payload_len = latency_encode_summary(latency_summary, sizeof(latency_summary));
+    if (0 != diag_info.payload_len)
+    {
+        result = cy_mqtt_publish(mqtt_connection, &diag_info);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            printf("  Publisher: Latency publish failed with error 0x%0X.\n\n", (int)result);
+        }
+    }
+#endif
+}
+
+/******************************************************************************
+ * Function Name: diagnostics_window_complete
+ ******************************************************************************
+ * Summary:
+ *  Task monitor callback. Queues a diagnostics publish without blocking the
+ *  monitor task; the summary is dropped if the queue is full.
+ *
+ * Parameters:
+ *  void *arg : Callback argument (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void diagnostics_window_complete(void *arg)
+{
+    publisher_data_t publisher_q_data = { .cmd = PUBLISH_DIAGNOSTICS, .data = NULL, .timestamp = 0 };
+
+    (void) arg;
+
+    xQueueSend(publisher_task_q, &publisher_q_data, 0);
+}
+#endif /* #if ENABLE_DIAGNOSTICS_PUBLISH */
+
+#if ENABLE_PAYLOAD_COMPRESSION && ENABLE_DIAGNOSTICS_PUBLISH
+/******************************************************************************
+ * Function Name: compress_payload
+ ******************************************************************************
+ * Summary:
+ *  Compresses the payload of a publish into 'buffer'. If the result is
+ *  smaller, the publish is switched to it and to 'compressed_topic';
+ *  otherwise it is left as it is. Define PRINT_COMPRESSION_STATS to print
+ *  the ratio, the CPU cycles spent and the bytes saved so far.
+ *
+ * Parameters:
+ *  cy_mqtt_publish_info_t *info : Publish to compress
+ *  const char *compressed_topic : Topic for the compressed message
+ *  uint8_t *buffer : Receives the compressed payload, must outlive the publish
+ *  size_t size : Size of 'buffer'
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void compress_payload(cy_mqtt_publish_info_t *info, const char *compressed_topic,
+                             uint8_t *buffer, size_t size)
+{
+    /* Only used from the publisher task. */
+    static lz_compress_state_t lz_state;
+    size_t compressed_len;
+#if defined(PRINT_COMPRESSION_STATS)
+    static uint32_t bytes_saved = 0;
+    uint32_t cycles = board_cycle_count();
+#endif
+
+    if (info->payload_len < MQTT_COMPRESS_MIN_SIZE)
+    {
+        return;
+    }
+
+    /* Stopping one byte short of the original skips what does not shrink. */
+    compressed_len = lz_compress(&lz_state, (const uint8_t *) info->payload, info->payload_len,
+                                 buffer, (size < info->payload_len) ? size : (info->payload_len - 1u));
+
+#if defined(PRINT_COMPRESSION_STATS)
+    cycles = board_cycle_count() - cycles;
+    if (0 != compressed_len)
+    {
+        bytes_saved += info->payload_len - compressed_len;
+    }
+    printf("  Publisher: Compressed %u to %u bytes in %lu cycles, %lu bytes saved so far.\n\n",
+           (unsigned int) info->payload_len, (unsigned int) compressed_len,
+           (unsigned long) cycles, (unsigned long) bytes_saved);
+#endif
+
+    if (0 == compressed_len)
+    {
+        return;
+    }
+
+    info->payload = (const char *) buffer;
+    info->payload_len = compressed_len;
+    info->topic = compressed_topic;
+    info->topic_len = strlen(compressed_topic);
+}
+#endif /* #if ENABLE_PAYLOAD_COMPRESSION && ENABLE_DIAGNOSTICS_PUBLISH */
+
 /* [] END OF FILE */
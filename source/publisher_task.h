@@ -54,6 +54,11 @@
 #define PUBLISHER_TASK_PRIORITY               (2)
 #define PUBLISHER_TASK_STACK_SIZE             (1024 * 1)
 
+/* Queue length of a message queue that is used to communicate with the 
+ * publisher task.
+ */
+#define PUBLISHER_TASK_QUEUE_LENGTH           (3u)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -62,13 +67,15 @@ typedef enum
 {
     PUBLISHER_INIT,
     PUBLISHER_DEINIT,
-    PUBLISH_MQTT_MSG
+    PUBLISH_MQTT_MSG,
+    PUBLISH_DIAGNOSTICS
 } publisher_cmd_t;
 
 /* Struct to be passed via the publisher task queue */
 typedef struct{
     publisher_cmd_t cmd;
     char *data;
+    uint32_t timestamp;     /* latency_now() of the event, 0 if not traced */
 } publisher_data_t;
 
 /*******************************************************************************
@@ -81,6 +88,8 @@ extern QueueHandle_t publisher_task_q;
 * Function Prototypes
 ********************************************************************************/
 void publisher_task(void *pvParameters);
+void publisher_task_init(QueueSetHandle_t event_set);
+void publisher_handle_command(const publisher_data_t *publisher_q_data);
 
 #endif /* PUBLISHER_TASK_H_ */
 
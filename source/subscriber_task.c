@@ -43,8 +43,7 @@
 *******************************************************************************/
 
 
-#include "cyhal.h"
-#include "cybsp.h"
+#include <stdio.h>
 #include "string.h"
 #include "FreeRTOS.h"
 
@@ -57,7 +56,9 @@
 
 /* Middleware libraries */
 #include "cy_mqtt_api.h"
-#include "cy_retarget_io.h"
+#include "app_log.h"
+#include "mailbox.h"
+#include "board_io.h"
 
 /******************************************************************************
 * Macros
@@ -71,11 +72,6 @@
 /* The number of MQTT topics to be subscribed to. */
 #define SUBSCRIPTION_COUNT                      (1)
 
-/* Queue length of a message queue that is used to communicate with the 
- * subscriber task.
- */
-#define SUBSCRIBER_TASK_QUEUE_LENGTH            (1u)
-
 /******************************************************************************
 * Global Variables
 *******************************************************************************/
@@ -90,6 +86,11 @@ QueueHandle_t subscriber_task_q;
  */
 uint32_t current_device_state = DEVICE_OFF_STATE;
 
+/* Latest device state received from the broker and not yet applied. Only the
+ * MQTT receive path posts to it and only the subscriber task takes from it.
+ */
+static mailbox_t device_state_mailbox = MAILBOX_INIT;
+
 /* Configure the subscription information structure. */
 cy_mqtt_subscribe_info_t subscribe_info =
 {
@@ -103,7 +104,7 @@ cy_mqtt_subscribe_info_t subscribe_info =
 *******************************************************************************/
 static void subscribe_to_topic(void);
 static void unsubscribe_from_topic(void);
-void print_heap_usage(char *msg);
+static void apply_device_state(void);
 
 /******************************************************************************
  * Function Name: subscriber_task
@@ -112,7 +113,8 @@ void print_heap_usage(char *msg);
  *  Task that sets up the user LED GPIO, subscribes to the specified MQTT topic,
  *  and controls the user LED based on the received commands over the message 
  *  queue. The task can also unsubscribe from the topic based on the commands
- *  via the message queue.
+ *  via the message queue. The received device state is picked up from
+ *  'device_state_mailbox' whenever the task wakes.
  *
  * Parameters:
  *  void *pvParameters : Task parameter defined during task creation (unused)
@@ -128,49 +130,127 @@ void subscriber_task(void *pvParameters)
     /* To avoid compiler warnings */
     (void) pvParameters;
 
+    subscriber_task_init(NULL);
+
+    while (true)
+    {
+        /* Wait for commands from other tasks and callbacks. */
+        if (pdTRUE == xQueueReceive(subscriber_task_q, &subscriber_q_data, portMAX_DELAY))
+        {
+            subscriber_handle_command(&subscriber_q_data);
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: subscriber_task_init
+ ******************************************************************************
+ * Summary:
+ *  Sets up the user LED GPIO and the command queue, and subscribes to the
+ *  MQTT topic. Called by the subscriber task, or by the reactor in the MQTT
+ *  client task when ENABLE_SINGLE_TASK_REACTOR is set.
+ *
+ * Parameters:
+ *  QueueSetHandle_t event_set : Queue set to add the command queue to, NULL
+ *                               if the queue is read directly
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void subscriber_task_init(QueueSetHandle_t event_set)
+{
     /* Initialize the User LED. */
-    cyhal_gpio_init(CYBSP_USER_LED, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_PULLUP,
-                    CYBSP_LED_STATE_OFF);
+    board_led_init();
+
+    /* Create a message queue to communicate with other tasks and callbacks
+     * before subscribing, as the first message may arrive right after.
+     */
+    subscriber_task_q = xQueueCreate(SUBSCRIBER_TASK_QUEUE_LENGTH, sizeof(subscriber_data_t));
+
+#if (configUSE_QUEUE_SETS == 1)
+    if (NULL != event_set)
+    {
+        xQueueAddToSet(subscriber_task_q, event_set);
+    }
+#else
+    (void) event_set;
+#endif
 
     /* Subscribe to the specified MQTT topic. */
     subscribe_to_topic();
+}
 
-    /* Create a message queue to communicate with other tasks and callbacks. */
-    subscriber_task_q = xQueueCreate(SUBSCRIBER_TASK_QUEUE_LENGTH, sizeof(subscriber_data_t));
-
-    while (true)
+/******************************************************************************
+ * Function Name: subscriber_handle_command
+ ******************************************************************************
+ * Summary:
+ *  Carries out one command from the subscriber queue, then applies the
+ *  device state if one is waiting in 'device_state_mailbox'.
+ *
+ * Parameters:
+ *  const subscriber_data_t *subscriber_q_data : Command to carry out
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void subscriber_handle_command(const subscriber_data_t *subscriber_q_data)
+{
+    switch(subscriber_q_data->cmd)
     {
-        /* Wait for commands from other tasks and callbacks. */
-        if (pdTRUE == xQueueReceive(subscriber_task_q, &subscriber_q_data, portMAX_DELAY))
+        case SUBSCRIBE_TO_TOPIC:
         {
-            switch(subscriber_q_data.cmd)
-            {
-                case SUBSCRIBE_TO_TOPIC:
-                {
-                    subscribe_to_topic();
-                    break;
-                }
-
-                case UNSUBSCRIBE_FROM_TOPIC:
-                {
-                    unsubscribe_from_topic();
-                    break;
-                }
-
-                case UPDATE_DEVICE_STATE:
-                {
-                    /* Update the LED state as per received notification. */
-                    cyhal_gpio_write(CYBSP_USER_LED, subscriber_q_data.data);
-
-                    /* Update the current device state extern variable. */
-                    current_device_state = subscriber_q_data.data;
-
-                    print_heap_usage("subscriber_task: After updating LED state");
-                    break;
-                }
-            }
+            subscribe_to_topic();
+            break;
+        }
+
+        case UNSUBSCRIBE_FROM_TOPIC:
+        {
+            unsubscribe_from_topic();
+            break;
+        }
+
+        case UPDATE_DEVICE_STATE:
+        {
+            /* Only wakes the task; the state is in the mailbox. */
+            break;
         }
     }
+
+    /* A wake-up dropped because the queue was full is covered here, after
+     * whichever command filled it.
+     */
+    apply_device_state();
+}
+
+/******************************************************************************
+ * Function Name: apply_device_state
+ ******************************************************************************
+ * Summary:
+ *  Applies the latest device state posted by the MQTT subscription callback,
+ *  if there is one. States received while the task was busy are coalesced,
+ *  only the last one counts.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void apply_device_state(void)
+{
+    uint32_t device_state;
+
+    if (mailbox_take(&device_state_mailbox, &device_state))
+    {
+        /* Update the LED state as per received notification. */
+        board_led_write(device_state);
+
+        /* Update the current device state extern variable. */
+        current_device_state = device_state;
+    }
 }
 
 /******************************************************************************
@@ -218,7 +298,12 @@ static void subscribe_to_topic(void)
 
         /* Notify the MQTT client task about the subscription failure */
         mqtt_task_cmd = HANDLE_MQTT_SUBSCRIBE_FAILURE;
+#if ENABLE_SINGLE_TASK_REACTOR
+        /* This runs in the reactor, which is also the reader of the queue. */
+        queue_send_or_drop(mqtt_task_q, &mqtt_task_cmd, NULL, QUEUE_DROP_NEWEST, NULL);
+#else
         xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+#endif
     }
 }
 
@@ -227,9 +312,10 @@ static void subscribe_to_topic(void)
  ******************************************************************************
  * Summary:
  *  Callback to handle incoming MQTT messages. This callback prints the 
- *  contents of the incoming message and informs the subscriber task, via a 
- *  message queue, to turn on / turn off the device based on the received 
- *  message.
+ *  contents of the incoming message and hands the device state to the
+ *  subscriber task through 'device_state_mailbox'. It runs on the MQTT
+ *  receive path, so it never waits for the subscriber task: a newer state
+ *  replaces one that has not been applied yet.
  *
  * Parameters:
  *  cy_mqtt_publish_info_t *received_msg_info : Information structure of the 
@@ -245,41 +331,67 @@ void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
     const char *received_msg = received_msg_info->payload;
     int received_msg_len = received_msg_info->payload_len;
 
-    /* Data to be sent to the subscriber task queue. */
-    subscriber_data_t subscriber_q_data;
+    /* Device state to be posted to the subscriber task. */
+    uint32_t device_state;
+
+    /* Command to wake the subscriber task. */
+    subscriber_data_t subscriber_q_data = { .cmd = UPDATE_DEVICE_STATE, .data = 0 };
 
-    printf("  Subsciber: Incoming MQTT message received:\n"
-           "    Publish topic name: %.*s\n"
-           "    Publish QoS: %d\n"
-           "    Publish payload: %.*s\n\n",
-           received_msg_info->topic_len, received_msg_info->topic,
-           (int) received_msg_info->qos,
-           (int) received_msg_info->payload_len, (const char *)received_msg_info->payload);
+    /* This runs on the MQTT receive path, so the message is logged deferred.
+     * The topic and payload are only valid during this callback, so the
+     * matching constant strings are logged instead.
+     */
+    const char *logged_msg;
 
-    /* Assign the command to be sent to the subscriber task. */
-    subscriber_q_data.cmd = UPDATE_DEVICE_STATE;
+#if ENABLE_CBOR_PAYLOAD
+    /* Start from an invalid state, so a record without one is rejected. */
+    device_state_record_t record = { .state = UINT32_MAX, .uptime_ms = 0 };
+#endif
 
+#if ENABLE_CBOR_PAYLOAD
+    if (device_state_record_decode(&record, (const uint8_t *) received_msg, received_msg_len) &&
+        ((DEVICE_ON_STATE == record.state) || (DEVICE_OFF_STATE == record.state)))
+    {
+        device_state = record.state;
+        logged_msg = (DEVICE_ON_STATE == record.state) ? MQTT_DEVICE_ON_MESSAGE : MQTT_DEVICE_OFF_MESSAGE;
+    }
+#else
     /* Assign the device state depending on the received MQTT message. */
     if ((strlen(MQTT_DEVICE_ON_MESSAGE) == received_msg_len) &&
         (strncmp(MQTT_DEVICE_ON_MESSAGE, received_msg, received_msg_len) == 0))
     {
-        subscriber_q_data.data = DEVICE_ON_STATE;
+        device_state = DEVICE_ON_STATE;
+        logged_msg = MQTT_DEVICE_ON_MESSAGE;
     }
     else if ((strlen(MQTT_DEVICE_OFF_MESSAGE) == received_msg_len) &&
              (strncmp(MQTT_DEVICE_OFF_MESSAGE, received_msg, received_msg_len) == 0))
     {
-        subscriber_q_data.data = DEVICE_OFF_STATE;
+        device_state = DEVICE_OFF_STATE;
+        logged_msg = MQTT_DEVICE_OFF_MESSAGE;
     }
+#endif
     else
     {
-        printf("  Subscriber: Received MQTT message not in valid format!\n");
+        APP_LOG("  Subscriber: Received MQTT message of %d bytes not in valid format!\n",
+                received_msg_len);
         return;
     }
 
-    print_heap_usage("MQTT subscription callback");
-
-    /* Send the command and data to subscriber task queue */
-    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+    APP_LOG("  Subsciber: Incoming MQTT message received:\n"
+            "    Publish topic name: %s\n"
+            "    Publish QoS: %d\n"
+            "    Publish payload: %s\n\n",
+            MQTT_SUB_TOPIC, (int) received_msg_info->qos, logged_msg);
+
+    /* Post the state, then wake the subscriber task. If its queue is full
+     * the task is about to run anyway and picks up the state after the
+     * command that is queued, so the wake-up can be dropped.
+     */
+    if (mailbox_post(&device_state_mailbox, device_state))
+    {
+        APP_LOG("  Subscriber: Unapplied device state replaced\n");
+    }
+    queue_send_or_drop(subscriber_task_q, &subscriber_q_data, NULL, QUEUE_DROP_NEWEST, NULL);
 }
 
 /******************************************************************************
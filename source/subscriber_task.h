@@ -47,6 +47,7 @@
 #include "task.h"
 #include "queue.h"
 #include "cy_mqtt_api.h"
+#include "cbor_codec.h"
 
 /*******************************************************************************
 * Macros
@@ -55,10 +56,23 @@
 #define SUBSCRIBER_TASK_PRIORITY           (2)
 #define SUBSCRIBER_TASK_STACK_SIZE         (1024 * 1)
 
+/* Queue length of a message queue that is used to communicate with the 
+ * subscriber task. Device state updates do not take queue slots; they are
+ * coalesced in a mailbox.
+ */
+#define SUBSCRIBER_TASK_QUEUE_LENGTH       (1u)
+
 /* 8-bit value denoting the device (LED) state. */
 #define DEVICE_ON_STATE                    (0x00u)
 #define DEVICE_OFF_STATE                   (0x01u)
 
+/* Fields of the device state record: key, CBOR type and member. */
+#define DEVICE_STATE_RECORD_SCHEMA(X)                                           \
+    X(1, uint, state)                                                           \
+    X(2, uint, uptime_ms)
+
+#define DEVICE_STATE_RECORD_MAX_SIZE       CBOR_RECORD_MAX_SIZE(DEVICE_STATE_RECORD_SCHEMA)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -76,6 +90,16 @@ typedef struct{
     uint8_t data;
 } subscriber_data_t;
 
+/* Device state record, published when ENABLE_CBOR_PAYLOAD is set. */
+typedef struct
+{
+    uint32_t state;         /* DEVICE_ON_STATE or DEVICE_OFF_STATE */
+    uint32_t uptime_ms;     /* Uptime of the publishing device */
+} device_state_record_t;
+
+/* Defines device_state_record_encode() and device_state_record_decode(). */
+CBOR_DEFINE_RECORD(device_state_record, device_state_record_t, DEVICE_STATE_RECORD_SCHEMA)
+
 /*******************************************************************************
 * Extern Variables
 ********************************************************************************/
@@ -87,6 +111,8 @@ extern uint32_t current_device_state;
 * Function Prototypes
 ********************************************************************************/
 void subscriber_task(void *pvParameters);
+void subscriber_task_init(QueueSetHandle_t event_set);
+void subscriber_handle_command(const subscriber_data_t *subscriber_q_data);
 void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info);
 
 #endif /* SUBSCRIBER_TASK_H_ */
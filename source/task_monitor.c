@@ -0,0 +1,549 @@
+/******************************************************************************
+* File Name:   task_monitor.c
+*
+* Description: This file contains the task monitor. It takes snapshots of the
+*              FreeRTOS task list to report how much of each task's stack has
+*              ever been used, and flags tasks that are close to overflowing,
+*              so that stack sizes can be chosen from measured data. It also
+*              provides the run time stats counter and turns the per-task
+*              run time into a CPU share over a window.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "cyhal.h"
+
+/* FreeRTOS header files */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "task_monitor.h"
+#include "heap_usage.h"
+
+#if (configUSE_TRACE_FACILITY != 1)
+#error "The task monitor needs configUSE_TRACE_FACILITY set to 1 in FreeRTOSConfig.h"
+#endif
+
+#if (configGENERATE_RUN_TIME_STATS != 1)
+#error "The task monitor needs configGENERATE_RUN_TIME_STATS set to 1 in FreeRTOSConfig.h"
+#endif
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+#if (TASK_MONITOR_INTERVAL_MS > 0)
+static TaskHandle_t task_monitor_handle = NULL;
+#endif
+
+/* Free running counter read by the scheduler on every context switch. */
+static cyhal_lptimer_t runtime_counter;
+static bool runtime_counter_running = false;
+
+/* Run time of each task at the start of the current window, and the CPU
+ * share measured over the last completed window.
+ */
+typedef struct
+{
+    struct
+    {
+        TaskHandle_t handle;
+        uint32_t     run_time;
+    } start[TASK_MONITOR_MAX_TASKS];
+    uint32_t            start_count;
+    uint32_t            start_total;
+
+    task_monitor_cpu_t  window[TASK_MONITOR_MAX_TASKS];
+    uint32_t            window_count;
+    uint32_t            window_ms;
+
+    task_monitor_window_callback_t callback;
+    void                *callback_arg;
+} task_monitor_cpu_stats_t;
+
+static task_monitor_cpu_stats_t cpu_stats;
+
+/******************************************************************************
+ * Function Name: task_monitor_runtime_counter_init
+ ******************************************************************************
+ * Summary:
+ *  Starts a free running 32-bit low power timer at
+ *  TASK_MONITOR_RUNTIME_COUNTER_HZ. Unlike a TCPWM on clk_peri it keeps
+ *  counting through the deep sleep entered from the idle task. Called by the
+ *  scheduler through portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() before the
+ *  first task runs. If no timer is available the run time stats read as zero.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void task_monitor_runtime_counter_init(void)
+{
+    /* The low power timer free runs from the moment it is initialized. */
+    if (CY_RSLT_SUCCESS != cyhal_lptimer_init(&runtime_counter))
+    {
+        printf("Task monitor: no timer for the run time stats!\n");
+        return;
+    }
+
+    runtime_counter_running = true;
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_runtime_counter_get
+ ******************************************************************************
+ * Summary:
+ *  Returns the run time stats counter. This is on the context switch path, so
+ *  it is a single register read.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Counter value in ticks of TASK_MONITOR_RUNTIME_COUNTER_HZ.
+ *
+ ******************************************************************************/
+uint32_t task_monitor_runtime_counter_get(void)
+{
+    return runtime_counter_running ? cyhal_lptimer_read(&runtime_counter) : 0u;
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_get_stacks
+ ******************************************************************************
+ * Summary:
+ *  Takes a snapshot of the stack high-water mark of every task. The names in
+ *  the result point into the task control blocks and are only valid while
+ *  the tasks exist.
+ *
+ * Parameters:
+ *  task_monitor_stack_t *stacks : Array receiving one entry per task
+ *  uint32_t max_stacks : Number of entries in 'stacks'
+ *
+ * Return:
+ *  uint32_t : Number of entries written, 0 on failure.
+ *
+ ******************************************************************************/
+uint32_t task_monitor_get_stacks(task_monitor_stack_t *stacks, uint32_t max_stacks)
+{
+    TaskStatus_t *status;
+    UBaseType_t task_count;
+    uint32_t count = 0;
+
+    /* Leave room for tasks created between the two calls. */
+    task_count = uxTaskGetNumberOfTasks() + 2u;
+    status = pvPortMalloc(task_count * sizeof(TaskStatus_t));
+    if (NULL == status)
+    {
+        return 0;
+    }
+
+    task_count = uxTaskGetSystemState(status, task_count, NULL);
+
+    for (UBaseType_t i = 0; (i < task_count) && (count < max_stacks); i++)
+    {
+        stacks[count].name = status[i].pcTaskName;
+        stacks[count].stack_free_min = (uint32_t) status[i].usStackHighWaterMark * sizeof(StackType_t);
+        stacks[count].low_margin = (stacks[count].stack_free_min < TASK_MONITOR_STACK_MARGIN_BYTES);
+        count++;
+    }
+
+    vPortFree(status);
+
+    return count;
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_print_stacks
+ ******************************************************************************
+ * Summary:
+ *  Prints the lowest unused stack of every task and marks the tasks that are
+ *  within TASK_MONITOR_STACK_MARGIN_BYTES of overflowing.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void task_monitor_print_stacks(void)
+{
+    task_monitor_stack_t stacks[TASK_MONITOR_MAX_TASKS];
+    uint32_t count = task_monitor_get_stacks(stacks, TASK_MONITOR_MAX_TASKS);
+
+    printf("\r\n********** Stack Usage **********\r\n");
+    printf("%-*s  Min free (bytes)\r\n", (int) configMAX_TASK_NAME_LEN, "Task");
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        printf("%-*s  %6"PRIu32"%s\r\n", (int) configMAX_TASK_NAME_LEN, stacks[i].name,
+               stacks[i].stack_free_min, stacks[i].low_margin ? "  <-- LOW" : "");
+    }
+
+    printf("*********************************\r\n\n");
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_sample_cpu
+ ******************************************************************************
+ * Summary:
+ *  Closes the current CPU window: the run time each task got since the start
+ *  of the window is turned into a share of the elapsed time, and a new window
+ *  is started.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void task_monitor_sample_cpu(void)
+{
+    task_monitor_cpu_t window[TASK_MONITOR_MAX_TASKS];
+    TaskStatus_t *status;
+    UBaseType_t task_count;
+    uint32_t total;
+    uint32_t elapsed;
+    uint32_t count = 0;
+
+    task_count = uxTaskGetNumberOfTasks() + 2u;
+    status = pvPortMalloc(task_count * sizeof(TaskStatus_t));
+    if (NULL == status)
+    {
+        return;
+    }
+
+    task_count = uxTaskGetSystemState(status, task_count, &total);
+    elapsed = total - cpu_stats.start_total;
+
+    for (UBaseType_t i = 0; (i < task_count) && (count < TASK_MONITOR_MAX_TASKS); i++)
+    {
+        uint32_t run_time = status[i].ulRunTimeCounter;
+        uint32_t stack_free = (uint32_t) status[i].usStackHighWaterMark * sizeof(StackType_t);
+
+        /* A task that is new in this window ran only within it. */
+        for (uint32_t j = 0; j < cpu_stats.start_count; j++)
+        {
+            if (cpu_stats.start[j].handle == status[i].xHandle)
+            {
+                run_time -= cpu_stats.start[j].run_time;
+                break;
+            }
+        }
+
+        if (run_time > elapsed)
+        {
+            run_time = elapsed;
+        }
+
+        strncpy(window[count].name, status[i].pcTaskName, configMAX_TASK_NAME_LEN - 1);
+        window[count].name[configMAX_TASK_NAME_LEN - 1] = '\0';
+        window[count].cpu_permille = (elapsed > 0u) ? (uint16_t) (((uint64_t) run_time * 1000u) / elapsed) : 0u;
+        window[count].stack_free_min = (stack_free > UINT16_MAX) ? UINT16_MAX : (uint16_t) stack_free;
+
+        cpu_stats.start[count].handle = status[i].xHandle;
+        cpu_stats.start[count].run_time = status[i].ulRunTimeCounter;
+        count++;
+    }
+
+    vPortFree(status);
+
+    vTaskSuspendAll();
+    memcpy(cpu_stats.window, window, count * sizeof(task_monitor_cpu_t));
+    cpu_stats.window_count = count;
+    cpu_stats.window_ms = (uint32_t) (((uint64_t) elapsed * 1000u) / TASK_MONITOR_RUNTIME_COUNTER_HZ);
+    cpu_stats.start_count = count;
+    cpu_stats.start_total = total;
+    (void) xTaskResumeAll();
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_get_cpu
+ ******************************************************************************
+ * Summary:
+ *  Copies the CPU share of every task over the last completed window. With
+ *  TASK_MONITOR_INTERVAL_MS set to 0 the window is closed by this call.
+ *
+ * Parameters:
+ *  task_monitor_cpu_t *cpu : Array receiving one entry per task
+ *  uint32_t max_tasks : Number of entries in 'cpu'
+ *  uint32_t *window_ms : Length of the window in milliseconds (may be NULL)
+ *
+ * Return:
+ *  uint32_t : Number of entries written.
+ *
+ ******************************************************************************/
+uint32_t task_monitor_get_cpu(task_monitor_cpu_t *cpu, uint32_t max_tasks, uint32_t *window_ms)
+{
+    uint32_t count;
+
+#if (TASK_MONITOR_INTERVAL_MS == 0)
+    task_monitor_sample_cpu();
+#endif
+
+    vTaskSuspendAll();
+    count = (cpu_stats.window_count < max_tasks) ? cpu_stats.window_count : max_tasks;
+    memcpy(cpu, cpu_stats.window, count * sizeof(task_monitor_cpu_t));
+    if (NULL != window_ms)
+    {
+        *window_ms = cpu_stats.window_ms;
+    }
+    (void) xTaskResumeAll();
+
+    return count;
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_print_cpu
+ ******************************************************************************
+ * Summary:
+ *  Prints the CPU share of every task over the last completed window.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void task_monitor_print_cpu(void)
+{
+    task_monitor_cpu_t cpu[TASK_MONITOR_MAX_TASKS];
+    uint32_t window_ms = 0;
+    uint32_t count = task_monitor_get_cpu(cpu, TASK_MONITOR_MAX_TASKS, &window_ms);
+
+    printf("\r\n********** CPU Usage (%"PRIu32" ms) **********\r\n", window_ms);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        printf("%-*s  %3u.%u%%\r\n", (int) configMAX_TASK_NAME_LEN, cpu[i].name,
+               cpu[i].cpu_permille / 10u, cpu[i].cpu_permille % 10u);
+    }
+
+    printf("*************************************\r\n\n");
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_encode_summary
+ ******************************************************************************
+ * Summary:
+ *  Encodes the last CPU window as a compact binary summary for publishing.
+ *  All fields are little endian:
+ *   version (1), task count (1), window in ms (4), then per task:
+ *   CPU share in 1/1000 (2), lowest unused stack in bytes (2),
+ *   name length (1), name.
+ *
+ * Parameters:
+ *  uint8_t *buffer : Buffer receiving the summary
+ *  size_t size : Size of 'buffer', TASK_MONITOR_SUMMARY_MAX_SIZE always fits
+ *
+ * Return:
+ *  size_t : Length of the summary, 0 if 'buffer' is too small.
+ *
+ ******************************************************************************/
+size_t task_monitor_encode_summary(uint8_t *buffer, size_t size)
+{
+    task_monitor_cpu_t cpu[TASK_MONITOR_MAX_TASKS];
+    uint32_t window_ms = 0;
+    uint32_t count = task_monitor_get_cpu(cpu, TASK_MONITOR_MAX_TASKS, &window_ms);
+    size_t used = 6u;
+
+    if (size < used)
+    {
+        return 0;
+    }
+
+    buffer[0] = TASK_MONITOR_SUMMARY_VERSION;
+    buffer[1] = (uint8_t) count;
+    buffer[2] = (uint8_t) (window_ms);
+    buffer[3] = (uint8_t) (window_ms >> 8);
+    buffer[4] = (uint8_t) (window_ms >> 16);
+    buffer[5] = (uint8_t) (window_ms >> 24);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        size_t name_len = strlen(cpu[i].name);
+
+        if ((size - used) < (5u + name_len))
+        {
+            return 0;
+        }
+
+        buffer[used++] = (uint8_t) (cpu[i].cpu_permille);
+        buffer[used++] = (uint8_t) (cpu[i].cpu_permille >> 8);
+        buffer[used++] = (uint8_t) (cpu[i].stack_free_min);
+        buffer[used++] = (uint8_t) (cpu[i].stack_free_min >> 8);
+        buffer[used++] = (uint8_t) name_len;
+        memcpy(&buffer[used], cpu[i].name, name_len);
+        used += name_len;
+    }
+
+    return used;
+}
+
+/******************************************************************************
+ * Function Name: task_monitor_set_window_callback
+ ******************************************************************************
+ * Summary:
+ *  Registers a function that the monitor task calls each time a CPU window
+ *  completes, for example to publish task_monitor_encode_summary(). The
+ *  callback runs in the monitor task and must not block.
+ *
+ * Parameters:
+ *  task_monitor_window_callback_t callback : Function to call, NULL to remove
+ *  void *arg : Argument passed to 'callback'
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void task_monitor_set_window_callback(task_monitor_window_callback_t callback, void *arg)
+{
+    vTaskSuspendAll();
+    cpu_stats.callback = callback;
+    cpu_stats.callback_arg = arg;
+    (void) xTaskResumeAll();
+}
+
+#if (TASK_MONITOR_INTERVAL_MS > 0)
+/******************************************************************************
+ * Function Name: task_monitor_task
+ ******************************************************************************
+ * Summary:
+ *  Periodically closes the CPU window, samples the heap and checks the
+ *  stacks of all tasks.
+ *  Tasks within the stack margin and tasks above TASK_MONITOR_BUSY_PERMILLE
+ *  are always reported; the full tables are printed when PRINT_STACK_USAGE
+ *  or PRINT_CPU_USAGE is defined.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void task_monitor_task(void *pvParameters)
+{
+    task_monitor_stack_t stacks[TASK_MONITOR_MAX_TASKS];
+    const task_monitor_cpu_t *cpu = cpu_stats.window;
+    uint32_t count;
+
+    (void) pvParameters;
+
+    while (true)
+    {
+        vTaskDelay(pdMS_TO_TICKS(TASK_MONITOR_INTERVAL_MS));
+
+        task_monitor_sample_cpu();
+        heap_usage_sample();
+        if (NULL != cpu_stats.callback)
+        {
+            cpu_stats.callback(cpu_stats.callback_arg);
+        }
+
+#if defined(PRINT_CPU_USAGE)
+        task_monitor_print_cpu();
+#endif
+        /* Only this task updates the window, no copy needed. */
+        for (uint32_t i = 0; i < cpu_stats.window_count; i++)
+        {
+            if ((cpu[i].cpu_permille > TASK_MONITOR_BUSY_PERMILLE) &&
+                (0 != strcmp(cpu[i].name, configIDLE_TASK_NAME)))
+            {
+                printf("Task monitor: '%s' used %u.%u%% of the CPU, lower priority tasks are starved!\n",
+                       cpu[i].name, cpu[i].cpu_permille / 10u, cpu[i].cpu_permille % 10u);
+            }
+        }
+
+#if defined(PRINT_STACK_USAGE)
+        task_monitor_print_stacks();
+#endif
+        count = task_monitor_get_stacks(stacks, TASK_MONITOR_MAX_TASKS);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (stacks[i].low_margin)
+            {
+                printf("Task monitor: '%s' has only %"PRIu32" bytes of stack left!\n",
+                       stacks[i].name, stacks[i].stack_free_min);
+            }
+        }
+    }
+}
+#endif /* #if (TASK_MONITOR_INTERVAL_MS > 0) */
+
+/******************************************************************************
+ * Function Name: task_monitor_init
+ ******************************************************************************
+ * Summary:
+ *  Starts the periodic stack check and CPU window, unless
+ *  TASK_MONITOR_INTERVAL_MS is 0.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS on success, else a non-zero value.
+ *
+ ******************************************************************************/
+cy_rslt_t task_monitor_init(void)
+{
+#if (TASK_MONITOR_INTERVAL_MS > 0)
+    if (NULL != task_monitor_handle)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (pdPASS != xTaskCreate(task_monitor_task, "Task monitor", TASK_MONITOR_TASK_STACK_SIZE,
+                              NULL, TASK_MONITOR_TASK_PRIORITY, &task_monitor_handle))
+    {
+        printf("Task monitor: failed to create the monitor task!\n");
+        return ~CY_RSLT_SUCCESS;
+    }
+#endif /* #if (TASK_MONITOR_INTERVAL_MS > 0) */
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,143 @@
+/******************************************************************************
+* File Name:   task_monitor.h
+*
+* Description: This file contains the declarations of the task monitor, which
+*              records the stack high-water mark and the CPU share of every
+*              FreeRTOS task.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2025, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TASK_MONITOR_H_
+#define TASK_MONITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cy_result.h"
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* A task whose unused stack has dropped below this many bytes is flagged as
+ * close to overflow.
+ */
+#ifndef TASK_MONITOR_STACK_MARGIN_BYTES
+#define TASK_MONITOR_STACK_MARGIN_BYTES     (256u)
+#endif
+
+/* Period in milliseconds of the background check, which is also the window
+ * over which the CPU share of each task is measured. Set to 0 to only report
+ * on demand; the CPU window then runs from one task_monitor_get_cpu() call to
+ * the next.
+ */
+#ifndef TASK_MONITOR_INTERVAL_MS
+#define TASK_MONITOR_INTERVAL_MS            (60u * 1000u)
+#endif
+
+/* Largest number of tasks reported in one snapshot. */
+#ifndef TASK_MONITOR_MAX_TASKS
+#define TASK_MONITOR_MAX_TASKS              (12u)
+#endif
+
+/* Frequency of the free running counter behind the FreeRTOS run time stats.
+ * The counter is the low power timer on the 32.768 kHz LFCLK, which keeps
+ * counting in deep sleep so the time the idle task spends there is charged
+ * to idle. It resolves a 1 ms tick 32 times and wraps every 36.4 hours.
+ */
+#define TASK_MONITOR_RUNTIME_COUNTER_HZ     (32768u)
+
+/* Version and worst case size of the binary summary built by
+ * task_monitor_encode_summary(): a 6 byte header, then per task its CPU
+ * share, lowest unused stack, name length and name.
+ */
+#define TASK_MONITOR_SUMMARY_VERSION        (1u)
+#define TASK_MONITOR_SUMMARY_MAX_SIZE       (6u + TASK_MONITOR_MAX_TASKS * (5u + configMAX_TASK_NAME_LEN))
+
+/* A task other than the idle task that takes more than this share of a CPU
+ * window, in 1/1000, is reported as busy: it most likely never blocks and
+ * starves every task below its priority.
+ */
+#ifndef TASK_MONITOR_BUSY_PERMILLE
+#define TASK_MONITOR_BUSY_PERMILLE          (900u)
+#endif
+
+/* Task parameters for the background check task. It runs above the
+ * application tasks (priority 2), so that a task that never blocks cannot
+ * starve the monitor. Each check takes well below a millisecond.
+ */
+#define TASK_MONITOR_TASK_PRIORITY          (3)
+#define TASK_MONITOR_TASK_STACK_SIZE        (1024 * 1)
+
+/*******************************************************************************
+* Data structure and enumeration
+********************************************************************************/
+typedef struct
+{
+    const char *name;
+    uint32_t    stack_free_min;     /* Lowest unused stack so far, in bytes */
+    bool        low_margin;         /* stack_free_min is below the margin */
+} task_monitor_stack_t;
+
+typedef struct
+{
+    char        name[configMAX_TASK_NAME_LEN];
+    uint16_t    cpu_permille;       /* Share of the window, in 1/1000 */
+    uint16_t    stack_free_min;     /* Lowest unused stack so far, in bytes */
+} task_monitor_cpu_t;
+
+/* Called by the monitor task each time a CPU window completes. */
+typedef void (*task_monitor_window_callback_t)(void *arg);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+cy_rslt_t task_monitor_init(void);
+uint32_t task_monitor_get_stacks(task_monitor_stack_t *stacks, uint32_t max_stacks);
+void task_monitor_print_stacks(void);
+uint32_t task_monitor_get_cpu(task_monitor_cpu_t *cpu, uint32_t max_tasks, uint32_t *window_ms);
+void task_monitor_print_cpu(void);
+size_t task_monitor_encode_summary(uint8_t *buffer, size_t size);
+void task_monitor_set_window_callback(task_monitor_window_callback_t callback, void *arg);
+
+/* Run time stats counter, see portGET_RUN_TIME_COUNTER_VALUE in FreeRTOSConfig.h */
+void task_monitor_runtime_counter_init(void);
+uint32_t task_monitor_runtime_counter_get(void);
+
+#endif /* TASK_MONITOR_H_ */
+
+/* [] END OF FILE */